@@ -6,16 +6,41 @@
 
 #include "utils.h"
 #include "objectives.h"
+#include "dispatch.h"
 
 
-// String to objective function pointer type
-typedef std::map<std::string, simd_obj_func_t> obj_map_t;
+/**
+ * Implementations of one objective function per instruction set, nullptr where there is none.
+ */
+struct obj_impl_t {
+  obj_func_t scalar;
+  simd_obj_func_t avx2;
+  avx512_obj_func_t avx512;
+};
+
+/**
+ * Implementations of one algorithm per instruction set, nullptr where there is none.
+ */
+struct algo_impl_t {
+  algo_func_t scalar;
+  simd_algo_func_t avx2;
+  avx512_algo_func_t avx512;
+};
 
-// String to algorithm function pointer type
-typedef std::map<std::string, simd_algo_func_t> algo_map_t;
+// String to objective function implementations type
+typedef std::map<std::string, obj_impl_t> obj_map_t;
+
+// String to algorithm implementations type
+typedef std::map<std::string, algo_impl_t> algo_map_t;
+
+/**
+ * Widest instruction set, at most `max_isa`, that both `algo` and `obj` are implemented for.
+ */
+isa_t select_isa(const algo_impl_t &algo, const obj_impl_t &obj, isa_t max_isa);
 
 /**
- * Main function to run an algorithm on a function and time it.
+ * Main function to run an algorithm on a function and time it. The implementation is
+ * chosen at runtime from the instruction sets the CPU supports, see `active_isa()`.
  */
 std::vector<unsigned long long> time_algorithm(Config cfg);
 
@@ -17,6 +17,7 @@ typedef struct {
     int n_repetitions;  // repetitions for average timing
     int min_position;
     int max_position;
+    int n_threads;  // threads for multi-threaded algorithms, 0 for the default
     bool verbose;
 } Config;
 
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/**
+   Instruction sets the algorithms and objective functions are implemented for,
+   ordered from the most portable to the widest.
+ */
+typedef enum {
+  ISA_SCALAR = 0,
+  ISA_AVX2 = 1,    // AVX2 and FMA
+  ISA_AVX512 = 2   // AVX-512F
+} isa_t;
+
+/**
+   Detect the widest instruction set supported by both the CPU (cpuid) and the
+   operating system (xgetbv saves the wider registers on context switches).
+ */
+isa_t detect_isa(void);
+
+/**
+   Resolve a requested instruction set name ("scalar", "avx2" or "avx512") against
+   the `detected` one. Requests wider than `detected` are lowered to it so they can
+   never fault, unknown or missing (NULL) names keep `detected`.
+ */
+isa_t resolve_isa(const char *request, isa_t detected);
+
+/**
+   Instruction set the binary runs with: `detect_isa()`, lowered by the `FASTCODE_ISA`
+   environment variable if set. Detected once and cached.
+ */
+isa_t active_isa(void);
+
+/**
+   Human readable name of `isa`, the same names `resolve_isa` accepts.
+ */
+const char *isa_name(isa_t isa);
+
+/**
+   Size in bytes of the level `level` (1 or 2) data cache of the CPU as reported by the
+   C library, or 0 if it is unknown.
+ */
+size_t detect_cache_size(unsigned level);
+
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
@@ -5,8 +5,17 @@ extern "C" {
 #endif
 
 #include "stddef.h"
+#include "rng.h"
 #include "utils.h"
 
+/**
+   Random numbers in [0, 1) used per dimension by the update of a wolf towards the
+   alpha, towards the beta or delta, and in total.
+ */
+#define GWO_ALPHA_RANDS 5
+#define GWO_LEADER_RANDS 2
+#define GWO_WOLF_RANDS (GWO_ALPHA_RANDS + 2 * GWO_LEADER_RANDS)
+
 float * gwo_hgwosca(obj_func_t obj_func,
                      size_t wolf_count,
                      size_t dim,
@@ -18,7 +27,7 @@ float * gwo_hgwosca(obj_func_t obj_func,
    Initialise population of `wolf_count` wolves, each with `dim` dimensions, where
    each dimension is bound by `min_positions` and `max_positions`.
  */
-void gwo_init_population(float *population,
+void gwo_init_population(rng_t *rng, float *population,
                          size_t wolf_count, size_t dim,
                          float min_position, float max_position);
 
@@ -44,22 +53,25 @@ void gwo_init_fitness(float *fitness, size_t wolf_count,
 
 /**
    Get recommended position of `dimension` for `wolf` with respect to `leader`, for a given
-   value of `a`.
+   value of `a`, drawing the `GWO_LEADER_RANDS` random numbers in [0, 1) from `rands`.
    TODO: test
  */
-float gwo_get_wolf_pos_update_dim_leader(size_t dimension, float a, const float *wolf, const float *leader_pos);
+float gwo_get_wolf_pos_update_dim_leader(size_t dimension, float a, const float *wolf, const float *leader_pos,
+                                          const float *rands);
 
 /**
    Get recommended position of `dimension` for `wolf` with respect to the alpha, for a given
-   value of `a`. See equ (12) on the Hybrid paper.
+   value of `a`, drawing the `GWO_ALPHA_RANDS` random numbers in [0, 1) from `rands`.
+   See equ (12) on the Hybrid paper.
    TODO: test
  */
-float gwo_get_wolf_pos_update_dim_alpha(size_t dimension, float a, const float *wolf, const float *alpha_pos);
+float gwo_get_wolf_pos_update_dim_alpha(size_t dimension, float a, const float *wolf, const float *alpha_pos,
+                                         const float *rands);
 
 
 /**
    Update the position of `wolf` with respect to leaders `alpha`, `beta`, and `delta`, for a
-   given value of `a`.
+   given value of `a`, with the `GWO_WOLF_RANDS * dim` random numbers in `rands`.
    TODO: test
  */
 void gwo_update_wolf_position(size_t dim,
@@ -67,13 +79,15 @@ void gwo_update_wolf_position(size_t dim,
                               float *wolf,
                               const float *alpha_pos,
                               const float *beta_pos,
-                              const float *delta_pos);
+                              const float *delta_pos,
+                              const float *rands);
 
 /**
    Update the positions of all wolves.
    TODO: test
  */
-void gwo_update_all_positions(size_t wolf_count,
+void gwo_update_all_positions(rng_t *rng,
+                              size_t wolf_count,
                               size_t dim,
                               float a,
                               float *population,
@@ -93,6 +107,52 @@ void gwo_clamp_all_positions(size_t wolf_count, size_t dim, float *population,
 
 size_t gwo_get_fittest_idx(size_t colony_size, const float *fitness);
 
+/**
+   Same as `gwo_update_wolf_position` on AVX2 for a wolf of `simd_dim` vectors, 8 dimensions
+   at a time. The random numbers are planar, draw `k` of the dimensions of vector `idx` is at
+   `rands[(k * simd_dim + idx) * 8]`, `GWO_WOLF_RANDS * simd_dim * 8` in total.
+ */
+void gwo_simd_update_wolf_position(size_t simd_dim,
+                                   float a,
+                                   __m256 *wolf,
+                                   const __m256 *alpha_pos,
+                                   const __m256 *beta_pos,
+                                   const __m256 *delta_pos,
+                                   const float *rands);
+
+/**
+   Hybrid Grey Wolf Optimiser with Sine Cosine Algorithm on AVX2 and `n_threads` threads,
+   0 uses the OpenMP default.
+ */
+float *gwo_hgwosca_parallel(simd_obj_func_t obj_func,
+                            size_t wolf_count,
+                            size_t dim,
+                            size_t max_iterations,
+                            float min_position,
+                            float max_position,
+                            size_t n_threads);
+
+/**
+   Hybrid Grey Wolf Optimiser with Sine Cosine Algorithm on AVX2, single threaded.
+ */
+float *gwo_hgwosca_simd(simd_obj_func_t obj_func,
+                        size_t wolf_count,
+                        size_t dim,
+                        size_t max_iterations,
+                        float min_position,
+                        float max_position);
+
+/**
+   Hybrid Grey Wolf Optimiser with Sine Cosine Algorithm on AVX2 and the default number of
+   threads.
+ */
+float *gwo_hgwosca_simd_mt(simd_obj_func_t obj_func,
+                           size_t wolf_count,
+                           size_t dim,
+                           size_t max_iterations,
+                           float min_position,
+                           float max_position);
+
 #ifdef __cplusplus
 }
 #endif // __cplusplus
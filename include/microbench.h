@@ -0,0 +1,57 @@
+#pragma once
+
+#include <string>
+#include <map>
+#include <ostream>
+
+
+/**
+ * A micro benchmark times one kernel over a sweep of its parameters and writes one
+ * CSV row per measurement (header first) to `out`, keeping the fastest of
+ * `n_repetitions` runs.
+ */
+typedef void (*microbench_func_t)(std::ostream &out, int n_repetitions);
+
+// String to micro benchmark function pointer type
+typedef std::map<std::string, microbench_func_t> microbench_map_t;
+
+/**
+ * Builds up the mapping of identifier (used on the command line) to micro benchmark.
+ */
+microbench_map_t create_microbench_map();
+
+/**
+ * Separate position / velocity / local best arrays against the interleaved AoSoA layout
+ * for several block sizes, on swarms from L2 sized to larger than the LLC.
+ */
+void bench_pso_layout(std::ostream &out, int n_repetitions);
+
+/**
+ * Whole particle passes against the dimension tiled update of `update_everything_tiled`
+ * for fixed tile sizes and the one picked from the detected caches, from L1 sized to
+ * L2 exceeding particles.
+ */
+void bench_pso_tiling(std::ostream &out, int n_repetitions);
+
+/**
+ * Generic update calling the objective through a pointer after the move against the
+ * objective specialised update of `pso_fused_update`.
+ */
+void bench_pso_fused(std::ostream &out, int n_repetitions);
+
+/**
+ * Random vectors per cycle of the xorshift streams drawing from 1, 2 or 4 chains in turn
+ * and of the Philox counters.
+ */
+void bench_rng(std::ostream &out, int n_repetitions);
+
+/**
+ * Elements per cycle of the vector math of simd_math.h against the scalar libm functions.
+ */
+void bench_simd_math(std::ostream &out, int n_repetitions);
+
+/**
+ * Objectives accumulating into 1, 4 or 8 independent vectors, and whether that is the
+ * number `opt_simd_unroll_factor` picked, from L1 sized to L2 exceeding particles.
+ */
+void bench_unroll(std::ostream &out, int n_repetitions);
@@ -7,19 +7,21 @@ extern "C" {
 #include <stdlib.h>
 #include <immintrin.h>
 
+#include "utils.h"
+
 
 /*******************************************************************************
   OBJECTIVE FUNCTIONS PROTOTYPES
 ******************************************************************************/
 
-void init_obj_globals();
-
 float sum_of_squares (const float * args, size_t dim);
 
 float simd_sum_of_squares (const float * args, size_t dim);
 
 float opt_simd_sum_of_squares(const __m256* args, size_t dim);
 
+float opt_avx512_sum_of_squares(const __m512* args, size_t dim);
+
 float sum            (const float * args, size_t dim);
 
 float sum_negative   (const float * args, size_t dim);
@@ -32,6 +34,123 @@ float simd_rosenbrock(const float *const args, size_t dim);
 
 float opt_simd_rosenbrock(const __m256* args, size_t dim);
 
+float opt_avx512_rosenbrock(const __m512* args, size_t dim);
+
+/*******************************************************************************
+  CROSS-PARTICLE OBJECTIVE FUNCTIONS, ONE PARTICLE PER LANE
+******************************************************************************/
+
+void opt_simd_sum_of_squares_lanes(const __m256* lanes, size_t dim, float* fitness);
+
+void opt_simd_rosenbrock_lanes(const __m256* lanes, size_t dim, float* fitness);
+
+void opt_simd_rastigrin_lanes(const __m256* lanes, size_t dim, float* fitness);
+
+void opt_simd_griewank_lanes(const __m256* lanes, size_t dim, float* fitness);
+
+/**
+   Cross-particle variant of the `opt_simd_*` objective function `obj_func`, or NULL if
+   there is none.
+ */
+simd_lanes_obj_func_t opt_simd_lanes_variant(simd_obj_func_t obj_func);
+
+/*******************************************************************************
+  PARTIAL OBJECTIVE FUNCTIONS, TERMS STARTING IN A RANGE OF VECTORS
+******************************************************************************/
+
+__m256 opt_simd_sum_of_squares_tile(const __m256* args, size_t begin, size_t end, size_t dim);
+
+__m256 opt_simd_rosenbrock_tile(const __m256* args, size_t begin, size_t end, size_t dim);
+
+/**
+   Partial variant of the `opt_simd_*` objective function `obj_func`, or NULL if there
+   is none. Summing it over consecutive ranges covering all vectors gives `obj_func`.
+ */
+simd_tile_obj_func_t opt_simd_tile_variant(simd_obj_func_t obj_func);
+
+/*******************************************************************************
+  UNROLLED OBJECTIVE FUNCTIONS, INDEPENDENT ACCUMULATORS
+******************************************************************************/
+
+float opt_simd_sum_of_squares_x4(const __m256* args, size_t dim);
+
+float opt_simd_sum_of_squares_x8(const __m256* args, size_t dim);
+
+float opt_simd_rosenbrock_x4(const __m256* args, size_t dim);
+
+float opt_simd_rosenbrock_x8(const __m256* args, size_t dim);
+
+/**
+   Variant of the `opt_simd_*` objective function `obj_func` with `unroll` (4 or 8)
+   independent accumulators, or `obj_func` itself for any other `unroll` or if there is
+   no such variant.
+ */
+simd_obj_func_t opt_simd_unrolled(simd_obj_func_t obj_func, size_t unroll);
+
+/**
+   Measure the number of accumulators every objective with unrolled variants runs fastest
+   with, once per process; later calls return at once. Thread safe, and called by
+   `opt_simd_unroll_factor` on first use, call it up front to keep the measurement out of
+   timed code.
+ */
+void opt_simd_tune_unroll(void);
+
+/**
+   Number of accumulators (1, 4 or 8) the objective `obj_func` of `dim` dimensions runs
+   fastest with, 1 if it has no unrolled variants. It is measured once per objective and
+   range of dimensions, see `opt_simd_tune_unroll`, the `FASTCODE_UNROLL` environment
+   variable (1, 4 or 8) overrides it for all of them.
+ */
+size_t opt_simd_unroll_factor(simd_obj_func_t obj_func, size_t dim);
+
+/**
+   `opt_simd_unrolled(obj_func, opt_simd_unroll_factor(obj_func, dim))`.
+ */
+simd_obj_func_t opt_simd_unroll_variant(simd_obj_func_t obj_func, size_t dim);
+
+/*******************************************************************************
+  DIMENSION SPECIALISED OBJECTIVE FUNCTIONS, FOR DIM 8, 16, 32, 64 AND 128
+******************************************************************************/
+
+/**
+   `opt_simd_*` objective function `obj_func` specialised on `dim`, fully unrolled with
+   independent accumulators, or `opt_simd_unroll_variant(obj_func, dim)` if there is no
+   specialisation for `dim`.
+ */
+simd_obj_func_t opt_simd_dim_variant(simd_obj_func_t obj_func, size_t dim);
+
+/*******************************************************************************
+  BATCHED OBJECTIVE FUNCTIONS, MANY CANDIDATES PER CALL
+******************************************************************************/
+
+void opt_simd_sum_of_squares_batch(const float* positions, size_t count, size_t dim, float* fitness);
+
+void opt_simd_rosenbrock_batch(const float* positions, size_t count, size_t dim, float* fitness);
+
+void opt_simd_rastigrin_batch(const float* positions, size_t count, size_t dim, float* fitness);
+
+void opt_simd_griewank_batch(const float* positions, size_t count, size_t dim, float* fitness);
+
+/**
+   AVX2 batched variant of the scalar objective function `obj_func`, or NULL if there is
+   none. It evaluates 8 candidates per pass, one per lane.
+ */
+batch_obj_func_t opt_simd_batch_variant(obj_func_t obj_func);
+
+/**
+   Batched variant of the scalar objective function `obj_func` for the instruction set
+   the binary runs with, or NULL if there is none.
+ */
+batch_obj_func_t batch_variant(obj_func_t obj_func);
+
+/**
+   Evaluate `obj_func` on the `count` candidates of `positions`, rows of `dim` floats,
+   and store the results in `fitness`. Uses `batch_variant(obj_func)` if there is one,
+   and calls `obj_func` once per candidate otherwise.
+ */
+void obj_eval_batch(obj_func_t obj_func, const float* positions, size_t count, size_t dim,
+                    float* fitness);
+
 float sphere         (const float * args, size_t dim);
 
 float egghol2d       (const float * args, size_t dim);
@@ -48,6 +167,31 @@ float freundsteinroth(const float * args, size_t dim);
 
 float beale          (const float * args, size_t dim);
 
+/*******************************************************************************
+  AVX2 VERSIONS OF THE OTHER OBJECTIVE FUNCTIONS, ON PADDED ROWS
+******************************************************************************/
+
+float opt_simd_rastigrin(const __m256* args, size_t dim);
+
+float opt_simd_sphere(const __m256* args, size_t dim);
+
+float opt_simd_griewank(const __m256* args, size_t dim);
+
+float opt_simd_schwefel01(const __m256* args, size_t dim);
+
+/**
+   The fixed dimension functions only read the first vector, `dim` is ignored.
+ */
+float opt_simd_powel(const __m256* args, size_t dim);
+
+float opt_simd_freundsteinroth(const __m256* args, size_t dim);
+
+float opt_simd_beale(const __m256* args, size_t dim);
+
+float opt_simd_egghol2d(const __m256* args, size_t dim);
+
+float opt_simd_schaf2d(const __m256* args, size_t dim);
+
 /*******************************************************************************
   UTILITIES
 ******************************************************************************/
@@ -4,6 +4,7 @@
 extern "C" {
 #endif
 
+#include "rng.h"
 #include "utils.h"
 
 
@@ -62,21 +63,45 @@ float *pen_emperor_penguin(obj_func_t obj_func,
                             const float min_position,
                             const float max_position);
 
+/**
+   Same as `pen_emperor_penguin` on `n_threads` threads, 0 uses the OpenMP default. Every
+   thread moves its share of the penguins with its own random stream and scratch, so the
+   result depends on the number of threads but is reproducible for a given one.
+ */
+float *pen_emperor_penguin_parallel(obj_func_t obj_func,
+                                    size_t colony_size,
+                                    size_t dim,
+                                    size_t max_iterations,
+                                    const float min_position,
+                                    const float max_position,
+                                    size_t n_threads);
+
+/**
+   Same as `pen_emperor_penguin` on the default number of threads.
+ */
+float *pen_emperor_penguin_mt(obj_func_t obj_func,
+                              size_t colony_size,
+                              size_t dim,
+                              size_t max_iterations,
+                              const float min_position,
+                              const float max_position);
+
 /**
    Generate a full random penguin population of size `colony_size`,
    where each penguin has `dim` dimensions. The minimal and maximal
    values these dimensions can take are bound by `min_positions` and
    `max_positions`.
  */
-void pen_initialise_population(float* population,
+void pen_initialise_population(rng_t *rng,
+                               float* population,
                                size_t colony_size,
                                size_t dim,
                                const float min_position,
                                const float max_position);
 
 /**
-   Get the initial fitness values for each penguin in the population. This will
-   generate a new fitness array.
+   Get the fitness values for each penguin in the population with one batched
+   objective call, see `obj_eval_batch`. This overwrites the fitness array.
  */
 void pen_update_fitness(float* fitness,
                         size_t colony_size,
@@ -108,6 +133,43 @@ float pen_attractiveness(float heat_rad,
                           const float * penguin_j,
                           float attenuation_coef);
 
+/**
+   Attractiveness of all pairs of penguins, `attract` (`colony_size` times `colony_size`)
+   holds in row `i` and column `j` the same as `pen_attractiveness` of `penguin_i` and
+   `penguin_j`. The distances are one Gram matrix product, `population_t` is scratch of
+   `dim` times `colony_size` floats for it. Runs `pen_attractiveness_matrix_simd` if the
+   active instruction set has AVX2 and `pen_attractiveness_matrix_scalar` otherwise.
+ */
+void pen_attractiveness_matrix(float* attract,
+                               size_t colony_size,
+                               size_t dim,
+                               const float* population,
+                               float* population_t,
+                               float heat_rad,
+                               float attenuation_coef);
+
+/**
+   `pen_attractiveness_matrix` with the distances and exponentials of the baseline ISA.
+ */
+void pen_attractiveness_matrix_scalar(float* attract,
+                                      size_t colony_size,
+                                      size_t dim,
+                                      const float* population,
+                                      float* population_t,
+                                      float heat_rad,
+                                      float attenuation_coef);
+
+/**
+   `pen_attractiveness_matrix` with the distances and exponentials on AVX2.
+ */
+void pen_attractiveness_matrix_simd(float* attract,
+                                    size_t colony_size,
+                                    size_t dim,
+                                    const float* population,
+                                    float* population_t,
+                                    float heat_rad,
+                                    float attenuation_coef);
+
 /**
    Compute spiral movement of the penguin towards the centre. See paper on SPO for
    clarification.
@@ -116,17 +178,39 @@ void pen_get_spiral_like_movement(float* spiral, float attract, size_t dim,
                                   const float * centre, const float * penguin,
                                   const float* rotation_matrix);
 
+/**
+   Rotate every penguin of the population with one matrix matrix multiplication,
+   `rotated` = `population` times the transposed rotation matrix `rotation_t`.
+ */
+void pen_rotate_population(float* rotated, size_t colony_size, size_t dim,
+                           const float * population, const float * rotation_t);
+
+/**
+   Same as `pen_get_spiral_like_movement` on penguins rotated with `pen_rotate_population`.
+ */
+void pen_get_rotated_spiral_movement(float* spiral, float attract, size_t dim,
+                                     const float * rotated_centre,
+                                     const float * rotated_penguin);
+
+/**
+   Set `position` to the mean of the `n_updates` moves of a penguin, given their sum
+   `position_sum`.
+ */
+void pen_mean_position(float* position, size_t dim, const float* position_sum,
+                       size_t n_updates);
+
 /**
    Initialise the rotation matrix of size `dim` times `dim`. Its rotation rate is given by
-   `theta` (between -pi and pi).
+   `theta` (between -pi and pi). The rotation is cached on disk per dimension, `theta` and
+   precision in `FASTCODE_CACHE_DIR` (default `~/.cache/fastcode`, empty to disable).
  */
 void  pen_init_rotation_matrix(float* matrix, size_t dim, const float theta);
 
 /**
    Mutates the spiral according the equation 19 from the paper. This modifies the spiral
-   in place.
+   in place, `noise` is scratch of `dim` floats.
  */
-void pen_mutate(size_t dim, float * spiral, float mutation_coef);
+void pen_mutate(rng_t *rng, size_t dim, float * spiral, float mutation_coef, float * noise);
 
 /**
    Clamps the solution in the possible range. This is done in place.
@@ -135,6 +219,22 @@ void pen_clamp_position(size_t dim, float * position,
                         const float min_position,
                         const float max_position);
 
+/**
+   A penguin and its fitness, for ranking the colony.
+ */
+typedef struct {
+  float fitness;
+  size_t idx;
+} pen_rank_t;
+
+/**
+   Sort the colony by ascending fitness (best first) into `ranks`. Sets `n_better` of every
+   rank to the count of penguins with strictly lower fitness, the prefix of `ranks` the
+   penguin moves towards. NaN fitness is ranked last and has no better penguins.
+ */
+void pen_rank_colony(pen_rank_t* ranks, size_t* n_better, size_t colony_size,
+                     const float* fitness);
+
 /**
    Gets the index of the fittest penguin in the population. Note that the less fit, the better.
  */
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <stdint.h>
+
 #include "utils.h"
 
 #ifdef __cplusplus
@@ -7,51 +9,155 @@ extern "C" {
 #endif
 
 
+// Independent xorshift chains of one RNG stream
+#define SIMD_RNG_CHAINS 4
+
+// Coefficients of the velocity update and velocity limit, shared by every PSO engine
+#define COG 0.5
+#define SOCIAL .9
+#define INERTIA 0.5
+#define VEL_LIMIT_SCALE 5
+
 /**
-   Seed a parallel floating point RNG.
+   State of one parallel floating point RNG stream. Every thread draws from its own
+   stream; the alignment keeps streams of different threads on separate cache lines.
+   A stream is made of `SIMD_RNG_CHAINS` independent xorshift chains, drawing from them
+   in turn hides the latency of a single chain.
  */
-void seed_simd_rng();
+typedef struct {
+  __m256i state[SIMD_RNG_CHAINS];
+} __attribute__((aligned(64))) simd_rng_t;
 
 /**
-   Generate a vector of random floats between `min` and `max`.
+   Seed `n_streams` independent parallel floating point RNG streams.
  */
-inline __m256 simd_rand_min_max();
+void seed_simd_rng(simd_rng_t *streams, size_t n_streams, size_t seed);
 
+/**
+   Fill `out` with `n_vectors` vectors of random floats between 0 and 1, drawing from the
+   first `n_chains` (1, 2 or 4) chains of `rng` in turn. With 1 this is `n_vectors` calls
+   of `simd_rand_0_to_1`.
+ */
+void simd_rand_fill(simd_rng_t *rng, __m256 *out, size_t n_vectors, size_t n_chains);
 
 /**
-   Initialise velocity bounds for later use.
+   Fill `out` with `n_vectors` vectors of random floats between 0 and 1 from the Philox
+   counters `counter` to `counter + n_vectors / 4` keyed by `seed`.
  */
-void initialise_velocity_bounds(float min_vel, float max_vel);
+void simd_philox_fill(uint64_t seed, uint64_t counter, __m256 *out, size_t n_vectors);
 
+/**
+   Velocity and position bounds of a solve, broadcast to all lanes.
+ */
+typedef struct {
+  __m256 min_vel;
+  __m256 max_vel;
+  __m256 min_pos;
+  __m256 max_pos;
+} pso_bounds_t;
 
 /**
-    Initialise position bounds for later use.
+   Initialise velocity bounds for later use.
  */
-void initialise_position_bounds(float min_position, float max_position);
+void initialise_velocity_bounds(pso_bounds_t *bounds, float min_vel, float max_vel);
+
 
 /**
-    Generate a vector of random floats between 0 and 1.
+    Initialise position bounds for later use.
  */
-inline __m256 simd_rand_0_to_1();
+void initialise_position_bounds(pso_bounds_t *bounds, float min_position, float max_position);
 
 /**
     Initialise an array to random numbers between `min` and `max`.
 
     Arguments:
+      rng     the random stream to draw from
+      bounds  the position bounds `min` and `max`
       array   the array to randomly initialise
       length  the length of the array to initialise
 */
-void pso_rand_init(__m256 *const array, size_t length);
+void pso_rand_init(simd_rng_t *rng, const pso_bounds_t *bounds,
+                   __m256 *const array, size_t length);
 
 void update_everything(__m256 *velocity, __m256 *positions,
                        __m256 *local_best_positions,
                        __m256 *global_best_position,
                        float *current_fitness, float* local_best_fitness,
-                       simd_obj_func_t obj_func, size_t swarm_size, size_t simd_dim);
+                       simd_obj_func_t obj_func, const pso_bounds_t *bounds,
+                       simd_rng_t *rng, size_t swarm_size, size_t dim);
+
+/**
+   Transpose the positions of `n_particles` (at most 8) consecutive particles into
+   `lanes`, such that vector `d` of `lanes` holds dimension `d` of every particle. The
+   lanes of missing particles are zero.
+
+   Arguments:
+     positions    position array of the first particle of the block
+     n_particles  number of particles in the block
+     simd_dim     dimension of a particle in terms of __m256
+     lanes        `8 * simd_dim` vectors where to store the result
+ */
+void pso_transpose_block(const __m256 *positions, size_t n_particles, size_t simd_dim,
+                         __m256 *lanes);
+
+/**
+   Same as `update_everything`, but evaluates the fitness of 8 particles per call of
+   `lanes_obj_func`, on their positions transposed into the scratch array `lanes`
+   (`8 * simd_dim` vectors). Saves a call and a horizontal reduction per particle.
+ */
+void update_everything_lanes(__m256 *velocity, __m256 *positions,
+                             __m256 *local_best_positions,
+                             __m256 *global_best_position,
+                             float *current_fitness, float* local_best_fitness,
+                             simd_lanes_obj_func_t lanes_obj_func, const pso_bounds_t *bounds,
+                             simd_rng_t *rng, size_t swarm_size, size_t dim,
+                             __m256 *lanes);
+
+/**
+   Same as `update_everything`, but the random factors of particle `first_particle + i`
+   in iteration `iteration` are drawn from Philox counters keyed by `seed`, see
+   `pso_move_vectors_counter`. The swarm moves the same no matter how it is split.
+ */
+void update_everything_counter(__m256 *velocity, __m256 *positions,
+                               __m256 *local_best_positions,
+                               __m256 *global_best_position,
+                               float *current_fitness, float* local_best_fitness,
+                               simd_obj_func_t obj_func, const pso_bounds_t *bounds,
+                               uint64_t seed, size_t iteration, size_t first_particle,
+                               size_t swarm_size, size_t dim);
+
+/**
+   Dimension from which `pso_parallel` switches to `update_everything_tiled`, below it a
+   whole particle fits into L1.
+ */
+#define PSO_TILED_MIN_DIM 4096
+
+/**
+   Number of vectors per tile of `update_everything_tiled` such that the tiles of the
+   velocity, position, local best and global best fit into a quarter of a `l1_size`
+   bytes L1 cache. Falls back to a part of `l2_size` and then to a 32KB L1 if the sizes are
+   unknown (0). Always a positive multiple of 8.
+ */
+size_t pso_tile_vectors(size_t l1_size, size_t l2_size);
+
+/**
+   Same as `update_everything`, but every particle is processed in tiles of
+   `tile_vectors` vectors: each tile is moved and its objective terms are accumulated
+   with `tile_obj_func` while it is still in L1, instead of one pass over the whole
+   particle for the velocity, the position and the objective each.
+ */
+void update_everything_tiled(__m256 *velocity, __m256 *positions,
+                             __m256 *local_best_positions,
+                             __m256 *global_best_position,
+                             float *current_fitness, float* local_best_fitness,
+                             simd_tile_obj_func_t tile_obj_func, const pso_bounds_t *bounds,
+                             simd_rng_t *rng, size_t swarm_size, size_t dim,
+                             size_t tile_vectors);
 
 /**
    Evaluate fitness of `positions` according to `obj_func` and store the result
-   in `fitness`.
+   in `fitness`. Blocks of 8 particles are evaluated with one call of
+   `opt_simd_lanes_variant(obj_func)` if there is such a variant.
 
     Arguments:
      obj_func   objective function with which to compute the fitness
@@ -68,12 +174,15 @@ void pso_eval_fitness(simd_obj_func_t obj_func,
    Randomly generate initial velocity for all particles.
 
    Arguments:
+     rng           the random stream to draw from
+     bounds        the position bounds
      velocity      array where to store the result
      positions     position array of the particles
      swarm_size    number of particles for which to compute the initial velocity
      dim           dimension of the position of each particle
  */
-void pso_gen_init_velocity(__m256 *const velocity, const __m256 *positions,
+void pso_gen_init_velocity(simd_rng_t *rng, const pso_bounds_t *bounds,
+                           __m256 *const velocity, const __m256 *positions,
                            size_t swarm_size, size_t dim);
 
 /**
@@ -88,6 +197,127 @@ void pso_gen_init_velocity(__m256 *const velocity, const __m256 *positions,
  */
 size_t pso_best_fitness(float *fitness, size_t swarm_size);
 
+/**
+   Returns the number of threads `pso_parallel` uses when asked for 0 threads.
+ */
+size_t pso_default_num_threads();
+
+struct pso_ctx;
+
+/**
+   Move, evaluate and update the local best of the `count` particles of `ctx` starting at
+   `begin`, drawing from `rng`. Replaces the `update_everything` variants in `pso_step`.
+ */
+typedef void (*pso_update_func_t)(struct pso_ctx *ctx, size_t begin, size_t count,
+                                  simd_rng_t *rng);
+
+/**
+   State of one PSO solve. Nothing is shared between contexts, so independent solves
+   can run concurrently in one process.
+ */
+typedef struct pso_ctx {
+  simd_obj_func_t obj_func;              // objective specialised on dim, see opt_simd_dim_variant
+  pso_update_func_t update_func;         // specialised update of the swarm, or NULL
+  simd_lanes_obj_func_t lanes_obj_func;  // cross-particle variant of obj_func, or NULL
+  simd_tile_obj_func_t tile_obj_func;    // partial variant of obj_func, or NULL
+  size_t tile_vectors;          // tile size of tile_obj_func in vectors
+  size_t swarm_size;
+  size_t dim;
+  size_t simd_dim;
+  size_t n_threads;
+  size_t iteration;             // iterations run so far
+  uint64_t seed;
+  int counter_rng;              // draw from Philox counters instead of `rngs`
+
+  pso_bounds_t bounds;
+  simd_rng_t *rngs;             // one random stream per thread
+
+  __m256 *positions;
+  __m256 *velocity;
+  __m256 *local_best_positions;
+  __m256 *global_best_position;
+  float *current_fitness;
+  float *local_best_fitness;
+
+  size_t global_best_idx;
+  size_t *slice_best_idx;       // best particle of every thread's slice
+} pso_ctx_t;
+
+/**
+   Create a PSO solve on `n_threads` threads (0 for the default) and evaluate its
+   random initial swarm. Any `dim` and `swarm_size` work, every particle is padded to
+   whole vectors with zeros the objective functions ignore. The fitness is computed with
+   `opt_simd_dim_variant(obj_func, dim)`.
+ */
+pso_ctx_t *pso_create(simd_obj_func_t obj_func,
+                      size_t swarm_size,
+                      size_t dim,
+                      const float min_position,
+                      const float max_position,
+                      size_t n_threads,
+                      size_t seed);
+
+/**
+   Run `n_iter` iterations of the solve.
+ */
+void pso_step(pso_ctx_t *ctx, size_t n_iter);
+
+/**
+   Evaluate the fitness of 8 particles at a time with `lanes_obj_func` in `pso_step`,
+   which must compute the same objective as `ctx->obj_func`. NULL goes back to one
+   particle at a time.
+ */
+void pso_use_lanes_objective(pso_ctx_t *ctx, simd_lanes_obj_func_t lanes_obj_func);
+
+/**
+   Draw the random factors of `pso_step` from Philox counters keyed by the seed, the
+   iteration, the particle and the dimension (`enable` non zero) instead of one xorshift
+   stream per thread. The solve then gives bit-identical results on any number of
+   threads, at the price of a slower generator. It takes precedence over the other
+   updates, the objective is evaluated one particle at a time. The initial swarm does
+   not depend on the thread count either way.
+ */
+void pso_use_counter_rng(pso_ctx_t *ctx, int enable);
+
+/**
+   Move and evaluate the particles with `update_func` in `pso_step`, which must compute
+   the same objective as `ctx->obj_func`. It takes precedence over the cross-particle and
+   the tiled objectives. NULL goes back to those.
+ */
+void pso_use_update(pso_ctx_t *ctx, pso_update_func_t update_func);
+
+/**
+   Move and evaluate the particles in tiles of `tile_vectors` vectors with
+   `tile_obj_func` in `pso_step`, which must sum up to `ctx->obj_func`. A `tile_vectors`
+   of 0 picks the tile size from the detected cache sizes. NULL goes back to whole
+   particles. The cross-particle objective takes precedence if both are set.
+ */
+void pso_use_tiled_objective(pso_ctx_t *ctx, simd_tile_obj_func_t tile_obj_func,
+                             size_t tile_vectors);
+
+/**
+   Copy the best position found so far into `solution` (`dim` floats) and return its
+   objective value.
+ */
+float pso_result(const pso_ctx_t *ctx, float *solution);
+
+/**
+   Release all memory held by `ctx`.
+ */
+void pso_destroy(pso_ctx_t *ctx);
+
+/**
+   PSO algorithm running the swarm on `n_threads` threads (0 for the default).
+   Each thread owns a contiguous slice of the swarm and its own RNG stream. From
+   `PSO_TILED_MIN_DIM` dimensions on particles are processed in cache sized tiles.
+ */
+float *pso_parallel(simd_obj_func_t obj_func,
+                    size_t swarm_size,
+                    size_t dim, size_t max_iter,
+                    const float min_position,
+                    const float max_position,
+                    size_t n_threads);
+
 /**
    PSO algorithm.
  */
@@ -97,6 +327,35 @@ float *pso_basic(simd_obj_func_t obj_func,
                  const float min_position,
                  const float max_position);
 
+/**
+   PSO algorithm using `pso_default_num_threads()` threads.
+ */
+float *pso_basic_mt(simd_obj_func_t obj_func,
+                    size_t swarm_size,
+                    size_t dim, size_t max_iter,
+                    const float min_position,
+                    const float max_position);
+
+/**
+   PSO algorithm using `pso_default_num_threads()` threads with counter based random
+   draws, giving the same solution on any number of threads.
+ */
+float *pso_basic_mt_counter(simd_obj_func_t obj_func,
+                            size_t swarm_size,
+                            size_t dim, size_t max_iter,
+                            const float min_position,
+                            const float max_position);
+
+/**
+   Single threaded PSO algorithm evaluating the fitness of 8 particles at a time with
+   `opt_simd_lanes_variant(obj_func)`, or one at a time if there is no such variant.
+ */
+float *pso_basic_x8(simd_obj_func_t obj_func,
+                    size_t swarm_size,
+                    size_t dim, size_t max_iter,
+                    const float min_position,
+                    const float max_position);
+
 #ifdef __cplusplus
 }
 #endif
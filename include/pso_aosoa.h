@@ -0,0 +1,98 @@
+#pragma once
+
+#include "pso.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Default number of __m256 per block of the interleaved layout
+#define PSO_AOSOA_DEFAULT_BLOCK 8
+
+
+/**
+   State of one PSO solve with interleaved (AoSoA) particle storage. Every particle owns
+   `3 * simd_dim` consecutive vectors, split into blocks of `block_size` vectors of its
+   position, then its velocity, then its local best position:
+
+     | pos 0..B-1 | vel 0..B-1 | best 0..B-1 | pos B..2B-1 | vel B..2B-1 | best B..2B-1 | ...
+
+   The last block of a particle holds the remaining `simd_dim % block_size` vectors of each.
+   Updating a particle streams through one region of memory instead of three.
+ */
+typedef struct {
+  simd_obj_func_t obj_func;
+  size_t swarm_size;
+  size_t dim;
+  size_t simd_dim;
+  size_t block_size;            // vectors per block
+  size_t n_threads;
+  size_t iteration;             // iterations run so far
+
+  pso_bounds_t bounds;
+  simd_rng_t *rngs;             // one random stream per thread
+
+  __m256 *particles;            // swarm_size * 3 * simd_dim vectors
+  __m256 *global_best_position;
+  __m256 *scratch;              // contiguous position of the current particle, per thread
+  size_t scratch_stride;        // vectors between the scratch rows of two threads
+  float *current_fitness;
+  float *local_best_fitness;
+
+  size_t global_best_idx;
+  size_t *slice_best_idx;       // best particle of every thread's slice
+} pso_aosoa_ctx_t;
+
+/**
+   Create a PSO solve with interleaved storage in blocks of `block_size` vectors
+   (0 for `PSO_AOSOA_DEFAULT_BLOCK`) on `n_threads` threads (0 for the default).
+ */
+pso_aosoa_ctx_t *pso_aosoa_create(simd_obj_func_t obj_func,
+                                  size_t swarm_size,
+                                  size_t dim,
+                                  const float min_position,
+                                  const float max_position,
+                                  size_t block_size,
+                                  size_t n_threads,
+                                  size_t seed);
+
+/**
+   Run `n_iter` iterations of the solve.
+ */
+void pso_aosoa_step(pso_aosoa_ctx_t *ctx, size_t n_iter);
+
+/**
+   Copy the best position found so far into `solution` (`dim` floats) and return its
+   objective value.
+ */
+float pso_aosoa_result(const pso_aosoa_ctx_t *ctx, float *solution);
+
+/**
+   Release all memory held by `ctx`.
+ */
+void pso_aosoa_destroy(pso_aosoa_ctx_t *ctx);
+
+/**
+   PSO algorithm with interleaved storage in blocks of `block_size` vectors running the
+   swarm on `n_threads` threads.
+ */
+float *pso_parallel_aosoa(simd_obj_func_t obj_func,
+                          size_t swarm_size,
+                          size_t dim, size_t max_iter,
+                          const float min_position,
+                          const float max_position,
+                          size_t block_size,
+                          size_t n_threads);
+
+/**
+   Single threaded PSO algorithm with interleaved storage in the default block size.
+ */
+float *pso_basic_aosoa(simd_obj_func_t obj_func,
+                       size_t swarm_size,
+                       size_t dim, size_t max_iter,
+                       const float min_position,
+                       const float max_position);
+
+#ifdef __cplusplus
+}
+#endif
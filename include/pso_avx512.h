@@ -0,0 +1,133 @@
+#pragma once
+
+#include "utils.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/**
+   State of one 16 lane floating point RNG stream, one per thread.
+ */
+typedef struct {
+  __m512i state;
+} __attribute__((aligned(64))) simd512_rng_t;
+
+/**
+   Velocity and position bounds of a solve, broadcast to all 16 lanes.
+ */
+typedef struct {
+  __m512 min_vel;
+  __m512 max_vel;
+  __m512 min_pos;
+  __m512 max_pos;
+} pso512_bounds_t;
+
+/**
+   Seed `n_streams` independent 16 lane RNG streams.
+ */
+void seed_simd512_rng(simd512_rng_t *streams, size_t n_streams, size_t seed);
+
+/**
+   Initialise an array of `length` vectors to random numbers between the position bounds.
+ */
+void pso512_rand_init(simd512_rng_t *rng, const pso512_bounds_t *bounds,
+                      __m512 *array, size_t length);
+
+/**
+   Update the velocity, positions, local best positions and fitness of `swarm_size`
+   particles of `dim` floats each, padded to whole vectors. Bounds are enforced with
+   mask registers.
+ */
+void pso512_update_everything(__m512 *velocity, __m512 *positions,
+                              __m512 *local_best_positions,
+                              const __m512 *global_best_position,
+                              float *current_fitness, float *local_best_fitness,
+                              avx512_obj_func_t obj_func, const pso512_bounds_t *bounds,
+                              simd512_rng_t *rng, size_t swarm_size, size_t dim);
+
+/**
+   State of one AVX-512 PSO solve, the 16 lane counterpart of `pso_ctx_t`.
+ */
+typedef struct {
+  avx512_obj_func_t obj_func;
+  size_t swarm_size;
+  size_t dim;
+  size_t simd_dim;
+  size_t n_threads;
+  size_t iteration;
+
+  pso512_bounds_t bounds;
+  simd512_rng_t *rngs;
+
+  __m512 *positions;
+  __m512 *velocity;
+  __m512 *local_best_positions;
+  __m512 *global_best_position;
+  float *current_fitness;
+  float *local_best_fitness;
+
+  size_t global_best_idx;
+  size_t *slice_best_idx;
+} pso512_ctx_t;
+
+/**
+   Create an AVX-512 PSO solve on `n_threads` threads (0 for the default). Any `dim`
+   works, every particle is padded to whole vectors with zeros.
+ */
+pso512_ctx_t *pso512_create(avx512_obj_func_t obj_func,
+                            size_t swarm_size,
+                            size_t dim,
+                            const float min_position,
+                            const float max_position,
+                            size_t n_threads,
+                            size_t seed);
+
+/**
+   Run `n_iter` iterations of the solve.
+ */
+void pso512_step(pso512_ctx_t *ctx, size_t n_iter);
+
+/**
+   Copy the best position found so far into `solution` (`dim` floats) and return its
+   objective value.
+ */
+float pso512_result(const pso512_ctx_t *ctx, float *solution);
+
+/**
+   Release all memory held by `ctx`.
+ */
+void pso512_destroy(pso512_ctx_t *ctx);
+
+/**
+   AVX-512 PSO algorithm running the swarm on `n_threads` threads (0 for the default).
+ */
+float *pso_parallel_avx512(avx512_obj_func_t obj_func,
+                           size_t swarm_size,
+                           size_t dim, size_t max_iter,
+                           const float min_position,
+                           const float max_position,
+                           size_t n_threads);
+
+/**
+   AVX-512 PSO algorithm.
+ */
+float *pso_basic_avx512(avx512_obj_func_t obj_func,
+                        size_t swarm_size,
+                        size_t dim, size_t max_iter,
+                        const float min_position,
+                        const float max_position);
+
+/**
+   AVX-512 PSO algorithm using `pso_default_num_threads()` threads.
+ */
+float *pso_basic_mt_avx512(avx512_obj_func_t obj_func,
+                           size_t swarm_size,
+                           size_t dim, size_t max_iter,
+                           const float min_position,
+                           const float max_position);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,36 @@
+#pragma once
+
+#include "pso.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/**
+   Update of the swarm specialised on the `opt_simd_*` objective function `obj_func`,
+   for `pso_use_update`, or NULL if there is no specialisation. It computes the objective
+   in the same pass that moves a particle, while the new positions are still in registers,
+   instead of calling `obj_func` on them afterwards.
+ */
+pso_update_func_t pso_fused_update(simd_obj_func_t obj_func);
+
+/**
+   Same as `pso_fused_update`, with the number of vectors per particle fixed at compile
+   time if `dim` is 8, 16, 32, 64 or 128.
+ */
+pso_update_func_t pso_fused_update_dim(simd_obj_func_t obj_func, size_t dim);
+
+/**
+   Single threaded PSO algorithm moving and evaluating the particles in one pass with
+   `pso_fused_update_dim(obj_func, dim)`, or the generic update if there is no specialisation.
+ */
+float *pso_basic_fused(simd_obj_func_t obj_func,
+                       size_t swarm_size,
+                       size_t dim, size_t max_iter,
+                       const float min_position,
+                       const float max_position);
+
+#ifdef __cplusplus
+}
+#endif
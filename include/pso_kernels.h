@@ -0,0 +1,177 @@
+#pragma once
+
+/**
+   Inline kernels shared by the AVX2 PSO engines. Only include this header from
+   translation units built with AVX2 and FMA.
+ */
+
+#include <stdint.h>
+
+#include "pso.h"
+
+
+/**
+   Advance the xorshift chain `state` and generate a vector of random floats between
+   0 and 1 from it.
+ */
+static inline __m256 simd_xorshift_0_to_1(__m256i *const state) {
+  const __m256i s0 = *state;
+  const __m256i s1 = _mm256_xor_si256(s0, _mm256_slli_epi64(s0, 23));
+
+  const __m256i lhs = _mm256_xor_si256(_mm256_xor_si256(s1, s0), _mm256_srli_epi64(s1, 18));
+  const __m256i rhs = _mm256_srli_epi64(s0, 5);
+
+  *state = _mm256_xor_si256(lhs, rhs);
+  const __m256 rands = _mm256_cvtepi32_ps(_mm256_abs_epi32(_mm256_add_epi64(*state, s0)));
+  return _mm256_mul_ps(rands, _mm256_set1_ps(1.0f / 2147483648.0f));
+}
+
+/**
+   Generate a vector of random floats between 0 and 1 from the first chain of `rng`.
+*/
+static inline __m256 simd_rand_0_to_1(simd_rng_t *const rng) {
+  return simd_xorshift_0_to_1(&rng->state[0]);
+}
+
+/**
+   Generate a vector of random floats between `min` and `max`.
+ */
+static inline __m256 simd_rand_min_max(simd_rng_t *const rng, const pso_bounds_t *const bounds) {
+  const __m256 rands = simd_rand_0_to_1(rng);
+  const __m256 factor_min_to_max = _mm256_sub_ps(bounds->max_pos, bounds->min_pos);
+  return _mm256_fmadd_ps(rands, factor_min_to_max, bounds->min_pos);
+}
+
+/**
+   High 32 bits of the products of the 8 unsigned 32 bit lanes of `a` with `m`.
+ */
+static inline __m256i simd_mulhi_epu32(const __m256i a, const __m256i m) {
+  const __m256i even = _mm256_srli_epi64(_mm256_mul_epu32(a, m), 32);
+  const __m256i odd = _mm256_mul_epu32(_mm256_srli_epi64(a, 32), m);
+  return _mm256_blend_epi32(even, odd, 0xaa);
+}
+
+/**
+   Philox4x32-10 (Salmon et al., "Parallel random numbers: as easy as 1, 2, 3") of 8
+   counters at once. Word `w` of counter `i` is lane `i` of `ctr[w]`; the counters are
+   replaced by their random words. Every counter gives the same words on any thread.
+ */
+static inline void simd_philox4x32(__m256i ctr[4], uint64_t key) {
+  const __m256i m0 = _mm256_set1_epi32((int)0xD2511F53);
+  const __m256i m1 = _mm256_set1_epi32((int)0xCD9E8D57);
+  __m256i k0 = _mm256_set1_epi32((int)(uint32_t)key);
+  __m256i k1 = _mm256_set1_epi32((int)(uint32_t)(key >> 32));
+  const __m256i w0 = _mm256_set1_epi32((int)0x9E3779B9);
+  const __m256i w1 = _mm256_set1_epi32((int)0xBB67AE85);
+
+  for(int round = 0; round < 10; round++) {
+    __m256i hi0 = simd_mulhi_epu32(ctr[0], m0);
+    __m256i lo0 = _mm256_mullo_epi32(ctr[0], m0);
+    __m256i hi1 = simd_mulhi_epu32(ctr[2], m1);
+    __m256i lo1 = _mm256_mullo_epi32(ctr[2], m1);
+    ctr[0] = _mm256_xor_si256(_mm256_xor_si256(hi1, ctr[1]), k0);
+    ctr[1] = lo1;
+    ctr[2] = _mm256_xor_si256(_mm256_xor_si256(hi0, ctr[3]), k1);
+    ctr[3] = lo0;
+    k0 = _mm256_add_epi32(k0, w0);
+    k1 = _mm256_add_epi32(k1, w1);
+  }
+}
+
+/**
+   Uniform floats in [0, 1) from the top 24 bits of 8 random words.
+ */
+static inline __m256 simd_bits_0_to_1(const __m256i bits) {
+  return _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_srli_epi32(bits, 8)),
+                       _mm256_set1_ps(1.0f / 16777216.0f));
+}
+
+/**
+   New velocity of one vector of a particle from the random factors `rand1` (towards the
+   local best) and `rand2` (towards the global best), inside the velocity bounds.
+ */
+static inline __m256 pso_new_velocity(const __m256 velocity, const __m256 position,
+                                      const __m256 local_best, const __m256 global_best,
+                                      const pso_bounds_t *const bounds,
+                                      const __m256 rand1, const __m256 rand2) {
+  __m256 term1 = _mm256_mul_ps(rand1, _mm256_sub_ps(local_best, position));
+  __m256 term2 = _mm256_mul_ps(rand2, _mm256_sub_ps(global_best, position));
+  __m256 res = _mm256_mul_ps(_mm256_set1_ps(INERTIA), velocity);
+  res = _mm256_fmadd_ps(_mm256_set1_ps(COG), term1, res);
+  res = _mm256_fmadd_ps(_mm256_set1_ps(SOCIAL), term2, res);
+  return _mm256_min_ps(_mm256_max_ps(bounds->min_vel, res), bounds->max_vel);
+}
+
+/**
+   Move `n_vectors` consecutive vectors of one particle: update the velocity from the
+   local and the global best and then the position, keeping both inside their bounds.
+ */
+static inline void pso_move_vectors(__m256 *const velocity, __m256 *const positions,
+                                    const __m256 *const local_best_positions,
+                                    const __m256 *const global_best_position,
+                                    const pso_bounds_t *const bounds, simd_rng_t *const rng,
+                                    size_t n_vectors) {
+  // rand1 and rand2 come from two independent chains copied to registers, so the draws
+  // neither wait for each other nor for the stores to the swarm
+  __m256i chain1 = rng->state[0];
+  __m256i chain2 = rng->state[1];
+
+  // update velocity for particle
+  for(size_t dimension = 0; dimension < n_vectors; dimension++) {
+    __m256 rand1 = simd_xorshift_0_to_1(&chain1);
+    __m256 rand2 = simd_xorshift_0_to_1(&chain2);
+    velocity[dimension] = pso_new_velocity(velocity[dimension], positions[dimension],
+                                           local_best_positions[dimension],
+                                           global_best_position[dimension], bounds, rand1, rand2);
+  }
+  rng->state[0] = chain1;
+  rng->state[1] = chain2;
+
+  // update position for particle
+  for(size_t dimension = 0; dimension < n_vectors; dimension++) {
+    positions[dimension] = _mm256_add_ps(positions[dimension], velocity[dimension]);
+    positions[dimension] = _mm256_min_ps(_mm256_max_ps(bounds->min_pos, positions[dimension]), bounds->max_pos);
+  }
+}
+
+/**
+   Zero the padding lanes of the last of `n_vectors` velocity and position vectors
+   with the `tail` mask of `simd_tail_mask`, since the bounds may not contain zero.
+ */
+static inline void pso_clear_tail(__m256 *const velocity, __m256 *const positions,
+                                  size_t n_vectors, const __m256 tail) {
+  velocity[n_vectors - 1] = _mm256_and_ps(velocity[n_vectors - 1], tail);
+  positions[n_vectors - 1] = _mm256_and_ps(positions[n_vectors - 1], tail);
+}
+
+/**
+   Same as `pso_move_vectors` for a whole particle, but the random factors come from
+   Philox counters keyed by `seed` and made of the `iteration`, the `particle` and the
+   vector, so they do not depend on which thread moves the particle or when. One Philox
+   block of 8 counters gives the factors of two vectors.
+ */
+static inline void pso_move_vectors_counter(__m256 *const velocity, __m256 *const positions,
+                                            const __m256 *const local_best_positions,
+                                            const __m256 *const global_best_position,
+                                            const pso_bounds_t *const bounds, uint64_t seed,
+                                            uint32_t iteration, uint32_t particle,
+                                            size_t n_vectors) {
+  const __m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+
+  for(size_t pair = 0; pair * 2 < n_vectors; pair++) {
+    __m256i ctr[4] = {_mm256_set1_epi32((int)pair), _mm256_set1_epi32((int)particle),
+                      _mm256_set1_epi32((int)iteration), lanes};
+    simd_philox4x32(ctr, seed);
+
+    for(size_t half = 0; half < 2 && pair * 2 + half < n_vectors; half++) {
+      size_t dimension = pair * 2 + half;
+      __m256 rand1 = simd_bits_0_to_1(ctr[2 * half]);
+      __m256 rand2 = simd_bits_0_to_1(ctr[2 * half + 1]);
+      velocity[dimension] = pso_new_velocity(velocity[dimension], positions[dimension],
+                                             local_best_positions[dimension],
+                                             global_best_position[dimension], bounds, rand1, rand2);
+      positions[dimension] = _mm256_add_ps(positions[dimension], velocity[dimension]);
+      positions[dimension] = _mm256_min_ps(_mm256_max_ps(bounds->min_pos, positions[dimension]), bounds->max_pos);
+    }
+  }
+}
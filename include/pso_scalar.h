@@ -0,0 +1,42 @@
+#pragma once
+
+#include "utils.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/**
+   Portable PSO algorithm on plain floats, the fallback for CPUs without AVX2.
+   Runs the swarm on `n_threads` threads (0 for the default) and accepts any `dim`
+   and `swarm_size`.
+ */
+float *pso_parallel_scalar(obj_func_t obj_func,
+                           size_t swarm_size,
+                           size_t dim, size_t max_iter,
+                           const float min_position,
+                           const float max_position,
+                           size_t n_threads);
+
+/**
+   Portable PSO algorithm.
+ */
+float *pso_basic_scalar(obj_func_t obj_func,
+                        size_t swarm_size,
+                        size_t dim, size_t max_iter,
+                        const float min_position,
+                        const float max_position);
+
+/**
+   Portable PSO algorithm using `pso_default_num_threads()` threads.
+ */
+float *pso_basic_mt_scalar(obj_func_t obj_func,
+                           size_t swarm_size,
+                           size_t dim, size_t max_iter,
+                           const float min_position,
+                           const float max_position);
+
+#ifdef __cplusplus
+}
+#endif
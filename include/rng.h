@@ -0,0 +1,108 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/**
+   Number of 64 bit xorshift128+ states of a generator: 4 chains of 4 lanes, one AVX2
+   register per chain. One round steps every lane once and gives `RNG_ROUND` floats.
+ */
+#define RNG_STATE_WORDS 16
+#define RNG_ROUND 32
+
+/**
+   Random number generator of the scalar algorithms, a replacement for `rand()` without
+   global state or locking. Bulk fills generate whole rounds straight into the output,
+   single draws and the rest of a fill are served from `buffer`, so any mix of calls
+   gives the same stream of numbers and the AVX2 and scalar paths give the same bits.
+ */
+typedef struct {
+  uint64_t state[RNG_STATE_WORDS];
+  float buffer[RNG_ROUND];   // uniform floats in [0, 1)
+  size_t next;               // first unused float in buffer
+} rng_t;
+
+/**
+   Advance a splitmix64 generator, used to expand a single seed into the states of
+   independent xorshift streams.
+ */
+static inline uint64_t splitmix64(uint64_t *const state) {
+  uint64_t z = (*state += 0x9E3779B97F4A7C15ULL);
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+  return z ^ (z >> 31);
+}
+
+/**
+   Seed `rng` from `seed` with splitmix64, equal seeds give equal streams.
+ */
+void rng_seed(rng_t *rng, uint64_t seed);
+
+// Cache line size the generators of different threads are kept apart by
+#define RNG_CACHE_LINE 64
+
+/**
+   Generator of one thread, padded to whole cache lines so that threads drawing side by
+   side never share one.
+ */
+typedef struct {
+  rng_t rng;
+} __attribute__((aligned(RNG_CACHE_LINE))) rng_stream_t;
+
+/**
+   Allocate `n` generators, one per thread, with stream `idx` seeded `seed + idx`. Free
+   them with `free`, exits if the allocation fails.
+ */
+rng_stream_t *rng_alloc_streams(size_t n, uint64_t seed);
+
+/**
+   Fill `out` with `n` uniform floats between `min` (inclusive) and `max`.
+ */
+void rng_uniform(rng_t *rng, float *out, size_t n, float min, float max);
+
+/**
+   Fill `out` with `n` normally distributed floats (Box-Muller).
+ */
+void rng_normal(rng_t *rng, float *out, size_t n, float mean, float stddev);
+
+/**
+   Fill `out` with `n` Levy-stable steps of index `beta` (between 0 and 2) with
+   Mantegna's algorithm, u / |v|^(1 / beta) for normal u and v.
+ */
+void rng_levy(rng_t *rng, float *out, size_t n, float beta);
+
+/**
+   Standard deviation of the numerator u of a Mantegna step of index `beta`, it only depends
+   on `beta` and can be computed once for many steps.
+ */
+float rng_levy_sigma(float beta);
+
+/**
+   Single uniform float between 0 (inclusive) and 1.
+ */
+float rng_0_to_1(rng_t *rng);
+
+/**
+   Single uniform float between `min` (inclusive) and `max`.
+ */
+float rng_min_max(rng_t *rng, float min, float max);
+
+/**
+   Generate `n_rounds` rounds of uniform floats between `min` and `max` into `out`
+   (`n_rounds * RNG_ROUND` floats) and advance `state`. Float `8 * chain + lane` of a
+   round comes from 32 bit lane `lane` of chain `chain`, whatever the instruction set.
+ */
+void rng_fill_rounds_scalar(uint64_t state[RNG_STATE_WORDS], float *out, size_t n_rounds,
+                            float min, float max);
+void rng_fill_rounds_avx2(uint64_t state[RNG_STATE_WORDS], float *out, size_t n_rounds,
+                          float min, float max);
+
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
@@ -0,0 +1,228 @@
+#pragma once
+
+/**
+   Single precision vector math for AVX2: sin, cos, sincos, exp, log and pow on 8 floats
+   at once, with the polynomials of Cephes (S. Moshier). Errors against libm, measured by
+   tests/test_simd_math.c:
+     - sin, cos, sincos: at most 2 ulp, or 2 ulp of 1 absolute near a root, for
+       |x| <= 8192, the argument reduction loses accuracy beyond
+     - exp: at most 2 ulp down to the smallest normal result, subnormal results are
+       less accurate and results beyond the float range are 0 or inf like in libm
+     - log: at most 2 ulp on positive normal and subnormal floats, log(0) = -inf and
+       negative inputs give NaN
+     - pow: at most 2 ulp for x >= 0, negative x give NaN
+   The kernels are inline and only defined in translation units built with AVX2 and FMA,
+   the array versions below can be called from anywhere once AVX2 has been checked.
+ */
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+   `out[i] = f(x[i])` for the `n` elements of `x`, `x` and `out` may be the same.
+ */
+void simd_sin_array(const float *x, float *out, size_t n);
+void simd_cos_array(const float *x, float *out, size_t n);
+void simd_exp_array(const float *x, float *out, size_t n);
+void simd_log_array(const float *x, float *out, size_t n);
+
+/**
+   `out[i] = pow(x[i], y)` for the `n` elements of `x`.
+ */
+void simd_pow_array(const float *x, float y, float *out, size_t n);
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+
+
+#if defined(__AVX2__) && defined(__FMA__)
+
+#include <math.h>
+#include <immintrin.h>
+
+/**
+   Sine and cosine of `x`: reduce to [-pi/4, pi/4] around the nearest multiple j of pi/4
+   (in three parts, so j * pi/4 is exact) and evaluate the sine or the cosine polynomial
+   depending on the octant.
+ */
+static inline void simd_sincos(const __m256 x, __m256 *const sin_out, __m256 *const cos_out) {
+  const __m256 sign_mask = _mm256_set1_ps(-0.0f);
+  __m256 sign_sin = _mm256_and_ps(x, sign_mask);
+  __m256 ax = _mm256_andnot_ps(sign_mask, x);
+
+  // octant rounded up to even, so the reduced argument is in [-pi/4, pi/4]
+  __m256i octant = _mm256_cvttps_epi32(_mm256_mul_ps(ax, _mm256_set1_ps(1.27323954473516f)));
+  octant = _mm256_and_si256(_mm256_add_epi32(octant, _mm256_set1_epi32(1)), _mm256_set1_epi32(~1));
+  const __m256 j = _mm256_cvtepi32_ps(octant);
+
+  ax = _mm256_fnmadd_ps(j, _mm256_set1_ps(0.78515625f), ax);
+  ax = _mm256_fnmadd_ps(j, _mm256_set1_ps(2.4187564849853515625e-4f), ax);
+  ax = _mm256_fnmadd_ps(j, _mm256_set1_ps(3.77489497744594108e-8f), ax);
+
+  // octants 2 and 6 swap the polynomials, octants 4 and 6 negate the sine and 2 and 4
+  // the cosine
+  const __m256 use_sin_poly = _mm256_castsi256_ps(
+    _mm256_cmpeq_epi32(_mm256_and_si256(octant, _mm256_set1_epi32(2)), _mm256_setzero_si256()));
+  sign_sin = _mm256_xor_ps(sign_sin, _mm256_castsi256_ps(
+    _mm256_slli_epi32(_mm256_and_si256(octant, _mm256_set1_epi32(4)), 29)));
+  const __m256 sign_cos = _mm256_castsi256_ps(_mm256_slli_epi32(
+    _mm256_andnot_si256(_mm256_sub_epi32(octant, _mm256_set1_epi32(2)), _mm256_set1_epi32(4)), 29));
+
+  const __m256 z = _mm256_mul_ps(ax, ax);
+  __m256 cos_poly = _mm256_fmadd_ps(_mm256_set1_ps(2.443315711809948e-5f), z,
+                                    _mm256_set1_ps(-1.388731625493765e-3f));
+  cos_poly = _mm256_fmadd_ps(cos_poly, z, _mm256_set1_ps(4.166664568298827e-2f));
+  cos_poly = _mm256_mul_ps(_mm256_mul_ps(cos_poly, z), z);
+  cos_poly = _mm256_fnmadd_ps(_mm256_set1_ps(0.5f), z, cos_poly);
+  cos_poly = _mm256_add_ps(cos_poly, _mm256_set1_ps(1.0f));
+
+  __m256 sin_poly = _mm256_fmadd_ps(_mm256_set1_ps(-1.9515295891e-4f), z,
+                                    _mm256_set1_ps(8.3321608736e-3f));
+  sin_poly = _mm256_fmadd_ps(sin_poly, z, _mm256_set1_ps(-1.6666654611e-1f));
+  sin_poly = _mm256_fmadd_ps(_mm256_mul_ps(sin_poly, z), ax, ax);
+
+  *sin_out = _mm256_xor_ps(_mm256_blendv_ps(cos_poly, sin_poly, use_sin_poly), sign_sin);
+  *cos_out = _mm256_xor_ps(_mm256_blendv_ps(sin_poly, cos_poly, use_sin_poly), sign_cos);
+}
+
+static inline __m256 simd_sin(const __m256 x) {
+  __m256 sin_x, cos_x;
+  simd_sincos(x, &sin_x, &cos_x);
+  return sin_x;
+}
+
+static inline __m256 simd_cos(const __m256 x) {
+  __m256 sin_x, cos_x;
+  simd_sincos(x, &sin_x, &cos_x);
+  return cos_x;
+}
+
+/**
+   e^(x + x_lo) as 2^n * e^r with n the nearest integer to x / ln(2) and |r| <= ln(2) / 2,
+   `x_lo` is a small correction below the precision of `x`.
+ */
+static inline __m256 simd_exp_hi_lo(__m256 x, const __m256 x_lo) {
+  // beyond the bounds the result is 0 or inf anyway, NaN is kept (second operand)
+  x = _mm256_min_ps(_mm256_set1_ps(88.8f), _mm256_max_ps(_mm256_set1_ps(-104.0f), x));
+
+  const __m256 n = _mm256_round_ps(_mm256_mul_ps(x, _mm256_set1_ps(1.44269504088896341f)),
+                                   _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+  // ln(2) in two parts, n * 0.693359375 is exact
+  __m256 r = _mm256_fnmadd_ps(n, _mm256_set1_ps(0.693359375f), x);
+  r = _mm256_fnmadd_ps(n, _mm256_set1_ps(-2.12194440e-4f), r);
+  r = _mm256_add_ps(r, x_lo);
+
+  __m256 poly = _mm256_fmadd_ps(_mm256_set1_ps(1.9875691500e-4f), r, _mm256_set1_ps(1.3981999507e-3f));
+  poly = _mm256_fmadd_ps(poly, r, _mm256_set1_ps(8.3334519073e-3f));
+  poly = _mm256_fmadd_ps(poly, r, _mm256_set1_ps(4.1665795894e-2f));
+  poly = _mm256_fmadd_ps(poly, r, _mm256_set1_ps(1.6666665459e-1f));
+  poly = _mm256_fmadd_ps(poly, r, _mm256_set1_ps(5.0000001201e-1f));
+  poly = _mm256_fmadd_ps(poly, _mm256_mul_ps(r, r), r);
+  poly = _mm256_add_ps(poly, _mm256_set1_ps(1.0f));
+
+  // 2^n in two factors, so n from -150 to 129 neither under- nor overflows the exponent
+  const __m256i int_n = _mm256_cvtps_epi32(n);
+  const __m256i half_n = _mm256_srai_epi32(int_n, 1);
+  const __m256i rest_n = _mm256_sub_epi32(int_n, half_n);
+  const __m256 scale1 = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_add_epi32(half_n, _mm256_set1_epi32(127)), 23));
+  const __m256 scale2 = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_add_epi32(rest_n, _mm256_set1_epi32(127)), 23));
+  return _mm256_mul_ps(_mm256_mul_ps(poly, scale1), scale2);
+}
+
+static inline __m256 simd_exp(const __m256 x) {
+  return simd_exp_hi_lo(x, _mm256_setzero_ps());
+}
+
+/**
+   Natural logarithm as e * ln(2) + ln(1 + m) for x = 2^e * (1 + m) and 1 + m in
+   [sqrt(2) / 2, sqrt(2)), returned as the sum of the result and `*lo`, a correction
+   below its precision.
+ */
+static inline __m256 simd_log_hi_lo(const __m256 x, __m256 *const lo) {
+  const __m256 zero = _mm256_setzero_ps();
+  const __m256 is_zero = _mm256_cmp_ps(x, zero, _CMP_EQ_OQ);
+  const __m256 is_invalid = _mm256_cmp_ps(x, zero, _CMP_NGE_UQ);     // negative or NaN
+  const __m256 is_inf = _mm256_cmp_ps(x, _mm256_set1_ps(INFINITY), _CMP_EQ_OQ);
+
+  // subnormals are scaled into the normal range first
+  const __m256 is_subnormal = _mm256_cmp_ps(x, _mm256_set1_ps(1.17549435e-38f), _CMP_LT_OQ);
+  const __m256 scaled = _mm256_blendv_ps(x, _mm256_mul_ps(x, _mm256_set1_ps(33554432.0f)), is_subnormal);
+  const __m256 exp_offset = _mm256_and_ps(is_subnormal, _mm256_set1_ps(25.0f));
+
+  const __m256i bits = _mm256_castps_si256(scaled);
+  __m256 e = _mm256_cvtepi32_ps(_mm256_sub_epi32(_mm256_srli_epi32(bits, 23), _mm256_set1_epi32(126)));
+  e = _mm256_sub_ps(e, exp_offset);
+  // mantissa in [0.5, 1)
+  __m256 m = _mm256_castsi256_ps(_mm256_or_si256(_mm256_and_si256(bits, _mm256_set1_epi32(0x007fffff)),
+                                                 _mm256_set1_epi32(0x3f000000)));
+
+  // below sqrt(2) / 2 the mantissa is doubled, m - 1 is exact either way
+  const __m256 small = _mm256_cmp_ps(m, _mm256_set1_ps(0.707106781186547524f), _CMP_LT_OQ);
+  e = _mm256_sub_ps(e, _mm256_and_ps(small, _mm256_set1_ps(1.0f)));
+  m = _mm256_add_ps(_mm256_sub_ps(m, _mm256_set1_ps(1.0f)), _mm256_and_ps(small, m));
+
+  // ln(1 + m) = m - m^2 / 2 + m^3 * P(m)
+  const __m256 z = _mm256_mul_ps(m, m);
+  const __m256 z_lo = _mm256_fmsub_ps(m, m, z);
+  __m256 poly = _mm256_fmadd_ps(_mm256_set1_ps(7.0376836292e-2f), m, _mm256_set1_ps(-1.1514610310e-1f));
+  poly = _mm256_fmadd_ps(poly, m, _mm256_set1_ps(1.1676998740e-1f));
+  poly = _mm256_fmadd_ps(poly, m, _mm256_set1_ps(-1.2420140846e-1f));
+  poly = _mm256_fmadd_ps(poly, m, _mm256_set1_ps(1.4249322787e-1f));
+  poly = _mm256_fmadd_ps(poly, m, _mm256_set1_ps(-1.6668057665e-1f));
+  poly = _mm256_fmadd_ps(poly, m, _mm256_set1_ps(2.0000714765e-1f));
+  poly = _mm256_fmadd_ps(poly, m, _mm256_set1_ps(-2.4999993993e-1f));
+  poly = _mm256_fmadd_ps(poly, m, _mm256_set1_ps(3.3333331174e-1f));
+  poly = _mm256_mul_ps(_mm256_mul_ps(poly, m), z);
+
+  // m - m^2 / 2 with its rounding error, |m| > m^2 / 2
+  const __m256 half_z = _mm256_mul_ps(_mm256_set1_ps(0.5f), z);
+  const __m256 sum = _mm256_sub_ps(m, half_z);
+  const __m256 sum_lo = _mm256_sub_ps(_mm256_sub_ps(m, sum), half_z);
+
+  // plus e * ln(2), in two parts with e * 0.693359375 exact, again with its rounding error
+  const __m256 e_ln2 = _mm256_mul_ps(e, _mm256_set1_ps(0.693359375f));
+  const __m256 hi = _mm256_add_ps(e_ln2, sum);
+  const __m256 back = _mm256_sub_ps(hi, e_ln2);
+  const __m256 hi_err = _mm256_add_ps(_mm256_sub_ps(e_ln2, _mm256_sub_ps(hi, back)), _mm256_sub_ps(sum, back));
+
+  __m256 res_lo = _mm256_add_ps(hi_err, sum_lo);
+  res_lo = _mm256_add_ps(res_lo, poly);
+  res_lo = _mm256_fmadd_ps(e, _mm256_set1_ps(-2.12194440e-4f), res_lo);
+  res_lo = _mm256_fnmadd_ps(_mm256_set1_ps(0.5f), z_lo, res_lo);
+
+  const __m256 special = _mm256_or_ps(_mm256_or_ps(is_zero, is_invalid), is_inf);
+  *lo = _mm256_andnot_ps(special, res_lo);
+  __m256 res = _mm256_blendv_ps(hi, _mm256_set1_ps(INFINITY), is_inf);
+  res = _mm256_blendv_ps(res, _mm256_set1_ps(-INFINITY), is_zero);
+  return _mm256_blendv_ps(res, _mm256_set1_ps(NAN), is_invalid);
+}
+
+static inline __m256 simd_log(const __m256 x) {
+  __m256 lo;
+  const __m256 hi = simd_log_hi_lo(x, &lo);
+  return _mm256_add_ps(hi, lo);
+}
+
+/**
+   x^y for x >= 0 as exp(y * log(x)), with the product carried in two parts so the
+   error does not grow with it. pow(0, y) is 0 for y > 0 and inf for y < 0, pow(x, 0) = 1.
+ */
+static inline __m256 simd_pow(const __m256 x, const __m256 y) {
+  __m256 log_lo;
+  const __m256 log_hi = simd_log_hi_lo(x, &log_lo);
+  const __m256 prod = _mm256_mul_ps(y, log_hi);
+  __m256 prod_lo = _mm256_fmadd_ps(y, log_lo, _mm256_fmsub_ps(y, log_hi, prod));
+  // the rounding error of an infinite product is NaN
+  const __m256 finite = _mm256_cmp_ps(_mm256_andnot_ps(_mm256_set1_ps(-0.0f), prod),
+                                      _mm256_set1_ps(INFINITY), _CMP_LT_OQ);
+  prod_lo = _mm256_and_ps(finite, prod_lo);
+
+  const __m256 res = simd_exp_hi_lo(prod, prod_lo);
+  return _mm256_blendv_ps(res, _mm256_set1_ps(1.0f), _mm256_cmp_ps(y, _mm256_setzero_ps(), _CMP_EQ_OQ));
+}
+
+#endif // __AVX2__ && __FMA__
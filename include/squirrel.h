@@ -5,8 +5,20 @@ extern "C" {
 #endif
 
 #include "stddef.h"
+#include "rng.h"
 #include "utils.h"
 
+#define NUM_JUMP_HICK 0.2
+#define T_MAX 100
+#define PREDATOR_PROB 0.1
+#define BETA 1.5
+#define GLIDING_CONST 1.9
+#define CD 0.60
+#define CL_MIN 0.675
+#define CL_MAX 1.5
+#define SF 18
+#define DROP 8
+
 float* squirrel (obj_func_t obj_func,
                   size_t population,
                   size_t dim,
@@ -16,7 +28,8 @@ float* squirrel (obj_func_t obj_func,
 /**
 * Randomly initialize squirrel population
 **/
-void sqr_rand_init(float* const positions,
+void sqr_rand_init(rng_t* const rng,
+                  float* const positions,
                   size_t population,
                   size_t dim,
                   const float min_position,
@@ -26,7 +39,7 @@ void sqr_rand_init(float* const positions,
 *   returns 1 with probability passed as arguement [0,1]
 *   returns 0 with probability ( 1 - probability)
 **/
-int sqr_bernoulli_distribution(float probability);
+int sqr_bernoulli_distribution(rng_t* const rng, float probability);
 
 /**
 *   Evaluate fitness at current positions
@@ -56,12 +69,13 @@ void sqr_lowest4_vals_to_front(float* fitness,
 /**
 * Calculate gliding distance
 **/
-float sqr_gliding_dist();
+float sqr_gliding_dist(rng_t* const rng);
 /**
 *   move squirrels from acorn and
 *   select normal trees to hickory tree
 **/
-void sqr_move_to_hickory(float* positions,
+void sqr_move_to_hickory(rng_t* const rng,
+                      float* positions,
                       size_t population,
                       size_t dim,
                       const float min_position,
@@ -69,7 +83,8 @@ void sqr_move_to_hickory(float* positions,
 /**
 *   move squirrels on normal tree towards acorn tree
 **/
-void sqr_move_normal_to_acorn(float* positions,
+void sqr_move_normal_to_acorn(rng_t* const rng,
+                          float* positions,
                           size_t population,
                           size_t dim,
                           const float min_position,
@@ -97,18 +112,64 @@ float sqr_eval_gamma(float x);
 
 /**
 *  Levy flight based random step for
-*  random restart/relocation after season change
+*  random restart/relocation after season change,
+*  0.01 times the size of a Mantegna step
 **/
-float sqr_levy_flight();
+float sqr_levy_flight(rng_t* const rng);
 
 /**
 *   if season has changed,
 *   relocate squirrels that hevent
 *   travelled towards the hickory tree
 **/
-void random_restart(float* positions,
+void random_restart(rng_t* const rng,
+                    float* positions,
+                    size_t population,
+                    size_t dim,
+                    const float min_position,
+                    const float max_position);
+
+/**
+*   Mantegna steps of index 1 / inv_beta on AVX2, 8 per vector,
+*   sigma_u from rng_levy_sigma. Both normals of a step come from
+*   16 uniforms in [0, 1), uniforms[16*i : 16*i+16] for vector i,
+*   steps has size 8*n_vectors
+**/
+void sqr_simd_levy_steps(float* steps,
+                    const float* uniforms,
+                    size_t n_vectors,
+                    float sigma_u,
+                    float inv_beta);
+
+/**
+*   Squirrel search on AVX2 and n_threads threads,
+*   0 uses the OpenMP default
+**/
+float* squirrel_parallel(simd_obj_func_t obj_func,
+                    size_t population,
+                    size_t dim,
+                    size_t max_iter,
+                    const float min_position,
+                    const float max_position,
+                    size_t n_threads);
+
+/**
+*   Squirrel search on AVX2, single threaded
+**/
+float* squirrel_simd(simd_obj_func_t obj_func,
+                    size_t population,
+                    size_t dim,
+                    size_t max_iter,
+                    const float min_position,
+                    const float max_position);
+
+/**
+*   Squirrel search on AVX2 and the default number of threads
+**/
+float* squirrel_simd_mt(simd_obj_func_t obj_func,
                     size_t population,
                     size_t dim,
+                    size_t max_iter,
                     const float min_position,
                     const float max_position);
 
@@ -10,13 +10,34 @@ extern "C" {
 // Objective function type
 typedef float (*obj_func_t)(const float *, size_t);
 
+// Vectorised objective function types, called with the vectors of one particle and
+// its dimension in floats. The lanes past the dimension in the last vector are padding.
 typedef float (*simd_obj_func_t)(const __m256*, size_t);
 
+typedef float (*avx512_obj_func_t)(const __m512*, size_t);
+
+// Cross-particle objective function type, called with the transposed positions of 8
+// particles (vector `d` holds dimension `d` of every particle) and the dimension.
+// Writes the fitness of all 8 particles to the last argument.
+typedef void (*simd_lanes_obj_func_t)(const __m256*, size_t, float*);
+
+// Batched objective function type, called with the positions of `count` candidates stored
+// row after row, `count` and the dimension. Writes the fitness of every candidate to the
+// last argument.
+typedef void (*batch_obj_func_t)(const float*, size_t, size_t, float*);
+
+// Partial objective function type, called with the vectors of one particle, a range
+// [begin, end) of vector indices and the dimension. Returns the sum of the terms starting
+// in that range, still to be reduced horizontally; may also read vector `end`.
+typedef __m256 (*simd_tile_obj_func_t)(const __m256*, size_t, size_t, size_t);
+
 // Algorithm function type
 typedef float * (*algo_func_t)(obj_func_t, size_t, size_t, size_t, const float, const float);
 
 typedef float * (*simd_algo_func_t)(simd_obj_func_t, size_t, size_t, size_t, const float, const float);
 
+typedef float * (*avx512_algo_func_t)(avx512_obj_func_t, size_t, size_t, size_t, const float, const float);
+
 /**
    Perform a horizontal addition of a AVX register containing 8 floats.
 
@@ -28,6 +49,13 @@ typedef float * (*simd_algo_func_t)(simd_obj_func_t, size_t, size_t, size_t, con
  */
 float horizontal_add(__m256 a);
 
+/**
+   Mask of the lanes of the last AVX register of a `dim` long array that hold data,
+   i.e. the first `dim % 8` lanes, or all lanes if `dim` is a multiple of 8.
+   Usable with `_mm256_maskload_ps` / `_mm256_maskstore_ps` or cast for bitwise selects.
+ */
+__m256i simd_tail_mask(size_t dim);
+
 
 /**
  *  Prints the solution array of one algorithm output to console.
@@ -77,6 +105,12 @@ float random_0_to_1();
  */
 float linear_scale(float start, float end, size_t iter_max, size_t iter);
 
+/**
+ * Number of threads the multi-threaded algorithms run on when asked for 0 threads, the
+ * OpenMP default or 1 without OpenMP.
+ */
+size_t default_num_threads(void);
+
 /**
  * Get average value of an array.
  */
@@ -93,6 +127,38 @@ float lowest_value(size_t arr_length, const float * arr);
  */
 void mmm(size_t dim, const float* a, const float* b, float* res);
 
+/**
+   Compute the matrix matrix multiplication of `a` (`m` times `k`) and `b` (`k` times `n`),
+   all row major, and store the result in `res` (`m` times `n`). The rows of `b` are
+   walked in blocks that stay in cache while every row of `a` uses them.
+ */
+void gemm(size_t m, size_t n, size_t k, const float* a, const float* b, float* res);
+
+/**
+   Same as `gemm` with AVX2 and FMA, a register block is 4 rows and 16 columns of `res`.
+ */
+void simd_gemm(size_t m, size_t n, size_t k, const float* a, const float* b, float* res);
+
+/**
+   Transpose `a` of size `rows` times `cols` into `res` of size `cols` times `rows`.
+ */
+void transpose(size_t rows, size_t cols, const float* a, float* res);
+
+/**
+   Euclidean distances between all pairs of the `count` points of size `dim` (row major)
+   into `distances` (`count` times `count`). They come from the Gram matrix of dot products,
+   |a - b|^2 = |a|^2 + |b|^2 - 2 a.b, which is one `gemm` with the transposed points,
+   stored in `points_t` (`dim` times `count`).
+ */
+void pairwise_distances(size_t count, size_t dim, const float* points, float* points_t,
+                        float* distances);
+
+/**
+   Same as `pairwise_distances` with `simd_gemm` and AVX2.
+ */
+void simd_pairwise_distances(size_t count, size_t dim, const float* points, float* points_t,
+                             float* distances);
+
 /**
    Compute matrix vector multiplication between `m` (matrix) and `v` (vector), where `m` is
    `dim` times `dim` and store the result in `res`.
@@ -2,6 +2,10 @@
 #include <iostream>
 #include <functional>
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
 #include "tsc_x86.h"
 #include "cpp_utils.h"
 #include "benchmark.h"
@@ -9,6 +13,10 @@
 #include "hgwosca.h"
 #include "penguin.h"
 #include "pso.h"
+#include "pso_aosoa.h"
+#include "pso_avx512.h"
+#include "pso_fused.h"
+#include "pso_scalar.h"
 #include "squirrel.h"
 
 
@@ -27,14 +35,44 @@ std::vector<timeInt64> time_algorithm(Config cfg) {
     throw std::invalid_argument("There is no registered algorithm called " + cfg.algorithm);
   }
 
+  #ifdef _OPENMP
+    // Thread count used by the multi-threaded algorithms, 0 keeps the OpenMP default
+    if (cfg.n_threads > 0) {
+      omp_set_num_threads(cfg.n_threads);
+    }
+  #endif
+
+  // Pick the widest implementation the CPU, the algorithm and the objective all support
+  const algo_impl_t &algo = algo_func_map[cfg.algorithm];
+  const obj_impl_t &obj = obj_func_map[cfg.obj_func];
+  const isa_t isa = select_isa(algo, obj, active_isa());
+  if (isa == ISA_SCALAR && !(algo.scalar && obj.scalar)) {
+    throw std::invalid_argument("There is no implementation of " + cfg.algorithm + " with " +
+                                cfg.obj_func + " runnable on this CPU");
+  }
+  std::cout << "  Instruction set:    " << isa_name(isa) << "\n" << std::endl;
+
+  // the unroll factors of the objectives are measured on first use, not in the timed runs
+  if (isa >= ISA_AVX2) {
+    opt_simd_tune_unroll();
+  }
+
   // Bind the parameters such that we have one generic algorithm function to run and benchmark
-  auto algo_func = std::bind(algo_func_map[cfg.algorithm],
-                             obj_func_map[cfg.obj_func],
-                             cfg.population,
-                             cfg.dimension,
-                             cfg.n_iterations,
-                             cfg.min_position,
-                             cfg.max_position);
+  std::function<float *()> algo_func;
+  switch (isa) {
+    case ISA_AVX512:
+      algo_func = std::bind(algo.avx512, obj.avx512, cfg.population, cfg.dimension,
+                            cfg.n_iterations, cfg.min_position, cfg.max_position);
+      break;
+    case ISA_AVX2:
+      algo_func = std::bind(algo.avx2, obj.avx2, cfg.population, cfg.dimension,
+                            cfg.n_iterations, cfg.min_position, cfg.max_position);
+      break;
+    default:
+      algo_func = std::bind(algo.scalar, obj.scalar, cfg.population, cfg.dimension,
+                            cfg.n_iterations, cfg.min_position, cfg.max_position);
+      break;
+  }
 
   std::vector<timeInt64> cycles_vec;
   float *solution;
@@ -65,11 +103,33 @@ std::vector<timeInt64> time_algorithm(Config cfg) {
 }
 
 
+isa_t select_isa(const algo_impl_t &algo, const obj_impl_t &obj, isa_t max_isa) {
+  if (max_isa >= ISA_AVX512 && algo.avx512 && obj.avx512) {
+    return ISA_AVX512;
+  }
+  if (max_isa >= ISA_AVX2 && algo.avx2 && obj.avx2) {
+    return ISA_AVX2;
+  }
+  return ISA_SCALAR;
+}
+
+
 obj_map_t create_obj_map() {
 
   // Register more objective functions here as they get implemented.
-  obj_map_t obj_map = {{"rosenbrock",     &opt_simd_rosenbrock},
-                       {"sum_of_squares", &opt_simd_sum_of_squares}};
+  obj_map_t obj_map = {
+    //                        scalar             avx2                        avx512
+    {"rosenbrock",      {&rosenbrock,      &opt_simd_rosenbrock,      &opt_avx512_rosenbrock}},
+    {"sum_of_squares",  {&sum_of_squares,  &opt_simd_sum_of_squares,  &opt_avx512_sum_of_squares}},
+    {"rastigrin",       {&rastigrin,       &opt_simd_rastigrin,       nullptr}},
+    {"sphere",          {&sphere,          &opt_simd_sphere,          nullptr}},
+    {"griewank",        {&griewank,        &opt_simd_griewank,        nullptr}},
+    {"schwefel01",      {&schwefel01,      &opt_simd_schwefel01,      nullptr}},
+    {"powel",           {&powel,           &opt_simd_powel,           nullptr}},
+    {"freundsteinroth", {&freundsteinroth, &opt_simd_freundsteinroth, nullptr}},
+    {"beale",           {&beale,           &opt_simd_beale,           nullptr}},
+    {"egghol2d",        {&egghol2d,        &opt_simd_egghol2d,        nullptr}},
+    {"schaf2d",         {&schaf2d,         &opt_simd_schaf2d,         nullptr}}};
   return obj_map;
 }
 
@@ -78,10 +138,20 @@ algo_map_t create_algo_map() {
 
   // Register more algorithms here as they get implemented.
   algo_map_t algo_map = {
-                         // {"hgwosca",  &gwo_hgwosca},
-                         // {"penguin",  &pen_emperor_penguin},
-                         {"pso",      &pso_basic},
-                         // {"squirrel", &squirrel}
-                         };
+    //                  scalar                avx2            avx512
+    {"hgwosca",  {&gwo_hgwosca,         &gwo_hgwosca_simd,    nullptr}},
+    {"hgwosca_mt", {&gwo_hgwosca,       &gwo_hgwosca_simd_mt, nullptr}},
+    {"penguin",  {&pen_emperor_penguin,    nullptr,        nullptr}},
+    {"penguin_mt", {&pen_emperor_penguin_mt, nullptr,      nullptr}},
+    {"pso",      {&pso_basic_scalar,    &pso_basic,     &pso_basic_avx512}},
+    {"pso_mt",   {&pso_basic_mt_scalar, &pso_basic_mt,  &pso_basic_mt_avx512}},
+    // bit-identical on any number of threads, only the AVX2 engine has counter streams
+    {"pso_mt_counter", {nullptr,        &pso_basic_mt_counter, nullptr}},
+    {"pso_x8",   {&pso_basic_scalar,    &pso_basic_x8,  nullptr}},
+    {"pso_aosoa", {&pso_basic_scalar,   &pso_basic_aosoa, nullptr}},
+    {"pso_fused", {&pso_basic_scalar,   &pso_basic_fused, nullptr}},
+    {"squirrel", {&squirrel,            &squirrel_simd,  nullptr}},
+    {"squirrel_mt", {&squirrel,         &squirrel_simd_mt, nullptr}},
+  };
   return algo_map;
 }
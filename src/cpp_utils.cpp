@@ -9,7 +9,7 @@
 #define ARGC_REQUIRED 20
 
 #define USAGE (                                                         \
-               "\nUsage:  [-vaofsnmpyz]\n"                              \
+               "\nUsage:  [-vaofsnmpyzt]\n"                             \
                "  -v    verbose\n"                                      \
                "  -a    algorithm name\n"                               \
                "  -o    objective function name\n"                      \
@@ -20,8 +20,9 @@
                "  -p    population size\n"                              \
                "  -y    minimum values\n"                               \
                "  -z    maximum values\n"                               \
+               "  -t    number of threads (optional)\n"                 \
                "  \n"                                                   \
-               "Currently all parameters are required.\n\n"             \
+               "Currently all parameters but -t are required.\n\n"      \
                "Example:\n"                                             \
                "    ./benchmark -a \"hgwosca\" -o \"sum\" -n 50 -m 1 -d 10 -p 30 -y -120 -z 100 -s \"../data/solution.txt\" -f \"../data/timings.txt\"\n")
 
@@ -43,8 +44,9 @@ void parse_args(Config *config, int argc, char *argv[]) {
   config->algorithm = "";
   config->solution_file = "";
   config->out_file = "";
+  config->n_threads = 0;
 
-  while ((opt = getopt(argc, argv, "hva:o:d:p:n:m:y:z:f:s:")) != -1) {
+  while ((opt = getopt(argc, argv, "hva:o:d:p:n:m:y:z:f:s:t:")) != -1) {
     switch (opt) {
       case 'v':  // verbose
         config->verbose = true;
@@ -109,6 +111,14 @@ void parse_args(Config *config, int argc, char *argv[]) {
         }
         config->max_position = max_pos;
         break;
+      case 't':  // n_threads
+        int n_threads;
+        if (sscanf(optarg, "%i", &n_threads) != 1 || n_threads < 0) {
+          fprintf(stderr, "invalid arg '%s': must be a non-negative integer\n", optarg);
+          exit(EXIT_FAILURE);
+        }
+        config->n_threads = n_threads;
+        break;
 
       case 'h':
       default:
@@ -148,6 +158,7 @@ void print_config(Config config) {
   std::cout << "  N Iterations:       " << config.n_iterations  << std::endl;
   std::cout << "  Min position:       " << config.min_position  << std::endl;
   std::cout << "  Max position        " << config.max_position  << std::endl;
+  std::cout << "  N Threads:          " << config.n_threads     << std::endl;
   std::cout << " ===========================================\n" << std::endl;
 }
 
@@ -0,0 +1,111 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <cpuid.h>
+#include <unistd.h>
+
+#include "dispatch.h"
+
+// CPUID leaf 1, ECX
+#define CPUID_FMA     (1u << 12)
+#define CPUID_OSXSAVE (1u << 27)
+#define CPUID_AVX     (1u << 28)
+// CPUID leaf 7 subleaf 0, EBX
+#define CPUID_AVX2    (1u << 5)
+#define CPUID_AVX512F (1u << 16)
+// XCR0 state components, SSE and AVX registers, then opmask and both ZMM halves
+#define XCR0_YMM  0x06u
+#define XCR0_ZMM  0xe0u
+
+
+/**
+   Read the extended control register XCR0. Only valid when OSXSAVE is set.
+ */
+static uint64_t read_xcr0(void) {
+  uint32_t eax, edx;
+  __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+  return ((uint64_t)edx << 32) | eax;
+}
+
+isa_t detect_isa(void) {
+  unsigned int eax, ebx, ecx, edx;
+
+  if(!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) {
+    return ISA_SCALAR;
+  }
+  const unsigned int avx_fma = CPUID_OSXSAVE | CPUID_AVX | CPUID_FMA;
+  if((ecx & avx_fma) != avx_fma) {
+    return ISA_SCALAR;
+  }
+  const uint64_t xcr0 = read_xcr0();
+  if((xcr0 & XCR0_YMM) != XCR0_YMM) {
+    return ISA_SCALAR;
+  }
+
+  if(!__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx) || !(ebx & CPUID_AVX2)) {
+    return ISA_SCALAR;
+  }
+  if((ebx & CPUID_AVX512F) && (xcr0 & XCR0_ZMM) == XCR0_ZMM) {
+    return ISA_AVX512;
+  }
+  return ISA_AVX2;
+}
+
+isa_t resolve_isa(const char *const request, isa_t detected) {
+  if(!request) {
+    return detected;
+  }
+
+  isa_t requested;
+  if(strcmp(request, "scalar") == 0) {
+    requested = ISA_SCALAR;
+  } else if(strcmp(request, "avx2") == 0) {
+    requested = ISA_AVX2;
+  } else if(strcmp(request, "avx512") == 0) {
+    requested = ISA_AVX512;
+  } else {
+    fprintf(stderr, "Unknown instruction set '%s', using %s\n", request, isa_name(detected));
+    return detected;
+  }
+
+  if(requested > detected) {
+    fprintf(stderr, "Instruction set %s is not supported by this CPU, using %s\n",
+            request, isa_name(detected));
+    return detected;
+  }
+  return requested;
+}
+
+isa_t active_isa(void) {
+  static int resolved = 0;
+  static isa_t isa = ISA_SCALAR;
+
+  if(!resolved) {
+    isa = resolve_isa(getenv("FASTCODE_ISA"), detect_isa());
+    resolved = 1;
+  }
+  return isa;
+}
+
+const char *isa_name(isa_t isa) {
+  switch(isa) {
+    case ISA_AVX512: return "avx512";
+    case ISA_AVX2:   return "avx2";
+    default:         return "scalar";
+  }
+}
+
+size_t detect_cache_size(unsigned level) {
+  long size = -1;
+  switch(level) {
+#ifdef _SC_LEVEL1_DCACHE_SIZE
+    case 1: size = sysconf(_SC_LEVEL1_DCACHE_SIZE); break;
+#endif
+#ifdef _SC_LEVEL2_CACHE_SIZE
+    case 2: size = sysconf(_SC_LEVEL2_CACHE_SIZE); break;
+#endif
+    default: break;
+  }
+  return size > 0 ? (size_t)size : 0;
+}
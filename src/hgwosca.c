@@ -9,6 +9,8 @@
 #include <string.h>
 
 #include "hgwosca.h"
+#include "objectives.h"
+#include "rng.h"
 #include "utils.h"
 
 #ifndef SIZE_MAX
@@ -20,17 +22,13 @@
    Initialise population of `wolf_count` wolves, each with `dim` dimensions, where
    each dimension is bound by `min_positions` and `max_positions`.
  */
-void gwo_init_population(float* const population,
+void gwo_init_population(rng_t *const rng,
+                         float* const population,
                          size_t wolf_count,
                          size_t dim,
                          const float min_position,
                          const float max_position) {
-  for (size_t wolf = 0; wolf < wolf_count; wolf++) {
-    for (size_t dimension = 0; dimension < dim; dimension++) {
-      size_t idx = wolf * dim + dimension;
-      population[idx] = random_min_max(min_position, max_position);
-    }
-  }
+  rng_uniform(rng, population, wolf_count * dim, min_position, max_position);
 }
 
 
@@ -41,9 +39,7 @@ void gwo_update_fitness(size_t wolf_count,
                         size_t dim,
                         obj_func_t obj_func,
                         float *const population, float *const fitness) {
-  for (size_t wolf = 0; wolf < wolf_count; wolf++) {
-    fitness[wolf] = (*obj_func)(&population[wolf * dim], dim);
-  }
+  obj_eval_batch(obj_func, population, wolf_count, dim, fitness);
 }
 
 
@@ -87,15 +83,16 @@ void gwo_init_fitness(float *const fitness,
 
 /**
    Get recommended position of `dimension` for `wolf` with respect to `leader`, for a given
-   value of `a`.
+   value of `a`, drawing the `GWO_LEADER_RANDS` random numbers in [0, 1) from `rands`.
    TODO: test
  */
 float gwo_get_wolf_pos_update_dim_leader(size_t dimension,
                                           float a,
                                           const float *const wolf,
-                                          const float *const leader_pos) {
-  float r1 = random_0_to_1();
-  float r2 = random_0_to_1();
+                                          const float *const leader_pos,
+                                          const float *const rands) {
+  float r1 = rands[0];
+  float r2 = rands[1];
   float A = 2 * a * r1 - a;                // see equation 3.3
   float C = 2 * r2;                        // see equation 3.4
   float D = fabs(C * leader_pos[dimension] - wolf[dimension]);     // see equation 3.1
@@ -105,22 +102,24 @@ float gwo_get_wolf_pos_update_dim_leader(size_t dimension,
 
 /**
    Get recommended position of `dimension` for `wolf` with respect to the alpha, for a given
-   value of `a`. See equ (12) on the Hybrid paper.
+   value of `a`, drawing the `GWO_ALPHA_RANDS` random numbers in [0, 1) from `rands`.
+   See equ (12) on the Hybrid paper.
    TODO: test
  */
 float gwo_get_wolf_pos_update_dim_alpha(size_t dimension,
                                          float a,
                                          const float *const wolf,
-                                         const float *const alpha_pos) {
-  float r1 = random_0_to_1();
-  float r2 = random_0_to_1();
+                                         const float *const alpha_pos,
+                                         const float *const rands) {
+  float r1 = rands[0];
+  float r2 = rands[1];
   float A = 2 * a * r1 - a;                // see equation 3.3
   float C = 2 * r2;                        // see equation 3.4
   float D;
-  if (random_0_to_1() < 0.5) {
-    D = random_0_to_1() * sin(random_0_to_1()) * fabs(C * alpha_pos[dimension] - wolf[dimension]);
+  if (rands[2] < 0.5) {
+    D = rands[3] * sin(rands[4]) * fabs(C * alpha_pos[dimension] - wolf[dimension]);
   } else {
-    D = random_0_to_1() * cos(random_0_to_1()) * fabs(C * alpha_pos[dimension] - wolf[dimension]);
+    D = rands[3] * cos(rands[4]) * fabs(C * alpha_pos[dimension] - wolf[dimension]);
   }
   return alpha_pos[dimension] - A * D;
 }
@@ -128,7 +127,7 @@ float gwo_get_wolf_pos_update_dim_alpha(size_t dimension,
 
 /**
    Update the position of `wolf` with respect to leaders `alpha`, `beta`, and `delta`, for a
-   given value of `a`.
+   given value of `a`, with the `GWO_WOLF_RANDS * dim` random numbers in `rands`.
    TODO: test
  */
 void gwo_update_wolf_position(size_t dim,
@@ -136,12 +135,16 @@ void gwo_update_wolf_position(size_t dim,
                               float *const wolf,
                               const float *const alpha_pos,
                               const float *const beta_pos,
-                              const float *const delta_pos) {
+                              const float *const delta_pos,
+                              const float *const rands) {
   for (size_t idx = 0; idx < dim; idx++) {
+    const float *const dim_rands = &rands[idx * GWO_WOLF_RANDS];
     float new_pos = 0.0;
-    new_pos += gwo_get_wolf_pos_update_dim_alpha(idx, a, wolf, alpha_pos);
-    new_pos += gwo_get_wolf_pos_update_dim_leader(idx, a, wolf, beta_pos);
-    new_pos += gwo_get_wolf_pos_update_dim_leader(idx, a, wolf, delta_pos);
+    new_pos += gwo_get_wolf_pos_update_dim_alpha(idx, a, wolf, alpha_pos, dim_rands);
+    new_pos += gwo_get_wolf_pos_update_dim_leader(idx, a, wolf, beta_pos,
+                                                  &dim_rands[GWO_ALPHA_RANDS]);
+    new_pos += gwo_get_wolf_pos_update_dim_leader(idx, a, wolf, delta_pos,
+                                                  &dim_rands[GWO_ALPHA_RANDS + GWO_LEADER_RANDS]);
     wolf[idx] = new_pos / 3;
   }
 }
@@ -151,7 +154,8 @@ void gwo_update_wolf_position(size_t dim,
    Update the positions of all wolves.
    TODO: test
  */
-void gwo_update_all_positions(size_t wolf_count,
+void gwo_update_all_positions(rng_t *const rng,
+                              size_t wolf_count,
                               size_t dim,
                               float a,
                               float *const population,
@@ -159,12 +163,17 @@ void gwo_update_all_positions(size_t wolf_count,
   const float *const alpha_pos = &population[alpha * dim];
   const float *const beta_pos = &population[beta * dim];
   const float *const delta_pos = &population[delta * dim];
+  float *const rands = (float*)malloc(GWO_WOLF_RANDS * dim * sizeof(float));
+  if (!rands) { perror("malloc arr"); exit(EXIT_FAILURE); };
   for (size_t wolf = 0; wolf < wolf_count; wolf++) {
     if (wolf == alpha || wolf == beta || wolf == delta) {
       continue;
     }
-    gwo_update_wolf_position(dim, a, &population[wolf * dim], alpha_pos, beta_pos, delta_pos);
+    // all random numbers of the wolf in one bulk fill
+    rng_uniform(rng, rands, GWO_WOLF_RANDS * dim, 0.0, 1.0);
+    gwo_update_wolf_position(dim, a, &population[wolf * dim], alpha_pos, beta_pos, delta_pos, rands);
   }
+  free(rands);
 }
 
 
@@ -224,12 +233,13 @@ float *gwo_hgwosca(obj_func_t obj_func,
                     size_t max_iterations,
                     const float min_position,
                     const float max_position) {
-  srand(100);
+  rng_t rng;
+  rng_seed(&rng, 100);
 
   // float population[wolf_count * dim];
   size_t sizeof_population = wolf_count * dim * sizeof(float);
   float* population = (float*)malloc(sizeof_population);
-  gwo_init_population(population, wolf_count, dim, min_position, max_position);
+  gwo_init_population(&rng, population, wolf_count, dim, min_position, max_position);
 
   // float fitness[wolf_count];
   float* fitness = (float*)malloc(wolf_count*sizeof(float));
@@ -245,7 +255,7 @@ float *gwo_hgwosca(obj_func_t obj_func,
   for (size_t iter = 0; iter < max_iterations; iter++) {
     gwo_update_leaders(wolf_count, fitness, &alpha, &beta, &delta);
     float a = 2 - iter * ((float) 2 / max_iterations);
-    gwo_update_all_positions(wolf_count, dim, a, population, alpha, beta, delta);
+    gwo_update_all_positions(&rng, wolf_count, dim, a, population, alpha, beta, delta);
     gwo_clamp_all_positions(wolf_count, dim, population, min_position, max_position);
     gwo_update_fitness(wolf_count, dim, obj_func, population, fitness);
 
@@ -0,0 +1,211 @@
+/**
+   Hybrid Grey Wolf Optimiser with Sine Cosine Algorithm on AVX2, 8 dimensions of a wolf
+   at a time and the wolves split across threads.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <immintrin.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "hgwosca.h"
+#include "rng.h"
+#include "simd_math.h"
+#include "utils.h"
+
+
+/**
+   Recommended position with respect to `leader`, equations 3.1 to 3.3, for 8 dimensions.
+ */
+static inline __m256 gwo_simd_leader_pos(const __m256 a, const __m256 wolf, const __m256 leader,
+                                         const __m256 r1, const __m256 r2) {
+  const __m256 ones = _mm256_set1_ps(1.0);
+  const __m256 twos = _mm256_set1_ps(2.0);
+  const __m256 sign_mask = _mm256_set1_ps(-0.0);
+  const __m256 A = _mm256_mul_ps(a, _mm256_fmsub_ps(twos, r1, ones));
+  const __m256 C = _mm256_mul_ps(twos, r2);
+  const __m256 D = _mm256_andnot_ps(sign_mask, _mm256_fmsub_ps(C, leader, wolf));
+  return _mm256_fnmadd_ps(A, D, leader);
+}
+
+void gwo_simd_update_wolf_position(size_t simd_dim,
+                                   float a,
+                                   __m256 *const wolf,
+                                   const __m256 *const alpha_pos,
+                                   const __m256 *const beta_pos,
+                                   const __m256 *const delta_pos,
+                                   const float *const rands) {
+  const __m256 v_a = _mm256_set1_ps(a);
+  const __m256 ones = _mm256_set1_ps(1.0);
+  const __m256 twos = _mm256_set1_ps(2.0);
+  const __m256 halves = _mm256_set1_ps(0.5);
+  const __m256 thirds = _mm256_set1_ps(1.0 / 3.0);
+  const __m256 sign_mask = _mm256_set1_ps(-0.0);
+  const size_t stride = simd_dim * 8;
+
+  for (size_t idx = 0; idx < simd_dim; idx++) {
+    const float *const dim_rands = &rands[idx * 8];
+    __m256 r[GWO_WOLF_RANDS];
+    for (size_t draw = 0; draw < GWO_WOLF_RANDS; draw++) {
+      r[draw] = _mm256_loadu_ps(&dim_rands[draw * stride]);
+    }
+
+    // alpha, equation 12 of the hybrid paper: sine or cosine by a coin flip
+    __m256 sin_r, cos_r;
+    simd_sincos(r[4], &sin_r, &cos_r);
+    const __m256 trig = _mm256_blendv_ps(cos_r, sin_r, _mm256_cmp_ps(r[2], halves, _CMP_LT_OQ));
+    const __m256 A = _mm256_mul_ps(v_a, _mm256_fmsub_ps(twos, r[0], ones));
+    const __m256 C = _mm256_mul_ps(twos, r[1]);
+    const __m256 dist = _mm256_andnot_ps(sign_mask, _mm256_fmsub_ps(C, alpha_pos[idx], wolf[idx]));
+    const __m256 D = _mm256_mul_ps(_mm256_mul_ps(r[3], trig), dist);
+    __m256 new_pos = _mm256_fnmadd_ps(A, D, alpha_pos[idx]);
+
+    new_pos = _mm256_add_ps(new_pos, gwo_simd_leader_pos(v_a, wolf[idx], beta_pos[idx],
+                                                         r[GWO_ALPHA_RANDS],
+                                                         r[GWO_ALPHA_RANDS + 1]));
+    new_pos = _mm256_add_ps(new_pos, gwo_simd_leader_pos(v_a, wolf[idx], delta_pos[idx],
+                                                         r[GWO_ALPHA_RANDS + GWO_LEADER_RANDS],
+                                                         r[GWO_ALPHA_RANDS + GWO_LEADER_RANDS + 1]));
+    wolf[idx] = _mm256_mul_ps(new_pos, thirds);
+  }
+}
+
+/**
+   Clamp `wolf` into [`min_pos`, `max_pos`] and zero the lanes past `dim`.
+ */
+static inline void gwo_simd_clamp_wolf(__m256 *const wolf, size_t simd_dim,
+                                       const __m256 min_pos, const __m256 max_pos,
+                                       const __m256 tail) {
+  for (size_t idx = 0; idx < simd_dim; idx++) {
+    wolf[idx] = _mm256_min_ps(_mm256_max_ps(wolf[idx], min_pos), max_pos);
+  }
+  wolf[simd_dim - 1] = _mm256_and_ps(wolf[simd_dim - 1], tail);
+}
+
+
+/**
+   Run the Hybrid Grey Wolf Optimiser with Sine Cosine Algorithm on `n_threads` threads,
+   0 uses the OpenMP default. Every thread updates a contiguous slice of the wolves with its
+   own random stream, so the result depends on the number of threads.
+
+   Returns:
+     The position minimising the objective function. This array has size `dim`.
+ */
+float *gwo_hgwosca_parallel(simd_obj_func_t obj_func,
+                            size_t wolf_count,
+                            size_t dim,
+                            size_t max_iterations,
+                            const float min_position,
+                            const float max_position,
+                            size_t n_threads) {
+  if (n_threads == 0) {
+    n_threads = default_num_threads();
+  }
+  const size_t simd_dim = (dim + 7) / 8;
+  const size_t n_rands = GWO_WOLF_RANDS * simd_dim * 8;
+
+  rng_stream_t *rngs = rng_alloc_streams(n_threads, 100);
+
+  __m256 *population = (__m256*)aligned_alloc(sizeof(__m256),
+                                              wolf_count * simd_dim * sizeof(__m256));
+  float *fitness = (float*)malloc(wolf_count * sizeof(float));
+  // random numbers of the wolf every thread updates, one row of `simd_dim * 8` per draw
+  float *rands = (float*)aligned_alloc(sizeof(__m256), n_threads * n_rands * sizeof(float));
+  if (!population || !fitness || !rands) { perror("malloc arr"); exit(EXIT_FAILURE); };
+
+  const __m256 min_pos = _mm256_set1_ps(min_position);
+  const __m256 max_pos = _mm256_set1_ps(max_position);
+  const __m256 tail = _mm256_castsi256_ps(simd_tail_mask(dim));
+  for (size_t wolf = 0; wolf < wolf_count; wolf++) {
+    float *const position = (float*)&population[wolf * simd_dim];
+    rng_uniform(&rngs[0].rng, position, simd_dim * 8, min_position, max_position);
+    population[(wolf + 1) * simd_dim - 1] = _mm256_and_ps(population[(wolf + 1) * simd_dim - 1], tail);
+  }
+
+  size_t alpha = 0, beta = 0, delta = 0;
+
+  #pragma omp parallel num_threads(n_threads)
+  {
+#ifdef _OPENMP
+    size_t thread = (size_t)omp_get_thread_num();
+    size_t team_size = (size_t)omp_get_num_threads();
+#else
+    size_t thread = 0;
+    size_t team_size = 1;
+#endif
+    size_t begin = wolf_count * thread / team_size;
+    size_t end = wolf_count * (thread + 1) / team_size;
+    rng_t *const rng = &rngs[thread].rng;
+    float *const wolf_rands = &rands[thread * n_rands];
+
+    for (size_t wolf = begin; wolf < end; wolf++) {
+      fitness[wolf] = obj_func(&population[wolf * simd_dim], dim);
+    }
+    #pragma omp barrier
+
+    for (size_t iter = 0; iter < max_iterations; iter++) {
+      #pragma omp single
+      gwo_update_leaders(wolf_count, fitness, &alpha, &beta, &delta);
+      // implicit barrier, all threads see the leaders
+
+      float a = 2 - iter * ((float) 2 / max_iterations);
+      const __m256 *const alpha_pos = &population[alpha * simd_dim];
+      const __m256 *const beta_pos = &population[beta * simd_dim];
+      const __m256 *const delta_pos = &population[delta * simd_dim];
+
+      // the leaders keep their position, every other wolf only reads them
+      for (size_t wolf = begin; wolf < end; wolf++) {
+        if (wolf != alpha && wolf != beta && wolf != delta) {
+          rng_uniform(rng, wolf_rands, n_rands, 0.0, 1.0);
+          gwo_simd_update_wolf_position(simd_dim, a, &population[wolf * simd_dim],
+                                        alpha_pos, beta_pos, delta_pos, wolf_rands);
+          gwo_simd_clamp_wolf(&population[wolf * simd_dim], simd_dim, min_pos, max_pos, tail);
+        }
+        fitness[wolf] = obj_func(&population[wolf * simd_dim], dim);
+      }
+      #pragma omp barrier
+    }
+  }
+
+  gwo_update_leaders(wolf_count, fitness, &alpha, &beta, &delta);
+  float *const best_solution = (float *const) malloc(dim * sizeof(float));
+  memcpy(best_solution, &population[alpha * simd_dim], dim * sizeof(float));
+
+  free(rngs);
+  free(population);
+  free(fitness);
+  free(rands);
+
+  return best_solution;
+}
+
+/**
+   Hybrid Grey Wolf Optimiser with Sine Cosine Algorithm on AVX2, single threaded.
+ */
+float *gwo_hgwosca_simd(simd_obj_func_t obj_func,
+                        size_t wolf_count,
+                        size_t dim,
+                        size_t max_iterations,
+                        const float min_position,
+                        const float max_position) {
+  return gwo_hgwosca_parallel(obj_func, wolf_count, dim, max_iterations,
+                              min_position, max_position, 1);
+}
+
+/**
+   Hybrid Grey Wolf Optimiser with Sine Cosine Algorithm on AVX2 and the default number of
+   threads.
+ */
+float *gwo_hgwosca_simd_mt(simd_obj_func_t obj_func,
+                           size_t wolf_count,
+                           size_t dim,
+                           size_t max_iterations,
+                           const float min_position,
+                           const float max_position) {
+  return gwo_hgwosca_parallel(obj_func, wolf_count, dim, max_iterations,
+                              min_position, max_position, 0);
+}
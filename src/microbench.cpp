@@ -0,0 +1,282 @@
+#include <iostream>
+#include <limits>
+#include <algorithm>
+#include <cstdlib>
+#include <cmath>
+#include <vector>
+
+#include "tsc_x86.h"
+#include "microbench.h"
+#include "dispatch.h"
+
+#include "objectives.h"
+#include "pso.h"
+#include "pso_aosoa.h"
+#include "pso_fused.h"
+#include "simd_math.h"
+
+
+microbench_map_t create_microbench_map() {
+
+  // Register more micro benchmarks here as they get implemented.
+  microbench_map_t bench_map = {{"pso_layout", &bench_pso_layout},
+                                 {"pso_tiling", &bench_pso_tiling},
+                                 {"pso_fused", &bench_pso_fused},
+                                 {"rng", &bench_rng},
+                                 {"simd_math", &bench_simd_math},
+                                 {"unroll", &bench_unroll}};
+  return bench_map;
+}
+
+
+void bench_pso_layout(std::ostream &out, int n_repetitions) {
+  if (active_isa() < ISA_AVX2) {
+    std::cerr << "pso_layout needs AVX2" << std::endl;
+    return;
+  }
+
+  const size_t dim = 64;
+  const size_t n_iter = 4;
+  // 768KB, 12MB and 48MB of position, velocity and local best
+  const size_t swarm_sizes[] = {1024, 16384, 65536};
+  // 0 stands for the separate arrays of pso_ctx_t
+  const size_t block_sizes[] = {0, 1, 2, 4, 8};
+
+  out << "layout,block_size,swarm_size,dim,cycles_per_particle" << std::endl;
+  for (size_t swarm_size : swarm_sizes) {
+    for (size_t block_size : block_sizes) {
+      timeInt64 best = std::numeric_limits<timeInt64>::max();
+      for (int rep = 0; rep < n_repetitions; ++rep) {
+        timeInt64 cycles;
+        if (block_size == 0) {
+          pso_ctx_t *ctx = pso_create(opt_simd_sum_of_squares, swarm_size, dim, -10, 10, 1, rep);
+          timeInt64 start_time = start_tsc();
+          pso_step(ctx, n_iter);
+          cycles = stop_tsc(start_time);
+          pso_destroy(ctx);
+        } else {
+          pso_aosoa_ctx_t *ctx = pso_aosoa_create(opt_simd_sum_of_squares, swarm_size, dim, -10, 10,
+                                                  block_size, 1, rep);
+          timeInt64 start_time = start_tsc();
+          pso_aosoa_step(ctx, n_iter);
+          cycles = stop_tsc(start_time);
+          pso_aosoa_destroy(ctx);
+        }
+        best = std::min(best, cycles);
+      }
+      out << (block_size == 0 ? "soa" : "aosoa") << "," << block_size << "," << swarm_size << ","
+          << dim << "," << (double)best / (double)(n_iter * swarm_size) << std::endl;
+    }
+  }
+}
+
+
+void bench_pso_tiling(std::ostream &out, int n_repetitions) {
+  if (active_isa() < ISA_AVX2) {
+    std::cerr << "pso_tiling needs AVX2" << std::endl;
+    return;
+  }
+
+  const size_t swarm_size = 32;
+  const size_t n_iter = 2;
+  const size_t dims[] = {1024, 4096, 16384, 65536, 131072};
+  const size_t detected = pso_tile_vectors(detect_cache_size(1), detect_cache_size(2));
+  // 0 stands for whole particles, one pass each for velocity, position and objective
+  const size_t tile_sizes[] = {0, 16, 64, detected, 512};
+
+  out << "objective,tile_vectors,swarm_size,dim,cycles_per_dimension" << std::endl;
+  for (simd_obj_func_t obj_func : {opt_simd_sum_of_squares, opt_simd_rosenbrock}) {
+    for (size_t dim : dims) {
+      for (size_t tile_vectors : tile_sizes) {
+        timeInt64 best = std::numeric_limits<timeInt64>::max();
+        for (int rep = 0; rep < n_repetitions; ++rep) {
+          pso_ctx_t *ctx = pso_create(obj_func, swarm_size, dim, -10, 10, 1, rep);
+          if (tile_vectors > 0) {
+            pso_use_tiled_objective(ctx, opt_simd_tile_variant(obj_func), tile_vectors);
+          }
+          timeInt64 start_time = start_tsc();
+          pso_step(ctx, n_iter);
+          best = std::min(best, stop_tsc(start_time));
+          pso_destroy(ctx);
+        }
+        out << (obj_func == opt_simd_rosenbrock ? "rosenbrock" : "sum_of_squares") << ","
+            << tile_vectors << "," << swarm_size << "," << dim << ","
+            << (double)best / (double)(n_iter * swarm_size * dim) << std::endl;
+      }
+    }
+  }
+}
+
+
+void bench_pso_fused(std::ostream &out, int n_repetitions) {
+  if (active_isa() < ISA_AVX2) {
+    std::cerr << "pso_fused needs AVX2" << std::endl;
+    return;
+  }
+
+  const size_t swarm_size = 1024;
+  const size_t n_iter = 4;
+  const size_t dims[] = {8, 32, 128, 512, 2048};
+
+  out << "objective,update,swarm_size,dim,cycles_per_dimension" << std::endl;
+  for (simd_obj_func_t obj_func : {opt_simd_sum_of_squares, opt_simd_rosenbrock}) {
+    for (size_t dim : dims) {
+      for (bool fused : {false, true}) {
+        timeInt64 best = std::numeric_limits<timeInt64>::max();
+        for (int rep = 0; rep < n_repetitions; ++rep) {
+          pso_ctx_t *ctx = pso_create(obj_func, swarm_size, dim, -10, 10, 1, rep);
+          if (fused) {
+            pso_use_update(ctx, pso_fused_update_dim(obj_func, dim));
+          }
+          timeInt64 start_time = start_tsc();
+          pso_step(ctx, n_iter);
+          best = std::min(best, stop_tsc(start_time));
+          pso_destroy(ctx);
+        }
+        out << (obj_func == opt_simd_rosenbrock ? "rosenbrock" : "sum_of_squares") << ","
+            << (fused ? "fused" : "generic") << "," << swarm_size << "," << dim << ","
+            << (double)best / (double)(n_iter * swarm_size * dim) << std::endl;
+      }
+    }
+  }
+}
+
+
+void bench_rng(std::ostream &out, int n_repetitions) {
+  if (active_isa() < ISA_AVX2) {
+    std::cerr << "rng needs AVX2" << std::endl;
+    return;
+  }
+
+  // 32KB of output stays in L1, so the generators are timed and not the stores
+  const size_t n_vectors = 1024;
+  const size_t n_fills = 256;
+  __m256 *const buffer = (__m256 *)aligned_alloc(sizeof(__m256), n_vectors * sizeof(__m256));
+  simd_rng_t rng;
+  seed_simd_rng(&rng, 1, 100);
+
+  out << "generator,chains,vectors_per_cycle" << std::endl;
+  // 0 chains stands for the Philox counters
+  for (size_t n_chains : {1, 2, 4, 0}) {
+    timeInt64 best = std::numeric_limits<timeInt64>::max();
+    for (int rep = 0; rep < n_repetitions; ++rep) {
+      timeInt64 start_time = start_tsc();
+      for (size_t fill = 0; fill < n_fills; ++fill) {
+        if (n_chains == 0) {
+          simd_philox_fill(100, fill * n_vectors / 4, buffer, n_vectors);
+        } else {
+          simd_rand_fill(&rng, buffer, n_vectors, n_chains);
+        }
+      }
+      best = std::min(best, stop_tsc(start_time));
+    }
+    out << (n_chains == 0 ? "philox" : "xorshift") << "," << n_chains << ","
+        << (double)(n_fills * n_vectors) / (double)best << std::endl;
+  }
+
+  free(buffer);
+}
+
+
+void bench_simd_math(std::ostream &out, int n_repetitions) {
+  if (active_isa() < ISA_AVX2) {
+    std::cerr << "simd_math needs AVX2" << std::endl;
+    return;
+  }
+
+  // 16KB in and out stay in L1, so the math is timed and not the loads
+  const size_t n = 2048;
+  const size_t n_calls = 64;
+  std::vector<float> in(n), res(n);
+
+  struct math_func {
+    const char *name;
+    float min, max;   // range of the arguments
+    float (*scalar)(float);
+    void (*simd)(const float *, float *, size_t);
+  };
+  const math_func funcs[] = {
+    {"sin", -10, 10, [](float x) { return std::sin(x); }, simd_sin_array},
+    {"cos", -10, 10, [](float x) { return std::cos(x); }, simd_cos_array},
+    {"exp", -10, 10, [](float x) { return std::exp(x); }, simd_exp_array},
+    {"log", 1e-3, 1e3, [](float x) { return std::log(x); }, simd_log_array},
+    {"pow", 1e-3, 1e3, [](float x) { return std::pow(x, 1.7724539f); },
+     [](const float *x, float *res, size_t n) { simd_pow_array(x, 1.7724539f, res, n); }}};
+
+  out << "function,implementation,elements_per_cycle" << std::endl;
+  for (const math_func &func : funcs) {
+    for (size_t idx = 0; idx < n; ++idx) {
+      in[idx] = func.min + (func.max - func.min) * (float)idx / (float)n;
+    }
+    for (bool simd : {false, true}) {
+      timeInt64 best = std::numeric_limits<timeInt64>::max();
+      for (int rep = 0; rep < n_repetitions; ++rep) {
+        timeInt64 start_time = start_tsc();
+        for (size_t call = 0; call < n_calls; ++call) {
+          if (simd) {
+            func.simd(in.data(), res.data(), n);
+          } else {
+            for (size_t idx = 0; idx < n; ++idx) {
+              res[idx] = func.scalar(in[idx]);
+            }
+          }
+        }
+        best = std::min(best, stop_tsc(start_time));
+      }
+      out << func.name << "," << (simd ? "simd" : "libm") << ","
+          << (double)(n_calls * n) / (double)best << std::endl;
+    }
+  }
+}
+
+
+/**
+ * Calls `obj_func` `n_calls` times. Compiled for AVX2 like its callees: they return without
+ * clearing the upper halves of the registers, which would slow down an SSE caller.
+ */
+__attribute__((target("avx2,fma")))
+static float call_objective(simd_obj_func_t obj_func, const __m256 *args, size_t dim, size_t n_calls) {
+  float sum = 0;
+  for (size_t call = 0; call < n_calls; ++call) {
+    sum += obj_func(args, dim);
+  }
+  return sum;
+}
+
+void bench_unroll(std::ostream &out, int n_repetitions) {
+  if (active_isa() < ISA_AVX2) {
+    std::cerr << "unroll needs AVX2" << std::endl;
+    return;
+  }
+
+  // from L1 resident to L2 exceeding particles
+  const size_t dims[] = {256, 1024, 4096, 32768, 262144};
+  const size_t max_vectors = 262144 / 8;
+  __m256 *const args = (__m256 *)aligned_alloc(sizeof(__m256), max_vectors * sizeof(__m256));
+  float *const values = (float *)args;
+  for (size_t idx = 0; idx < 8 * max_vectors; ++idx) {
+    values[idx] = 1.0f / (float)(idx % 7 + 1);
+  }
+  volatile float sink = 0;
+
+  out << "objective,accumulators,tuned,dim,cycles_per_vector" << std::endl;
+  for (simd_obj_func_t obj_func : {opt_simd_sum_of_squares, opt_simd_rosenbrock}) {
+    for (size_t dim : dims) {
+      const size_t n_calls = 1048576 / dim + 1;
+      for (size_t unroll : {1, 4, 8}) {
+        simd_obj_func_t unrolled = opt_simd_unrolled(obj_func, unroll);
+        timeInt64 best = std::numeric_limits<timeInt64>::max();
+        for (int rep = 0; rep < n_repetitions; ++rep) {
+          timeInt64 start_time = start_tsc();
+          sink = sink + call_objective(unrolled, args, dim, n_calls);
+          best = std::min(best, stop_tsc(start_time));
+        }
+        out << (obj_func == opt_simd_rosenbrock ? "rosenbrock" : "sum_of_squares") << ","
+            << unroll << "," << (unroll == opt_simd_unroll_factor(obj_func, dim)) << "," << dim << ","
+            << (double)best / (double)(n_calls * dim / 8) << std::endl;
+      }
+    }
+  }
+
+  free(args);
+}
@@ -2,8 +2,8 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <float.h>
-#include <immintrin.h>
 
+#include "dispatch.h"
 #include "objectives.h"
 #include "utils.h"
 
@@ -11,56 +11,11 @@
 #define M_PI (3.14159265358979323846)
 #endif
 
-__m256 ones;
-__m256 cent;
-
 
 /*******************************************************************************
   IMPLEMENTATIONS OF OBJECTIVE FUNCTIONS TO TEST ALGORITHMS
 ******************************************************************************/
 
-/**
-   Initialise globals for objective functions. Must be called before the first
-   call to an objective function.
- */
-void init_obj_globals() {
-  ones = _mm256_set1_ps(1.0);
-  cent = _mm256_set1_ps(100.0);
-}
-
-/**
- * Sum of squares SIMD function
- * optimal solution is 0s everywhere
- */
- float opt_simd_sum_of_squares(const __m256* args, size_t simd_dim) {
-  __m256 v_sum = _mm256_setzero_ps();
-  for(size_t idx = 0; idx < simd_dim; idx++){
-    v_sum = _mm256_fmadd_ps(args[idx], args[idx], v_sum);
-  }
-  float sum = horizontal_add(v_sum);
-  return sum;
- }
-
-float simd_sum_of_squares(const float *const args, size_t dim) {
-  __m256 v_sum = _mm256_setzero_ps();
-  size_t idx = 0;
-
-  if(dim > 7) {
-    __m256 v_args;
-    for(; idx < dim - 8; idx += 8) {
-      v_args = _mm256_loadu_ps(&args[idx]);
-      v_sum = _mm256_fmadd_ps(v_args, v_args, v_sum);
-    }
-  }
-
-  float sum = horizontal_add(v_sum);
-  for(; idx < dim; idx++) {
-    sum += args[idx] * args[idx];
-  }
-
-  return sum;
-}
-
 float sum_of_squares(const float *const args, size_t dim) {
   float sum = 0;
   size_t idx = 0;
@@ -109,61 +64,6 @@ float rosenbrock(const float *const args, size_t dim) {
   return rNd;
 }
 
-float simd_rosenbrock(const float *const args, size_t dim) {
-  float rNd = 0.0;
-  __m256 res = _mm256_setzero_ps();
-
-  size_t idx = 0;
-  if (dim > 8) {
-    for (idx; idx < dim - 9; idx+=8){
-      // printf("this is inside the loop\n" );
-      __m256 pos = _mm256_loadu_ps(&args[idx]);
-      __m256 pos_p1 = _mm256_loadu_ps(&args[idx+1]);
-      __m256 r1 = _mm256_fmsub_ps(pos,pos,pos_p1);
-      r1 = _mm256_mul_ps(r1,r1);
-      r1 = _mm256_mul_ps(cent,r1);
-      __m256 temp = _mm256_sub_ps(ones,pos);
-      res = _mm256_add_ps(res, _mm256_fmadd_ps(temp,temp,r1));
-    }
-    rNd = horizontal_add(res);
-  }
-  for (; idx < dim - 1; idx++){
-    rNd += (100.0 * (+pow(args[idx + 1] - pow(args[idx], 2), 2)) + pow(1 - args[idx], 2));
-  }
-  return rNd;
-}
-
-
-float opt_simd_rosenbrock(const __m256* args, size_t simd_dim) {
-  __m256 res = _mm256_setzero_ps();
-  float rNd = 0.0;
-  float tmp[0];
-  __m256i t1,t2;
-  __m256 shift1;
-  for (size_t idx = 0; idx < simd_dim; idx++) {
-    if (idx == simd_dim - 1) {
-      _mm256_storeu_ps(tmp, args[idx]);
-      tmp[7] = 0.0;
-      t1 = _mm256_castps_si256(_mm256_loadu_ps(tmp));
-      t2 = _mm256_setzero_si256();
-    } else {
-      t1 = _mm256_castps_si256(args[idx]);
-      t2 = _mm256_castps_si256(args[idx+1]);
-    }
-    shift1 = _mm256_castsi256_ps(_mm256_alignr_epi8(t1,t2,4));
-    __m256 r1 = _mm256_fmsub_ps(args[idx],args[idx],shift1);
-    r1 = _mm256_mul_ps(r1,r1);
-    r1 = _mm256_mul_ps(cent,r1);
-    __m256 temp = _mm256_sub_ps(ones,args[idx]);
-    res = _mm256_add_ps(res, _mm256_fmadd_ps(temp,temp,r1));
-  }
-  rNd = horizontal_add(res);
-  return rNd;
-}
-
-
-
-
 /**
  * Multi Dimensional Sphere Function
  * global minima at f(x1,.....,xN) = 0 at (x1,......,xN) = (0,......,0)
@@ -252,3 +152,27 @@ float beale(const float *const args, size_t dim) {
   float beal = pow((args[0] * args[1] - args[0] + 1.5), 2) + pow((args[0] * args[1] * args[1] - args[0] + 2.25), 2) + pow((args[0] * args[1] * args[1] * args[1] - args[0] + 2.625), 2);
   return beal;
 }
+
+
+/*******************************************************************************
+  BATCHED EVALUATION, MANY CANDIDATES PER CALL
+******************************************************************************/
+
+batch_obj_func_t batch_variant(obj_func_t obj_func) {
+  if (active_isa() < ISA_AVX2) {
+    return NULL;
+  }
+  return opt_simd_batch_variant(obj_func);
+}
+
+void obj_eval_batch(obj_func_t obj_func, const float *const positions, size_t count, size_t dim,
+                    float *const fitness) {
+  batch_obj_func_t batch_func = batch_variant(obj_func);
+  if (batch_func) {
+    batch_func(positions, count, dim, fitness);
+    return;
+  }
+  for (size_t idx = 0; idx < count; idx++) {
+    fitness[idx] = obj_func(&positions[idx * dim], dim);
+  }
+}
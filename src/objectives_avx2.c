@@ -0,0 +1,690 @@
+#include <math.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <immintrin.h>
+
+#include "objectives.h"
+#include "simd_math.h"
+#include "utils.h"
+
+#ifndef M_PI
+#define M_PI (3.14159265358979323846)
+#endif
+
+
+/*******************************************************************************
+  AVX2 IMPLEMENTATIONS OF OBJECTIVE FUNCTIONS, 8 FLOATS PER VECTOR
+******************************************************************************/
+
+/**
+ * Sum of squares SIMD function
+ * optimal solution is 0s everywhere
+ */
+float opt_simd_sum_of_squares(const __m256* args, size_t dim) {
+  const size_t simd_dim = (dim + 7) / 8;
+  __m256 v_sum = _mm256_setzero_ps();
+  for(size_t idx = 0; idx + 1 < simd_dim; idx++){
+    v_sum = _mm256_fmadd_ps(args[idx], args[idx], v_sum);
+  }
+  // padding lanes of the last vector do not contribute
+  const __m256 last = _mm256_and_ps(args[simd_dim - 1], _mm256_castsi256_ps(simd_tail_mask(dim)));
+  v_sum = _mm256_fmadd_ps(last, last, v_sum);
+  float sum = horizontal_add(v_sum);
+  return sum;
+}
+
+float simd_sum_of_squares(const float *const args, size_t dim) {
+  __m256 v_sum = _mm256_setzero_ps();
+  size_t idx = 0;
+
+  __m256 v_args;
+  for(; idx + 8 <= dim; idx += 8) {
+    v_args = _mm256_loadu_ps(&args[idx]);
+    v_sum = _mm256_fmadd_ps(v_args, v_args, v_sum);
+  }
+  if(idx < dim) {
+    // masked lanes load as zero
+    v_args = _mm256_maskload_ps(&args[idx], simd_tail_mask(dim));
+    v_sum = _mm256_fmadd_ps(v_args, v_args, v_sum);
+  }
+
+  return horizontal_add(v_sum);
+}
+
+float simd_rosenbrock(const float *const args, size_t dim) {
+  const __m256 ones = _mm256_set1_ps(1.0);
+  const __m256 cent = _mm256_set1_ps(100.0);
+  float rNd = 0.0;
+  __m256 res = _mm256_setzero_ps();
+
+  size_t idx = 0;
+  if (dim > 8) {
+    for (idx; idx < dim - 9; idx+=8){
+      // printf("this is inside the loop\n" );
+      __m256 pos = _mm256_loadu_ps(&args[idx]);
+      __m256 pos_p1 = _mm256_loadu_ps(&args[idx+1]);
+      __m256 r1 = _mm256_fmsub_ps(pos,pos,pos_p1);
+      r1 = _mm256_mul_ps(r1,r1);
+      r1 = _mm256_mul_ps(cent,r1);
+      __m256 temp = _mm256_sub_ps(ones,pos);
+      res = _mm256_add_ps(res, _mm256_fmadd_ps(temp,temp,r1));
+    }
+    rNd = horizontal_add(res);
+  }
+  for (; idx < dim - 1; idx++){
+    rNd += (100.0 * (+pow(args[idx + 1] - pow(args[idx], 2), 2)) + pow(1 - args[idx], 2));
+  }
+  return rNd;
+}
+
+
+/**
+ * Multidimensional Rosenbrock SIMD function on padded rows
+ * global minima f(x1,.....,xN) = 0 at (x1,.....,xN) = (1,.....,1)
+ */
+float opt_simd_rosenbrock(const __m256* args, size_t dim) {
+  const __m256 ones = _mm256_set1_ps(1.0);
+  const __m256 cent = _mm256_set1_ps(100.0);
+  // lane i takes lane i + 1 of its own vector, lane 7 takes lane 0 of the next one
+  const __m256i rotate = _mm256_setr_epi32(1, 2, 3, 4, 5, 6, 7, 0);
+  const size_t simd_dim = (dim + 7) / 8;
+  __m256 res = _mm256_setzero_ps();
+
+  // there are dim - 1 terms, the last vector holding terms is masked
+  const size_t n_terms = dim - 1;
+  const size_t term_vecs = (n_terms + 7) / 8;
+  const __m256 term_tail = _mm256_castsi256_ps(simd_tail_mask(n_terms));
+  for (size_t idx = 0; idx < term_vecs; idx++) {
+    __m256 next = idx + 1 < simd_dim ? args[idx + 1] : _mm256_setzero_ps();
+    __m256 shift1 = _mm256_blend_ps(_mm256_permutevar8x32_ps(args[idx], rotate),
+                                    _mm256_permutevar8x32_ps(next, rotate), 0x80);
+    __m256 r1 = _mm256_fmsub_ps(args[idx],args[idx],shift1);
+    r1 = _mm256_mul_ps(r1,r1);
+    r1 = _mm256_mul_ps(cent,r1);
+    __m256 temp = _mm256_sub_ps(ones,args[idx]);
+    __m256 term = _mm256_fmadd_ps(temp,temp,r1);
+    if (idx + 1 == term_vecs) {
+      term = _mm256_and_ps(term, term_tail);
+    }
+    res = _mm256_add_ps(res, term);
+  }
+  return horizontal_add(res);
+}
+
+
+/**
+ * Rastigrin SIMD function on padded rows, the constant 10 * dim is added per lane
+ * optimal solution is 0s everywhere
+ */
+float opt_simd_rastigrin(const __m256* args, size_t dim) {
+  const __m256 ten = _mm256_set1_ps(10.0);
+  const __m256 two_pi = _mm256_set1_ps(2 * M_PI);
+  const size_t simd_dim = (dim + 7) / 8;
+  __m256 res = _mm256_setzero_ps();
+  for (size_t idx = 0; idx < simd_dim; idx++) {
+    // x^2 + 10 - 10 cos(2 pi x)
+    __m256 term = _mm256_fnmadd_ps(ten, simd_cos(_mm256_mul_ps(two_pi, args[idx])), ten);
+    term = _mm256_fmadd_ps(args[idx], args[idx], term);
+    if (idx + 1 == simd_dim) {
+      term = _mm256_and_ps(term, _mm256_castsi256_ps(simd_tail_mask(dim)));
+    }
+    res = _mm256_add_ps(res, term);
+  }
+  return horizontal_add(res);
+}
+
+/**
+ * Multi Dimensional Sphere SIMD function, the sum of squares
+ * global minima at f(x1,.....,xN) = 0 at (x1,......,xN) = (0,......,0)
+ */
+float opt_simd_sphere(const __m256* args, size_t dim) {
+  return opt_simd_sum_of_squares(args, dim);
+}
+
+/**
+ * Product of the 8 lanes of `a`.
+ */
+static inline float horizontal_mul(__m256 a) {
+  __m128 prod = _mm_mul_ps(_mm256_castps256_ps128(a), _mm256_extractf128_ps(a, 1));
+  prod = _mm_mul_ps(prod, _mm_movehl_ps(prod, prod));
+  prod = _mm_mul_ss(prod, _mm_movehdup_ps(prod));
+  return _mm_cvtss_f32(prod);
+}
+
+/**
+ * Griewank SIMD function, like the scalar version the first dimension is left out
+ */
+float opt_simd_griewank(const __m256* args, size_t dim) {
+  const __m256 ones = _mm256_set1_ps(1.0);
+  const size_t simd_dim = (dim + 7) / 8;
+  __m256 sum = _mm256_setzero_ps();
+  __m256 prod = ones;
+  __m256 dimension = _mm256_setr_ps(0, 1, 2, 3, 4, 5, 6, 7);
+  for (size_t idx = 0; idx < simd_dim; idx++) {
+    __m256 valid = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+    if (idx == 0) {
+      valid = _mm256_castsi256_ps(_mm256_setr_epi32(0, -1, -1, -1, -1, -1, -1, -1));
+    }
+    if (idx + 1 == simd_dim) {
+      valid = _mm256_and_ps(valid, _mm256_castsi256_ps(simd_tail_mask(dim)));
+    }
+    const __m256 factor = simd_cos(_mm256_div_ps(args[idx], _mm256_sqrt_ps(dimension)));
+    sum = _mm256_add_ps(sum, _mm256_and_ps(valid, _mm256_mul_ps(args[idx], args[idx])));
+    prod = _mm256_mul_ps(prod, _mm256_blendv_ps(ones, factor, valid));
+    dimension = _mm256_add_ps(dimension, _mm256_set1_ps(8.0));
+  }
+  return horizontal_add(sum) / 4000.0 - horizontal_mul(prod) + 1.0;
+}
+
+/**
+ * Schwefel 1 SIMD function, the sum of squares to the power of sqrt(pi)
+ */
+float opt_simd_schwefel01(const __m256* args, size_t dim) {
+  return pow(opt_simd_sum_of_squares(args, dim), sqrt(M_PI));
+}
+
+/**
+ * Sum of the 4 lanes of `a`.
+ */
+static inline float horizontal_add_128(__m128 a) {
+  a = _mm_add_ps(a, _mm_movehl_ps(a, a));
+  a = _mm_add_ss(a, _mm_movehdup_ps(a));
+  return _mm_cvtss_f32(a);
+}
+
+/**
+ * Powell SIMD function, N = 4, one term per lane of the first 4 dimensions
+ */
+float opt_simd_powel(const __m256* args, size_t dim) {
+  (void)dim;
+  const __m128 x = _mm256_castps256_ps128(args[0]);
+  // x0 + 10 x1, x2 - x3, x1 - 2 x2, x0 - x3
+  const __m128 lhs = _mm_shuffle_ps(x, x, _MM_SHUFFLE(0, 1, 2, 0));
+  const __m128 rhs = _mm_shuffle_ps(x, x, _MM_SHUFFLE(3, 2, 3, 1));
+  const __m128 diff = _mm_fmadd_ps(_mm_setr_ps(10.0, -1.0, -2.0, -1.0), rhs, lhs);
+  const __m128 square = _mm_mul_ps(diff, diff);
+  // the last two terms to the fourth power
+  const __m128 power = _mm_blend_ps(square, _mm_mul_ps(square, square), 0xc);
+  return horizontal_add_128(_mm_mul_ps(_mm_setr_ps(1.0, 5.0, 1.0, 10.0), power));
+}
+
+/**
+ * Freudenstein & Roth SIMD function, N = 2, one term per lane
+ */
+float opt_simd_freundsteinroth(const __m256* args, size_t dim) {
+  (void)dim;
+  const __m128 x0 = _mm_broadcastss_ps(_mm256_castps256_ps128(args[0]));
+  const __m128 x1 = _mm_permute_ps(_mm256_castps256_ps128(args[0]), _MM_SHUFFLE(1, 1, 1, 1));
+  // x0 + d + ((a + b x1) x1 + c) x1, (5 - x1, -2, -13) and (x1 + 1, -14, -29)
+  __m128 term = _mm_fmadd_ps(_mm_setr_ps(-1.0, 1.0, 0.0, 0.0), x1, _mm_setr_ps(5.0, 1.0, 0.0, 0.0));
+  term = _mm_fmadd_ps(term, x1, _mm_setr_ps(-2.0, -14.0, 0.0, 0.0));
+  term = _mm_fmadd_ps(term, x1, _mm_add_ps(x0, _mm_setr_ps(-13.0, -29.0, 0.0, 0.0)));
+  term = _mm_blend_ps(term, _mm_setzero_ps(), 0xc);
+  return horizontal_add_128(_mm_mul_ps(term, term));
+}
+
+/**
+ * Beale SIMD function, N = 2, one term per lane
+ */
+float opt_simd_beale(const __m256* args, size_t dim) {
+  (void)dim;
+  const __m128 x0 = _mm_broadcastss_ps(_mm256_castps256_ps128(args[0]));
+  const __m128 x1 = _mm_permute_ps(_mm256_castps256_ps128(args[0]), _MM_SHUFFLE(1, 1, 1, 1));
+  // x1, x1^2 and x1^3
+  const __m128 x1_sq = _mm_mul_ps(x1, x1);
+  const __m128 powers = _mm_blend_ps(_mm_blend_ps(x1, x1_sq, 0x2), _mm_mul_ps(x1_sq, x1), 0x4);
+  // x0 x1^k - x0 + c
+  __m128 term = _mm_fmsub_ps(x0, powers, x0);
+  term = _mm_add_ps(term, _mm_setr_ps(1.5, 2.25, 2.625, 0.0));
+  term = _mm_blend_ps(term, _mm_setzero_ps(), 0x8);
+  return horizontal_add_128(_mm_mul_ps(term, term));
+}
+
+/**
+ * 2D Eggholder SIMD function, both sines at once
+ * global minima at f(x,y) = -959.6407 at (x,y) = (512,404.2319)
+ */
+float opt_simd_egghol2d(const __m256* args, size_t dim) {
+  (void)dim;
+  float x[8];
+  _mm256_storeu_ps(x, args[0]);
+  const float y = x[1] + 47.0;
+  // sin(sqrt(|x0 + y|)) and sin(sqrt(|x0 - y|))
+  const __m256 arg = _mm256_setr_ps(x[0] + y, x[0] - y, 0, 0, 0, 0, 0, 0);
+  const __m256 abs_arg = _mm256_andnot_ps(_mm256_set1_ps(-0.0f), arg);
+  float sines[8];
+  _mm256_storeu_ps(sines, simd_sin(_mm256_sqrt_ps(abs_arg)));
+  return -y * sines[0] - x[0] * sines[1];
+}
+
+/**
+ * 2D Schaffer SIMD function
+ */
+float opt_simd_schaf2d(const __m256* args, size_t dim) {
+  (void)dim;
+  const __m128 x = _mm256_castps256_ps128(args[0]);
+  const __m128 x_sq = _mm_mul_ps(x, x);
+  const float sq0 = _mm_cvtss_f32(x_sq);
+  const float sq1 = _mm_cvtss_f32(_mm_movehdup_ps(x_sq));
+  const float sine = _mm256_cvtss_f32(simd_sin(_mm256_set1_ps(sq0 - sq1)));
+  const float denom = 1 + 0.001 * (sq0 + sq1);
+  return 0.5 + (sine * sine - 0.5) / (denom * denom);
+}
+
+
+/*******************************************************************************
+  CROSS-PARTICLE IMPLEMENTATIONS, LANE i OF EVERY VECTOR BELONGS TO PARTICLE i
+******************************************************************************/
+
+/**
+ * Sum of squares of 8 particles at once, no horizontal reduction needed
+ */
+void opt_simd_sum_of_squares_lanes(const __m256* lanes, size_t dim, float* fitness) {
+  __m256 v_sum = _mm256_setzero_ps();
+  for(size_t idx = 0; idx < dim; idx++){
+    v_sum = _mm256_fmadd_ps(lanes[idx], lanes[idx], v_sum);
+  }
+  _mm256_storeu_ps(fitness, v_sum);
+}
+
+/**
+ * Rosenbrock of 8 particles at once, neighbouring dimensions are neighbouring vectors
+ */
+void opt_simd_rosenbrock_lanes(const __m256* lanes, size_t dim, float* fitness) {
+  const __m256 ones = _mm256_set1_ps(1.0);
+  const __m256 cent = _mm256_set1_ps(100.0);
+  __m256 res = _mm256_setzero_ps();
+  for (size_t idx = 0; idx + 1 < dim; idx++) {
+    __m256 r1 = _mm256_fmsub_ps(lanes[idx],lanes[idx],lanes[idx + 1]);
+    r1 = _mm256_mul_ps(r1,r1);
+    __m256 temp = _mm256_sub_ps(ones,lanes[idx]);
+    res = _mm256_fmadd_ps(cent, r1, _mm256_fmadd_ps(temp, temp, res));
+  }
+  _mm256_storeu_ps(fitness, res);
+}
+
+/**
+ * Rastigrin of 8 particles at once
+ */
+void opt_simd_rastigrin_lanes(const __m256* lanes, size_t dim, float* fitness) {
+  const __m256 ten = _mm256_set1_ps(10.0);
+  const __m256 two_pi = _mm256_set1_ps(2 * M_PI);
+  __m256 res = _mm256_set1_ps(10.0 * dim);
+  for (size_t idx = 0; idx < dim; idx++) {
+    res = _mm256_fmadd_ps(lanes[idx], lanes[idx], res);
+    res = _mm256_fnmadd_ps(ten, simd_cos(_mm256_mul_ps(two_pi, lanes[idx])), res);
+  }
+  _mm256_storeu_ps(fitness, res);
+}
+
+/**
+ * Griewank of 8 particles at once, the first dimension is left out like in the scalar version
+ */
+void opt_simd_griewank_lanes(const __m256* lanes, size_t dim, float* fitness) {
+  __m256 sum = _mm256_setzero_ps();
+  __m256 prod = _mm256_set1_ps(1.0);
+  for (size_t idx = 1; idx < dim; idx++) {
+    sum = _mm256_fmadd_ps(lanes[idx], lanes[idx], sum);
+    const __m256 scaled = _mm256_div_ps(lanes[idx], _mm256_set1_ps(sqrtf(idx)));
+    prod = _mm256_mul_ps(prod, simd_cos(scaled));
+  }
+  const __m256 res = _mm256_fmadd_ps(sum, _mm256_set1_ps(1.0 / 4000.0), _mm256_set1_ps(1.0));
+  _mm256_storeu_ps(fitness, _mm256_sub_ps(res, prod));
+}
+
+simd_lanes_obj_func_t opt_simd_lanes_variant(simd_obj_func_t obj_func) {
+  if (obj_func == opt_simd_sum_of_squares || obj_func == opt_simd_sphere) {
+    return opt_simd_sum_of_squares_lanes;
+  }
+  if (obj_func == opt_simd_rosenbrock) {
+    return opt_simd_rosenbrock_lanes;
+  }
+  if (obj_func == opt_simd_rastigrin) {
+    return opt_simd_rastigrin_lanes;
+  }
+  if (obj_func == opt_simd_griewank) {
+    return opt_simd_griewank_lanes;
+  }
+  return NULL;
+}
+
+
+/*******************************************************************************
+  PARTIAL IMPLEMENTATIONS, TERMS STARTING IN A RANGE OF VECTORS
+******************************************************************************/
+
+/**
+ * Sum of squares of the vectors [begin, end)
+ */
+__m256 opt_simd_sum_of_squares_tile(const __m256* args, size_t begin, size_t end, size_t dim) {
+  const size_t simd_dim = (dim + 7) / 8;
+  __m256 v_sum = _mm256_setzero_ps();
+  for(size_t idx = begin; idx < end && idx + 1 < simd_dim; idx++){
+    v_sum = _mm256_fmadd_ps(args[idx], args[idx], v_sum);
+  }
+  if(begin < end && end == simd_dim) {
+    const __m256 last = _mm256_and_ps(args[simd_dim - 1], _mm256_castsi256_ps(simd_tail_mask(dim)));
+    v_sum = _mm256_fmadd_ps(last, last, v_sum);
+  }
+  return v_sum;
+}
+
+/**
+ * Rosenbrock terms of the vectors [begin, end), reads vector `end` for the last lane
+ */
+__m256 opt_simd_rosenbrock_tile(const __m256* args, size_t begin, size_t end, size_t dim) {
+  const __m256 ones = _mm256_set1_ps(1.0);
+  const __m256 cent = _mm256_set1_ps(100.0);
+  const __m256i rotate = _mm256_setr_epi32(1, 2, 3, 4, 5, 6, 7, 0);
+  const size_t simd_dim = (dim + 7) / 8;
+  const size_t n_terms = dim - 1;
+  const size_t term_vecs = (n_terms + 7) / 8;
+  const __m256 term_tail = _mm256_castsi256_ps(simd_tail_mask(n_terms));
+  __m256 res = _mm256_setzero_ps();
+
+  for (size_t idx = begin; idx < end && idx < term_vecs; idx++) {
+    __m256 next = idx + 1 < simd_dim ? args[idx + 1] : _mm256_setzero_ps();
+    __m256 shift1 = _mm256_blend_ps(_mm256_permutevar8x32_ps(args[idx], rotate),
+                                    _mm256_permutevar8x32_ps(next, rotate), 0x80);
+    __m256 r1 = _mm256_fmsub_ps(args[idx],args[idx],shift1);
+    r1 = _mm256_mul_ps(r1,r1);
+    __m256 temp = _mm256_sub_ps(ones,args[idx]);
+    __m256 term = _mm256_fmadd_ps(cent, r1, _mm256_mul_ps(temp, temp));
+    if (idx + 1 == term_vecs) {
+      term = _mm256_and_ps(term, term_tail);
+    }
+    res = _mm256_add_ps(res, term);
+  }
+  return res;
+}
+
+simd_tile_obj_func_t opt_simd_tile_variant(simd_obj_func_t obj_func) {
+  if (obj_func == opt_simd_sum_of_squares) {
+    return opt_simd_sum_of_squares_tile;
+  }
+  if (obj_func == opt_simd_rosenbrock) {
+    return opt_simd_rosenbrock_tile;
+  }
+  return NULL;
+}
+
+
+/*******************************************************************************
+  UNROLLED IMPLEMENTATIONS, INDEPENDENT ACCUMULATORS
+******************************************************************************/
+
+/**
+ * Sum of squares with `n_acc` (at most 8) accumulators taking turns, so consecutive FMAs
+ * do not wait on each other. Inlined with a constant `n_acc` the inner loops unroll.
+ */
+static inline __attribute__((always_inline))
+float sum_of_squares_unrolled(const __m256* args, size_t dim, const size_t n_acc) {
+  const size_t simd_dim = (dim + 7) / 8;
+  __m256 acc[8];
+  for (size_t k = 0; k < n_acc; k++) {
+    acc[k] = _mm256_setzero_ps();
+  }
+  size_t idx = 0;
+  for (; idx + n_acc < simd_dim; idx += n_acc) {
+    for (size_t k = 0; k < n_acc; k++) {
+      acc[k] = _mm256_fmadd_ps(args[idx + k], args[idx + k], acc[k]);
+    }
+  }
+  for (; idx + 1 < simd_dim; idx++) {
+    acc[idx % n_acc] = _mm256_fmadd_ps(args[idx], args[idx], acc[idx % n_acc]);
+  }
+  // padding lanes of the last vector do not contribute
+  const __m256 last = _mm256_and_ps(args[simd_dim - 1], _mm256_castsi256_ps(simd_tail_mask(dim)));
+  acc[idx % n_acc] = _mm256_fmadd_ps(last, last, acc[idx % n_acc]);
+
+  // one tree combine of the accumulators
+  for (size_t width = n_acc / 2; width > 0; width /= 2) {
+    for (size_t k = 0; k < width; k++) {
+      acc[k] = _mm256_add_ps(acc[k], acc[k + width]);
+    }
+  }
+  return horizontal_add(acc[0]);
+}
+
+/**
+ * Rosenbrock terms of the vector `cur`, lane 7 takes lane 0 of `next`.
+ */
+static inline __m256 rosenbrock_terms(const __m256 cur, const __m256 next) {
+  const __m256 ones = _mm256_set1_ps(1.0);
+  const __m256 cent = _mm256_set1_ps(100.0);
+  const __m256i rotate = _mm256_setr_epi32(1, 2, 3, 4, 5, 6, 7, 0);
+  __m256 shift1 = _mm256_blend_ps(_mm256_permutevar8x32_ps(cur, rotate),
+                                  _mm256_permutevar8x32_ps(next, rotate), 0x80);
+  __m256 r1 = _mm256_fmsub_ps(cur, cur, shift1);
+  __m256 temp = _mm256_sub_ps(ones, cur);
+  return _mm256_fmadd_ps(cent, _mm256_mul_ps(r1, r1), _mm256_mul_ps(temp, temp));
+}
+
+/**
+ * Rosenbrock with `n_acc` (at most 8) accumulators taking turns.
+ */
+static inline __attribute__((always_inline))
+float rosenbrock_unrolled(const __m256* args, size_t dim, const size_t n_acc) {
+  const size_t simd_dim = (dim + 7) / 8;
+  const size_t n_terms = dim - 1;
+  const size_t term_vecs = (n_terms + 7) / 8;
+  const __m256 term_tail = _mm256_castsi256_ps(simd_tail_mask(n_terms));
+
+  __m256 acc[8];
+  for (size_t k = 0; k < n_acc; k++) {
+    acc[k] = _mm256_setzero_ps();
+  }
+  // all vectors before the last one holding terms have a successor and no masked terms
+  size_t idx = 0;
+  for (; idx + n_acc < term_vecs; idx += n_acc) {
+    for (size_t k = 0; k < n_acc; k++) {
+      acc[k] = _mm256_add_ps(acc[k], rosenbrock_terms(args[idx + k], args[idx + k + 1]));
+    }
+  }
+  for (; idx + 1 < term_vecs; idx++) {
+    acc[idx % n_acc] = _mm256_add_ps(acc[idx % n_acc], rosenbrock_terms(args[idx], args[idx + 1]));
+  }
+  if (term_vecs > 0) {
+    const __m256 next = idx + 1 < simd_dim ? args[idx + 1] : _mm256_setzero_ps();
+    const __m256 term = rosenbrock_terms(args[idx], next);
+    acc[idx % n_acc] = _mm256_add_ps(acc[idx % n_acc], _mm256_and_ps(term, term_tail));
+  }
+
+  for (size_t width = n_acc / 2; width > 0; width /= 2) {
+    for (size_t k = 0; k < width; k++) {
+      acc[k] = _mm256_add_ps(acc[k], acc[k + width]);
+    }
+  }
+  return horizontal_add(acc[0]);
+}
+
+float opt_simd_sum_of_squares_x4(const __m256* args, size_t dim) {
+  return sum_of_squares_unrolled(args, dim, 4);
+}
+
+float opt_simd_sum_of_squares_x8(const __m256* args, size_t dim) {
+  return sum_of_squares_unrolled(args, dim, 8);
+}
+
+float opt_simd_rosenbrock_x4(const __m256* args, size_t dim) {
+  return rosenbrock_unrolled(args, dim, 4);
+}
+
+float opt_simd_rosenbrock_x8(const __m256* args, size_t dim) {
+  return rosenbrock_unrolled(args, dim, 8);
+}
+
+simd_obj_func_t opt_simd_unrolled(simd_obj_func_t obj_func, size_t unroll) {
+  if (obj_func == opt_simd_sum_of_squares || obj_func == opt_simd_sphere) {
+    return unroll == 8 ? opt_simd_sum_of_squares_x8
+         : unroll == 4 ? opt_simd_sum_of_squares_x4 : obj_func;
+  }
+  if (obj_func == opt_simd_rosenbrock) {
+    return unroll == 8 ? opt_simd_rosenbrock_x8
+         : unroll == 4 ? opt_simd_rosenbrock_x4 : obj_func;
+  }
+  return obj_func;
+}
+
+// upper bounds in vectors of the dimension ranges with their own unroll factor, and the
+// number of vectors the factor of a range is measured on
+#define UNROLL_RANGES 4
+static const size_t unroll_range_end[UNROLL_RANGES] = {64, 512, 4096, SIZE_MAX};
+static const size_t unroll_range_probe[UNROLL_RANGES] = {16, 128, 1024, 8192};
+
+// the kernels with unrolled variants, each tuned on its own
+#define UNROLL_KERNELS 2
+static const simd_obj_func_t unroll_kernels[UNROLL_KERNELS] = {opt_simd_sum_of_squares,
+                                                                 opt_simd_rosenbrock};
+static size_t unroll_factors[UNROLL_KERNELS][UNROLL_RANGES];
+static pthread_once_t unroll_tuning = PTHREAD_ONCE_INIT;
+
+/**
+ * Fastest number of accumulators of `kernel` on `simd_dim` vectors, the best of a few
+ * timed runs of every candidate.
+ */
+static size_t measure_unroll_factor(simd_obj_func_t kernel, const __m256* args, size_t simd_dim) {
+  const size_t candidates[] = {1, 4, 8};
+  const size_t n_calls = 4096 / simd_dim + 1;
+  size_t best_unroll = 1;
+  uint64_t best_cycles = UINT64_MAX;
+  volatile float sink = 0;
+  for (size_t cand = 0; cand < sizeof(candidates) / sizeof(candidates[0]); cand++) {
+    simd_obj_func_t obj_func = opt_simd_unrolled(kernel, candidates[cand]);
+    for (size_t rep = 0; rep < 5; rep++) {
+      const uint64_t start = __rdtsc();
+      for (size_t call = 0; call < n_calls; call++) {
+        sink += obj_func(args, 8 * simd_dim);
+      }
+      const uint64_t cycles = __rdtsc() - start;
+      if (cycles < best_cycles) {
+        best_cycles = cycles;
+        best_unroll = candidates[cand];
+      }
+    }
+  }
+  return best_unroll;
+}
+
+/**
+ * Fill `unroll_factors`, run exactly once through `unroll_tuning`.
+ */
+static void tune_unroll_factors(void) {
+  const char *request = getenv("FASTCODE_UNROLL");
+  const size_t forced = request ? strtoul(request, NULL, 10) : 0;
+  __m256* args = NULL;
+  if (forced != 1 && forced != 4 && forced != 8) {
+    const size_t n_vectors = unroll_range_probe[UNROLL_RANGES - 1];
+    args = (__m256*)aligned_alloc(sizeof(__m256), n_vectors * sizeof(__m256));
+    if (!args) { perror("malloc arr"); exit(EXIT_FAILURE); };
+    for (size_t idx = 0; idx < n_vectors; idx++) {
+      args[idx] = _mm256_set1_ps(1.0 / (idx % 7 + 1));
+    }
+  }
+  for (size_t kernel = 0; kernel < UNROLL_KERNELS; kernel++) {
+    for (size_t range = 0; range < UNROLL_RANGES; range++) {
+      unroll_factors[kernel][range] = args ? measure_unroll_factor(unroll_kernels[kernel], args,
+                                                                   unroll_range_probe[range])
+                                           : forced;
+    }
+  }
+  free(args);
+}
+
+void opt_simd_tune_unroll(void) {
+  pthread_once(&unroll_tuning, tune_unroll_factors);
+}
+
+size_t opt_simd_unroll_factor(simd_obj_func_t obj_func, size_t dim) {
+  // sphere runs the sum of squares kernel
+  const simd_obj_func_t kernel = obj_func == opt_simd_sphere ? opt_simd_sum_of_squares : obj_func;
+  size_t idx = 0;
+  while (idx < UNROLL_KERNELS && unroll_kernels[idx] != kernel) {
+    idx++;
+  }
+  if (idx == UNROLL_KERNELS) {
+    return 1;
+  }
+
+  opt_simd_tune_unroll();
+  const size_t simd_dim = (dim + 7) / 8;
+  size_t range = 0;
+  while (simd_dim >= unroll_range_end[range]) {
+    range++;
+  }
+  return unroll_factors[idx][range];
+}
+
+simd_obj_func_t opt_simd_unroll_variant(simd_obj_func_t obj_func, size_t dim) {
+  return opt_simd_unrolled(obj_func, opt_simd_unroll_factor(obj_func, dim));
+}
+
+
+/*******************************************************************************
+  BATCHED IMPLEMENTATIONS, CANDIDATES STORED ROW AFTER ROW WITHOUT PADDING
+******************************************************************************/
+
+/**
+ * Evaluate `lanes_func` on the `count` rows of `positions`, 8 at a time. The rows of a block
+ * are gathered into one vector per dimension, the buffer for them is allocated once per batch.
+ */
+static void opt_simd_batch_lanes(simd_lanes_obj_func_t lanes_func, const float* positions,
+                                 size_t count, size_t dim, float* fitness) {
+  __m256* lanes = (__m256*)aligned_alloc(sizeof(__m256), (dim + 1) * sizeof(__m256));
+  if (!lanes) { perror("malloc arr"); exit(EXIT_FAILURE); };
+  const __m256i offsets = _mm256_mullo_epi32(_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7),
+                                             _mm256_set1_epi32((int)dim));
+
+  for (size_t first = 0; first < count; first += 8) {
+    const size_t n_rows = count - first < 8 ? count - first : 8;
+    // the missing rows of a partial block are zero
+    const __m256 valid = _mm256_castsi256_ps(simd_tail_mask(n_rows));
+    const float* rows = &positions[first * dim];
+    for (size_t idx = 0; idx < dim; idx++) {
+      lanes[idx] = _mm256_mask_i32gather_ps(_mm256_setzero_ps(), &rows[idx], offsets, valid, 4);
+    }
+    if (n_rows == 8) {
+      lanes_func(lanes, dim, &fitness[first]);
+    } else {
+      float block_fitness[8];
+      lanes_func(lanes, dim, block_fitness);
+      memcpy(&fitness[first], block_fitness, n_rows * sizeof(float));
+    }
+  }
+  free(lanes);
+}
+
+void opt_simd_sum_of_squares_batch(const float* positions, size_t count, size_t dim, float* fitness) {
+  opt_simd_batch_lanes(opt_simd_sum_of_squares_lanes, positions, count, dim, fitness);
+}
+
+void opt_simd_rosenbrock_batch(const float* positions, size_t count, size_t dim, float* fitness) {
+  opt_simd_batch_lanes(opt_simd_rosenbrock_lanes, positions, count, dim, fitness);
+}
+
+void opt_simd_rastigrin_batch(const float* positions, size_t count, size_t dim, float* fitness) {
+  opt_simd_batch_lanes(opt_simd_rastigrin_lanes, positions, count, dim, fitness);
+}
+
+void opt_simd_griewank_batch(const float* positions, size_t count, size_t dim, float* fitness) {
+  opt_simd_batch_lanes(opt_simd_griewank_lanes, positions, count, dim, fitness);
+}
+
+batch_obj_func_t opt_simd_batch_variant(obj_func_t obj_func) {
+  if (obj_func == sum_of_squares || obj_func == sphere) {
+    return opt_simd_sum_of_squares_batch;
+  }
+  if (obj_func == rosenbrock) {
+    return opt_simd_rosenbrock_batch;
+  }
+  if (obj_func == rastigrin) {
+    return opt_simd_rastigrin_batch;
+  }
+  if (obj_func == griewank) {
+    return opt_simd_griewank_batch;
+  }
+  return NULL;
+}
@@ -0,0 +1,62 @@
+#include <immintrin.h>
+
+#include "objectives.h"
+#include "utils.h"
+
+
+/*******************************************************************************
+  AVX-512 IMPLEMENTATIONS OF OBJECTIVE FUNCTIONS, 16 FLOATS PER VECTOR
+******************************************************************************/
+
+/**
+   Mask of the lanes of the last vector of a `dim` long array that hold data.
+ */
+static inline __mmask16 avx512_tail_mask(size_t dim) {
+  const size_t rem = dim % 16;
+  return rem ? (__mmask16)((1u << rem) - 1) : (__mmask16)0xffff;
+}
+
+/**
+ * Sum of squares AVX-512 function
+ * optimal solution is 0s everywhere
+ */
+float opt_avx512_sum_of_squares(const __m512* args, size_t dim) {
+  const size_t simd_dim = (dim + 15) / 16;
+  __m512 v_sum = _mm512_setzero_ps();
+  for(size_t idx = 0; idx + 1 < simd_dim; idx++){
+    v_sum = _mm512_fmadd_ps(args[idx], args[idx], v_sum);
+  }
+  // padding lanes of the last vector do not contribute
+  const __m512 last = _mm512_maskz_mov_ps(avx512_tail_mask(dim), args[simd_dim - 1]);
+  v_sum = _mm512_fmadd_ps(last, last, v_sum);
+  return _mm512_reduce_add_ps(v_sum);
+}
+
+/**
+ * Rosenbrock AVX-512 function
+ * global minimum at f(1,...,1) = 0
+ */
+float opt_avx512_rosenbrock(const __m512* args, size_t dim) {
+  const __m512 ones = _mm512_set1_ps(1.0);
+  const __m512 cent = _mm512_set1_ps(100.0);
+  const size_t simd_dim = (dim + 15) / 16;
+  __m512 res = _mm512_setzero_ps();
+
+  // there are dim - 1 terms, the last vector holding terms is masked
+  const size_t n_terms = dim - 1;
+  const size_t term_vecs = (n_terms + 15) / 16;
+  for (size_t idx = 0; idx < term_vecs; idx++) {
+    const __m512i cur = _mm512_castps_si512(args[idx]);
+    const __m512i next = idx + 1 < simd_dim ? _mm512_castps_si512(args[idx + 1])
+                                            : _mm512_setzero_si512();
+    // lanes shifted down by one, x[i+1] for each x[i]
+    const __m512 shift1 = _mm512_castsi512_ps(_mm512_alignr_epi32(next, cur, 1));
+    __m512 r1 = _mm512_fmsub_ps(args[idx], args[idx], shift1);
+    r1 = _mm512_mul_ps(cent, _mm512_mul_ps(r1, r1));
+    const __m512 temp = _mm512_sub_ps(ones, args[idx]);
+    const __m512 term = _mm512_fmadd_ps(temp, temp, r1);
+    res = idx + 1 < term_vecs ? _mm512_add_ps(res, term)
+                              : _mm512_mask_add_ps(res, avx512_tail_mask(n_terms), res, term);
+  }
+  return _mm512_reduce_add_ps(res);
+}
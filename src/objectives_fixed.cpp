@@ -0,0 +1,130 @@
+/**
+   Objective functions specialised on the dimensions the benchmarks run with. The number
+   of vectors is a template parameter, so the loops are unrolled at compile time and the
+   terms are spread over independent accumulators instead of one FMA chain.
+ */
+
+#include <cstddef>
+#include <immintrin.h>
+
+#include "objectives.h"
+#include "utils.h"
+
+
+namespace {
+
+/**
+   Calls `body(idx)` for `idx` from `Idx` to `N - 1`, unrolled at compile time.
+ */
+template <size_t Idx, size_t N>
+struct Unroll {
+  template <typename Body>
+  static inline void run(Body &body) {
+    body(Idx);
+    Unroll<Idx + 1, N>::run(body);
+  }
+};
+
+template <size_t N>
+struct Unroll<N, N> {
+  template <typename Body>
+  static inline void run(Body &) {}
+};
+
+// independent accumulators, enough to hide the latency of the FMA
+constexpr size_t n_accumulators(size_t simd_dim) {
+  return simd_dim < 4 ? simd_dim : 4;
+}
+
+template <size_t N>
+inline float reduce(const __m256 (&acc)[N]) {
+  __m256 res = acc[0];
+  for (size_t idx = 1; idx < N; idx++) {
+    res = _mm256_add_ps(res, acc[idx]);
+  }
+  return horizontal_add(res);
+}
+
+/**
+   Sum of squares of exactly `8 * SimdDim` dimensions.
+ */
+template <size_t SimdDim>
+struct SumOfSquaresFixed {
+  static float eval(const __m256 *args, size_t /* dim */) {
+    constexpr size_t n_acc = n_accumulators(SimdDim);
+    __m256 acc[n_acc];
+    for (size_t idx = 0; idx < n_acc; idx++) {
+      acc[idx] = _mm256_setzero_ps();
+    }
+    auto body = [&](size_t idx) {
+      acc[idx % n_acc] = _mm256_fmadd_ps(args[idx], args[idx], acc[idx % n_acc]);
+    };
+    Unroll<0, SimdDim>::run(body);
+    return reduce(acc);
+  }
+};
+
+/**
+   Rosenbrock of exactly `8 * SimdDim` dimensions, the last lane has no term.
+ */
+template <size_t SimdDim>
+struct RosenbrockFixed {
+  static inline __m256 terms(const __m256 cur, const __m256 next) {
+    const __m256 ones = _mm256_set1_ps(1.0);
+    const __m256 cent = _mm256_set1_ps(100.0);
+    const __m256i rotate = _mm256_setr_epi32(1, 2, 3, 4, 5, 6, 7, 0);
+    __m256 shift1 = _mm256_blend_ps(_mm256_permutevar8x32_ps(cur, rotate),
+                                    _mm256_permutevar8x32_ps(next, rotate), 0x80);
+    __m256 r1 = _mm256_fmsub_ps(cur, cur, shift1);
+    r1 = _mm256_mul_ps(r1, r1);
+    __m256 temp = _mm256_sub_ps(ones, cur);
+    return _mm256_fmadd_ps(cent, r1, _mm256_mul_ps(temp, temp));
+  }
+
+  static float eval(const __m256 *args, size_t /* dim */) {
+    constexpr size_t n_acc = n_accumulators(SimdDim);
+    __m256 acc[n_acc];
+    for (size_t idx = 0; idx < n_acc; idx++) {
+      acc[idx] = _mm256_setzero_ps();
+    }
+    auto body = [&](size_t idx) {
+      acc[idx % n_acc] = _mm256_add_ps(acc[idx % n_acc], terms(args[idx], args[idx + 1]));
+    };
+    Unroll<0, SimdDim - 1>::run(body);
+
+    const __m256 last_terms = _mm256_castsi256_ps(_mm256_setr_epi32(-1, -1, -1, -1, -1, -1, -1, 0));
+    const __m256 last = terms(args[SimdDim - 1], _mm256_setzero_ps());
+    acc[(SimdDim - 1) % n_acc] = _mm256_add_ps(acc[(SimdDim - 1) % n_acc],
+                                               _mm256_and_ps(last, last_terms));
+    return reduce(acc);
+  }
+};
+
+/**
+   `Kernel` instantiated for `dim`, or the unrolled variant of `generic` if `dim` is not
+   one of the fixed dimensions.
+ */
+template <template <size_t> class Kernel>
+simd_obj_func_t fixed_dim(size_t dim, simd_obj_func_t generic) {
+  switch (dim) {
+    case 8:   return &Kernel<1>::eval;
+    case 16:  return &Kernel<2>::eval;
+    case 32:  return &Kernel<4>::eval;
+    case 64:  return &Kernel<8>::eval;
+    case 128: return &Kernel<16>::eval;
+    default:  return opt_simd_unroll_variant(generic, dim);
+  }
+}
+
+} // namespace
+
+
+simd_obj_func_t opt_simd_dim_variant(simd_obj_func_t obj_func, size_t dim) {
+  if (obj_func == opt_simd_sum_of_squares || obj_func == opt_simd_sphere) {
+    return fixed_dim<SumOfSquaresFixed>(dim, obj_func);
+  }
+  if (obj_func == opt_simd_rosenbrock) {
+    return fixed_dim<RosenbrockFixed>(dim, obj_func);
+  }
+  return opt_simd_unroll_variant(obj_func, dim);
+}
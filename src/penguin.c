@@ -2,12 +2,28 @@
    Base implementation of the emperor penguin metaheuristic.
 */
 
+// mmap, getpid and friends for the rotation matrix cache
+#define _POSIX_C_SOURCE 200809L
+
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdint.h>
 #include <math.h>
 #include <string.h>
 #include <time.h>
-
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "dispatch.h"
+#include "objectives.h"
+#include "rng.h"
+#include "simd_math.h"
 #include "utils.h"
 #include "penguin.h"
 
@@ -16,21 +32,17 @@
  * Returns a pointer to a float array which is of size colony_size * dim.
  * The stride over penguins is dim since every penguin (representing possible solution) is of size dim.
  */
-void pen_initialise_population(float* const population,
+void pen_initialise_population(rng_t *const rng,
+                                float* const population,
                                 size_t colony_size,
                                 size_t dim,
                                 const float min_position,
                                 const float max_position) {
-  for (size_t pengu_idx = 0; pengu_idx < colony_size; pengu_idx++) {
-    for (size_t dim_idx = 0; dim_idx < dim; dim_idx++) {
-      size_t idx = (pengu_idx * dim) + dim_idx;
-      population[idx] = random_min_max(min_position, max_position);
-    }
-  }
+  rng_uniform(rng, population, colony_size * dim, min_position, max_position);
 }
 
 /**
- * Calculates initial fitness of each penguin by plugging its dim dimensions
+ * Calculates the fitness of each penguin by plugging its dim dimensions
  * into the objective function. The returned fitness array is of size colony_size.
  * High objective function value = high fitness = high heat radiation = LOW cost as defined in the paper.
  */
@@ -39,10 +51,7 @@ void pen_update_fitness(float* const fitness,
                         size_t dim,
                         const float *const population,
                         obj_func_t obj_func) {
-  for (size_t pengu_idx = 0; pengu_idx < colony_size; pengu_idx++) {
-    size_t idx = pengu_idx * dim;
-    fitness[pengu_idx] = (*obj_func)(&population[idx], dim);
-  }
+  obj_eval_batch(obj_func, population, colony_size, dim, fitness);
 }
 
 
@@ -85,6 +94,50 @@ float pen_attractiveness(float heat_rad,
 }
 
 
+void pen_attractiveness_matrix(float* const attract,
+                               size_t colony_size,
+                               size_t dim,
+                               const float *const population,
+                               float *const population_t,
+                               float heat_rad,
+                               float attenuation_coef) {
+  if (active_isa() >= ISA_AVX2) {
+    pen_attractiveness_matrix_simd(attract, colony_size, dim, population, population_t,
+                                   heat_rad, attenuation_coef);
+  } else {
+    pen_attractiveness_matrix_scalar(attract, colony_size, dim, population, population_t,
+                                     heat_rad, attenuation_coef);
+  }
+}
+
+void pen_attractiveness_matrix_scalar(float* const attract,
+                                      size_t colony_size,
+                                      size_t dim,
+                                      const float *const population,
+                                      float *const population_t,
+                                      float heat_rad,
+                                      float attenuation_coef) {
+  pairwise_distances(colony_size, dim, population, population_t, attract);
+  for (size_t idx = 0; idx < colony_size * colony_size; idx++) {
+    attract[idx] = heat_rad * exp(-attract[idx] * attenuation_coef);
+  }
+}
+
+void pen_attractiveness_matrix_simd(float* const attract,
+                                    size_t colony_size,
+                                    size_t dim,
+                                    const float *const population,
+                                    float *const population_t,
+                                    float heat_rad,
+                                    float attenuation_coef) {
+  const size_t size = colony_size * colony_size;
+  simd_pairwise_distances(colony_size, dim, population, population_t, attract);
+  scalar_mul(size, -attenuation_coef, attract);
+  simd_exp_array(attract, attract, size);
+  scalar_mul(size, heat_rad, attract);
+}
+
+
 /**
    Compute spiral movement of the penguin towards the centre. See paper on SPO for
    clarification.
@@ -112,13 +165,47 @@ void pen_get_spiral_like_movement(float* const spiral,
 }
 
 
+/**
+   Rotate every penguin of the population with one matrix matrix multiplication,
+   `rotated` = `population` times the transposed rotation matrix `rotation_t`.
+ */
+void pen_rotate_population(float* const rotated,
+                           size_t colony_size,
+                           size_t dim,
+                           const float *const population,
+                           const float *const rotation_t) {
+  if (active_isa() >= ISA_AVX2) {
+    simd_gemm(colony_size, dim, dim, population, rotation_t, rotated);
+  } else {
+    gemm(colony_size, dim, dim, population, rotation_t, rotated);
+  }
+}
+
+
+/**
+   Same as `pen_get_spiral_like_movement` on the rotated penguins of `pen_rotate_population`.
+   The rotation is linear, so only the difference of the rotated penguins is left.
+ */
+void pen_get_rotated_spiral_movement(float* const spiral,
+                                     float attract,
+                                     size_t dim,
+                                     const float *const rotated_centre,
+                                     const float *const rotated_penguin) {
+  for (size_t idx = 0; idx < dim; idx++) {
+    spiral[idx] = attract * (rotated_penguin[idx] - rotated_centre[idx]);
+  }
+}
+
+
 /**
    Mutates the spiral according the equation 19 from the paper.
    Caution: This modifies the spiral in place!
  */
-void pen_mutate(size_t dim, float *const spiral, float mutation_coef) {
+void pen_mutate(rng_t *const rng, size_t dim, float *const spiral, float mutation_coef,
+                float *const noise) {
+  rng_uniform(rng, noise, dim, -1.0, 1.0);
   for (size_t idx = 0; idx < dim; idx++) {
-    spiral[idx] += random_min_max(-1.0, 1.0) * mutation_coef;
+    spiral[idx] += noise[idx] * mutation_coef;
   }
 }
 
@@ -136,6 +223,46 @@ void pen_clamp_position(size_t dim, float *const position,
 }
 
 
+/**
+   Order of `pen_rank_t` by ascending fitness, NaN last and ties by index.
+ */
+static int pen_compare_ranks(const void* const lhs, const void* const rhs) {
+  const pen_rank_t* const a = (const pen_rank_t*)lhs;
+  const pen_rank_t* const b = (const pen_rank_t*)rhs;
+  const int a_nan = isnan(a->fitness) != 0;
+  const int b_nan = isnan(b->fitness) != 0;
+  if (a_nan || b_nan) {
+    return a_nan != b_nan ? a_nan - b_nan : (a->idx > b->idx) - (a->idx < b->idx);
+  }
+  if (a->fitness != b->fitness) {
+    return (a->fitness > b->fitness) - (a->fitness < b->fitness);
+  }
+  return (a->idx > b->idx) - (a->idx < b->idx);
+}
+
+void pen_rank_colony(pen_rank_t* const ranks,
+                     size_t* const n_better,
+                     size_t colony_size,
+                     const float *const fitness) {
+  for (size_t idx = 0; idx < colony_size; idx++) {
+    ranks[idx].fitness = fitness[idx];
+    ranks[idx].idx = idx;
+  }
+  qsort(ranks, colony_size, sizeof(pen_rank_t), pen_compare_ranks);
+
+  for (size_t rank = 0; rank < colony_size; rank++) {
+    if (rank == 0 || isnan(ranks[rank].fitness)) {
+      // NaN is never better than anything
+      n_better[rank] = 0;
+    } else if (ranks[rank].fitness > ranks[rank - 1].fitness) {
+      n_better[rank] = rank;
+    } else {
+      // a tie has the same strictly better penguins
+      n_better[rank] = n_better[rank - 1];
+    }
+  }
+}
+
 /**
    Gets the index of the fittest penguin in the population.
    The fitness (obj function value) goes into the attraction calculation. The higher the fitness the higher
@@ -155,65 +282,232 @@ size_t pen_get_fittest_idx(size_t colony_size, const float *const fitness) {
 }
 
 
+void pen_mean_position(float* const position, size_t dim, const float* const position_sum,
+                       size_t n_updates) {
+  for (size_t idx = 0; idx < dim; idx++) {
+    position[idx] = position_sum[idx] / n_updates;
+  }
+}
+
+
 /**
-   Initialise the rotation matrix of size `dim` times `dim`. Its rotation rate is given by
-   `theta` (between -pi and pi).
+   Product of the (negated) Givens rotations by `theta` of all planes, in the order of the
+   planes. Every factor only mixes two columns, so it is applied in place in O(dim) instead
+   of as a matrix product. The product is built transposed, where those are two contiguous
+   rows, and each factor's negation is a sign flip of the whole product, applied once.
  */
-void pen_init_rotation_matrix(float* const matrix, size_t dim, const float theta) {
+static void pen_build_rotation_matrix(float* const matrix, size_t dim, const float theta) {
+  const float cos_theta = cos(theta);
+  const float sin_theta = sin(theta);
+  float* rows = (float*)malloc(dim*dim*sizeof(float));
+  identity(dim, rows);
+
+  int negated = 0;
+  for(size_t idx = 0; idx + 1 < dim; idx++) {
+    for(size_t runner = idx + 1; runner < dim; runner++) {
+      float* const first = &rows[idx * dim];
+      float* const second = &rows[runner * dim];
+      for(size_t col = 0; col < dim; col++) {
+        const float a = first[col];
+        const float b = second[col];
+        first[col] = cos_theta * a + sin_theta * b;
+        second[col] = -sin_theta * a + cos_theta * b;
+      }
+      negated = !negated;
+    }
+  }
+
+  transpose(dim, dim, rows, matrix);
+  if(negated) {
+    negate(dim * dim, matrix);
+  }
+  free(rows);
+}
 
-  float* tmp = (float*)malloc(dim*dim*sizeof(float));
-  float* basic_rotation = (float*)malloc(dim*dim*sizeof(float));
 
-  identity(dim, matrix);
-  identity(dim, tmp);
-  identity(dim, basic_rotation);
-  for(size_t idx = 0; idx < dim - 1; idx++) {
-    for(size_t runner = idx + 1; runner < dim; runner++) {
-      // get basic rotation matrix
-      basic_rotation[idx * dim + idx] = cos(theta);
-      basic_rotation[idx * dim + runner] = -sin(theta);
-      basic_rotation[runner * dim + idx] = sin(theta);
-      basic_rotation[runner * dim + runner] = cos(theta);
-      negate(dim * dim, basic_rotation);
-      mmm(dim, tmp, basic_rotation, matrix);
-      memcpy(tmp, matrix, dim * dim * sizeof(float));
-      // reset to identity
-      negate(dim * dim, basic_rotation);
-      basic_rotation[idx * dim + idx] = 1.0;
-      basic_rotation[idx * dim + runner] = 0.0;
-      basic_rotation[runner * dim + idx] = 0.0;
-      basic_rotation[runner * dim + runner] = 1.0;
+#define PEN_CACHE_PATH_LEN 4096
+#define PEN_CACHE_MAGIC "PENROT1"
+
+/**
+   Header of a cached rotation matrix, the elements follow it row by row.
+ */
+typedef struct {
+  char magic[8];
+  uint64_t dim;
+  uint32_t theta;     // bits of theta
+  uint32_t precision; // bytes per element
+} pen_cache_header_t;
+
+static pen_cache_header_t pen_cache_header(size_t dim, const float theta) {
+  pen_cache_header_t header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, PEN_CACHE_MAGIC, sizeof(PEN_CACHE_MAGIC));
+  header.dim = dim;
+  memcpy(&header.theta, &theta, sizeof(header.theta));
+  header.precision = sizeof(float);
+  return header;
+}
+
+/**
+   Directory of the rotation matrix cache, `FASTCODE_CACHE_DIR` or `fastcode` in the user's
+   cache directory. An empty `FASTCODE_CACHE_DIR` disables the cache. Returns 0 if there is
+   no cache directory.
+ */
+static int pen_cache_dir(char* const dir, size_t size) {
+  const char* const request = getenv("FASTCODE_CACHE_DIR");
+  int len;
+  if(request) {
+    len = snprintf(dir, size, "%s", request);
+  } else if(getenv("XDG_CACHE_HOME") && *getenv("XDG_CACHE_HOME")) {
+    len = snprintf(dir, size, "%s/fastcode", getenv("XDG_CACHE_HOME"));
+  } else if(getenv("HOME") && *getenv("HOME")) {
+    len = snprintf(dir, size, "%s/.cache/fastcode", getenv("HOME"));
+  } else {
+    return 0;
+  }
+  return len > 0 && (size_t)len < size;
+}
+
+/**
+   Path of the cached rotation matrix, keyed by the dimension, the bits of `theta` and the
+   precision. Returns 0 if there is no cache.
+ */
+static int pen_cache_path(char* const path, size_t size, const char* const dir, size_t dim,
+                          const float theta) {
+  const pen_cache_header_t header = pen_cache_header(dim, theta);
+  const int len = snprintf(path, size, "%s/pen_rotation_%zu_%08x_f%u.bin", dir, dim,
+                           (unsigned)header.theta, (unsigned)(8 * header.precision));
+  return len > 0 && (size_t)len < size;
+}
+
+/**
+   Copy the cached rotation matrix at `path` into `matrix`. Returns 0 if it is missing or
+   was written for another key.
+ */
+static int pen_load_rotation_matrix(float* const matrix, const char* const path, size_t dim,
+                                    const float theta) {
+  const int fd = open(path, O_RDONLY);
+  if(fd < 0) {
+    return 0;
+  }
+  const pen_cache_header_t expected = pen_cache_header(dim, theta);
+  const size_t size = sizeof(expected) + dim * dim * sizeof(float);
+  struct stat info;
+  int loaded = 0;
+  if(fstat(fd, &info) == 0 && (size_t)info.st_size == size) {
+    void* const mapped = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if(mapped != MAP_FAILED) {
+      if(memcmp(mapped, &expected, sizeof(expected)) == 0) {
+        memcpy(matrix, (const char*)mapped + sizeof(expected), dim * dim * sizeof(float));
+        loaded = 1;
+      }
+      munmap(mapped, size);
     }
   }
-  scalar_mul(dim * dim, A, matrix);
+  close(fd);
+  return loaded;
+}
+
+/**
+   Create the cache directory `dir` and any missing parents of it, like `mkdir -p`.
+   Returns 0 if it is not a directory afterwards.
+ */
+static int pen_make_cache_dir(const char* const dir) {
+  char partial[PEN_CACHE_PATH_LEN];
+  const size_t len = strlen(dir);
+  if(len == 0 || len >= sizeof(partial)) {
+    return 0;
+  }
+  memcpy(partial, dir, len + 1);
+  // every parent ends at a separator, an existing one makes mkdir fail harmlessly
+  for(size_t idx = 1; idx < len; idx++) {
+    if(partial[idx] == '/') {
+      partial[idx] = '\0';
+      mkdir(partial, 0755);
+      partial[idx] = '/';
+    }
+  }
+  mkdir(partial, 0755);
+  struct stat info;
+  return stat(dir, &info) == 0 && S_ISDIR(info.st_mode);
+}
+
+/**
+   Write `matrix` to the cache at `path`. The file is renamed into place once complete, so
+   concurrent runs never map a partial matrix. Failures, including a cache directory that
+   cannot be created, skip the cache and leave it as it is.
+ */
+static void pen_store_rotation_matrix(const float* const matrix, const char* const dir,
+                                      const char* const path, size_t dim, const float theta) {
+  if(!pen_make_cache_dir(dir)) {
+    return;
+  }
+  char tmp_path[PEN_CACHE_PATH_LEN];
+  const int len = snprintf(tmp_path, sizeof(tmp_path), "%s.%ld.tmp", path, (long)getpid());
+  if(len < 0 || (size_t)len >= sizeof(tmp_path)) {
+    return;
+  }
+  FILE* const file = fopen(tmp_path, "wb");
+  if(!file) {
+    return;
+  }
+  const pen_cache_header_t header = pen_cache_header(dim, theta);
+  int written = fwrite(&header, sizeof(header), 1, file) == 1
+    && fwrite(matrix, sizeof(float), dim * dim, file) == dim * dim;
+  written = (fclose(file) == 0) && written;
+  if(!written || rename(tmp_path, path) != 0) {
+    remove(tmp_path);
+  }
+}
 
-  free(tmp);
-  free(basic_rotation);
+/**
+   Initialise the rotation matrix of size `dim` times `dim`. Its rotation rate is given by
+   `theta` (between -pi and pi). The unscaled rotation only depends on `dim` and `theta`, so
+   it is memory mapped from the cache when a previous run has built it.
+ */
+void pen_init_rotation_matrix(float* const matrix, size_t dim, const float theta) {
+  char dir[PEN_CACHE_PATH_LEN], path[PEN_CACHE_PATH_LEN];
+  const int cached = pen_cache_dir(dir, sizeof(dir)) && *dir
+    && pen_cache_path(path, sizeof(path), dir, dim, theta);
+
+  if(!cached || !pen_load_rotation_matrix(matrix, path, dim, theta)) {
+    pen_build_rotation_matrix(matrix, dim, theta);
+    if(cached) {
+      pen_store_rotation_matrix(matrix, dir, path, dim, theta);
+    }
+  }
+  scalar_mul(dim * dim, A, matrix);
 }
 
 /**
-   Run the emperor penguin metaheuristic.
+   Run the emperor penguin metaheuristic on `n_threads` threads.
    Arguments:
      - obj_func: the objective function accepting an array of floats and the dimension.
      - dim: the dimension count of a solution (penguin).
      - max_iterations: the maximal count of iterations to be run.
      - min_position: the minimum value for each dimension
      - max_position: the maximum value for each dimension.
+     - n_threads: number of threads to use, 0 uses the OpenMP default.
    Returns:
      An array of floats representing a solution. The length of the array is
      `dim`.
  */
-float *pen_emperor_penguin(obj_func_t obj_func,
-                            size_t colony_size,
-                            size_t dim,
-                            size_t max_iterations,
-                            const float min_position,
-                            const float max_position) {
-  srand(100);
+float *pen_emperor_penguin_parallel(obj_func_t obj_func,
+                                    size_t colony_size,
+                                    size_t dim,
+                                    size_t max_iterations,
+                                    const float min_position,
+                                    const float max_position,
+                                    size_t n_threads) {
+  if (n_threads == 0) {
+    n_threads = default_num_threads();
+  }
+  // one stream per thread, the first one is the stream of the single threaded run
+  rng_stream_t* rngs = rng_alloc_streams(n_threads, 100);
 
   // initialise data
   float* population = (float*)malloc(colony_size*dim*sizeof(float));
-  pen_initialise_population(population, colony_size, dim, min_position, max_position);
+  pen_initialise_population(&rngs[0].rng, population, colony_size, dim, min_position, max_position);
 
   // float fitness[colony_size];
   float* fitness = (float*)malloc(colony_size*sizeof(float));
@@ -221,6 +515,27 @@ float *pen_emperor_penguin(obj_func_t obj_func,
 
   float* r_matrix = (float*)malloc(dim*dim*sizeof(float));
   pen_init_rotation_matrix(r_matrix, dim, B);
+  float* r_matrix_t = (float*)malloc(dim*dim*sizeof(float));
+  transpose(dim, dim, r_matrix, r_matrix_t);
+
+  // every penguin rotated once per iteration instead of once per pair
+  float* rotated = (float*)malloc(colony_size*dim*sizeof(float));
+
+  // attractiveness of all pairs, from the Gram matrix of the transposed population
+  float* population_t = (float*)malloc(dim*colony_size*sizeof(float));
+  float* attractiveness = (float*)malloc(colony_size*colony_size*sizeof(float));
+
+  // colony sorted by fitness, the count of strictly better penguins per rank and the
+  // penguins in rank order
+  pen_rank_t* ranks = (pen_rank_t*)malloc(colony_size*sizeof(pen_rank_t));
+  size_t* n_better = (size_t*)malloc(colony_size*sizeof(size_t));
+  float* ranked = (float*)malloc(colony_size*dim*sizeof(float));
+
+  // scratch of every thread: the spiral, its noise and the running sum of the moves
+  float* scratch = (float*)malloc(n_threads*3*dim*sizeof(float));
+  if (!rotated || !population_t || !attractiveness || !ranks || !n_better || !ranked || !scratch) {
+    perror("malloc arr"); exit(EXIT_FAILURE);
+  };
 
   float base_heat_radiation = pen_heat_radiation();
 
@@ -230,104 +545,146 @@ float *pen_emperor_penguin(obj_func_t obj_func,
     printf("# BEST FITNESS: %f\n", lowest_value(colony_size, fitness));
   #endif
 
-  // initialise rotation matrix
-
-  for (size_t iter = 0; iter < max_iterations; iter++) {
-
-    // initialize coefficients
-    float heat_absorption_coef = linear_scale(HAB_COEF_START, HAB_COEF_END, max_iterations, iter);
-    float mutation_coef = linear_scale(MUT_COEF_START, MUT_COEF_END, max_iterations, iter);
-    float attenuation_coef = linear_scale(ATT_COEF_START, ATT_COEF_END, max_iterations, iter);
-
-    // number of updates for each pengu
-    int* n_updates_per_pengu = (int*)malloc(colony_size*sizeof(int));
-    fill_int_array(n_updates_per_pengu, colony_size, 0);
-
-    // float updated_positions[colony_size * colony_size * dim];
-    float* updated_positions = (float*)malloc(colony_size*colony_size*dim*sizeof(float));
-    fill_float_array(updated_positions, colony_size * colony_size * dim, 0.0);
+  #pragma omp parallel num_threads(n_threads)
+  {
+#ifdef _OPENMP
+    size_t thread = (size_t)omp_get_thread_num();
+    size_t team_size = (size_t)omp_get_num_threads();
+#else
+    size_t thread = 0;
+    size_t team_size = 1;
+#endif
+    rng_t* const rng = &rngs[thread].rng;
+    float* const spiral = &scratch[thread * 3 * dim];
+    float* const noise = &scratch[(thread * 3 + 1) * dim];
+    float* const position_sum = &scratch[(thread * 3 + 2) * dim];
+    // contiguous rows of the colony to rotate
+    size_t begin = colony_size * thread / team_size;
+    size_t count = colony_size * (thread + 1) / team_size - begin;
+
+    for (size_t iter = 0; iter < max_iterations; iter++) {
+
+      // initialize coefficients
+      float heat_absorption_coef = linear_scale(HAB_COEF_START, HAB_COEF_END, max_iterations, iter);
+      float mutation_coef = linear_scale(MUT_COEF_START, MUT_COEF_END, max_iterations, iter);
+      float attenuation_coef = linear_scale(ATT_COEF_START, ATT_COEF_END, max_iterations, iter);
+
+      #pragma omp single
+      {
+        // every penguin moves towards the strictly better ones (lower cost), a prefix of the
+        // ranking, so the colony is copied in rank order and the pairs are walked in it
+        pen_rank_colony(ranks, n_better, colony_size, fitness);
+        for (size_t rank = 0; rank < colony_size; rank++) {
+          memcpy(&ranked[rank * dim], &population[ranks[rank].idx * dim], dim * sizeof(float));
+        }
 
+        // calculate heat radiation and the attractiveness of all pairs
+        float heat_rad = heat_absorption_coef * base_heat_radiation;
+        pen_attractiveness_matrix(attractiveness, colony_size, dim, ranked, population_t,
+                                  heat_rad, attenuation_coef);
+      } // implicit barrier, the ranked colony is complete
 
-    for (size_t penguin_j = 0; penguin_j < colony_size; penguin_j++) {
-      for (size_t penguin_i = 0; penguin_i < colony_size; penguin_i++) {
-        if (fitness[penguin_j] > fitness[penguin_i]) {   // high fitness = high heat radiation = low cost // high fitness = high heat radiation = low cost
+      pen_rotate_population(&rotated[begin * dim], count, dim, &ranked[begin * dim], r_matrix_t);
 
-          // calculate heat radiation
-          float heat_rad = heat_absorption_coef * base_heat_radiation;
+      #pragma omp barrier
 
-          // calculate attractiveness
-          float attract = pen_attractiveness(heat_rad,
-                                              dim,
-                                              &population[penguin_i * dim],
-                                              &population[penguin_j * dim],
-                                              attenuation_coef);
+      // the prefixes grow with the rank, every thread takes every `team_size`th rank to
+      // balance them; a penguin only reads the ranked copy and writes its own row
+      for (size_t rank_j = thread; rank_j < colony_size; rank_j += team_size) {
+        if (n_better[rank_j] == 0) {
+          continue;
+        }
+        fill_float_array(position_sum, dim, 0.0);
+        for (size_t rank_i = 0; rank_i < n_better[rank_j]; rank_i++) {
+          // the attractiveness is symmetric, its row is contiguous
+          float attract = attractiveness[rank_j * colony_size + rank_i];
 
           // calculate spiral movement
-          // float* spiral = (float*)malloc(dim*sizeof(float));
-          float spiral[dim];
-          pen_get_spiral_like_movement(spiral, attract, dim,
-                                       &population[penguin_i * dim],
-                                       &population[penguin_j * dim],
-                                       r_matrix);
+          pen_get_rotated_spiral_movement(spiral, attract, dim,
+                                          &rotated[rank_i * dim],
+                                          &rotated[rank_j * dim]);
 
           // mutate movement
-          pen_mutate(dim, spiral, mutation_coef);
+          pen_mutate(rng, dim, spiral, mutation_coef, noise);
 
           // update position by adding spiral movement on top of old position
-          vva(dim, spiral, &population[penguin_j * dim], spiral);
+          vva(dim, spiral, &ranked[rank_j * dim], spiral);
 
           // clamp
           pen_clamp_position(dim, spiral, min_position, max_position);
 
-          // add movement to updated position
-          memcpy(&updated_positions[penguin_j * dim * colony_size + n_updates_per_pengu[penguin_j] * dim],
-                  spiral, dim * sizeof(float));
-          n_updates_per_pengu[penguin_j] += 1;
-
-          // free(spiral);
+          // add movement to the sum of updated positions
+          vva(dim, spiral, position_sum, position_sum);
         }
-      }
-    }
 
-    // accumulate changes for every pengu during this iteration
-    for (size_t pengu_idx = 0; pengu_idx < colony_size; pengu_idx++) {
-      // float* mean_pos = (float*)malloc(dim*sizeof(float));
-      float mean_pos[dim];
-      fill_float_array(mean_pos, dim, 0.0);
-
-      if (n_updates_per_pengu[pengu_idx] > 0) {
-        for (size_t dim_idx = 0; dim_idx < dim; dim_idx++) {
-          float mean_pos_dim = mean_value_in_strides(dim * n_updates_per_pengu[pengu_idx],
-                                                      &updated_positions[pengu_idx * dim * colony_size],
-                                                      dim_idx,
-                                                      dim);
-          mean_pos[dim_idx] = mean_pos_dim;
-        }
-        // finally positions and fitness for a whole iteration
-        memcpy(&population[pengu_idx * dim], mean_pos, dim * sizeof(float));
-        fitness[pengu_idx] = (*obj_func)(&population[pengu_idx * dim], dim);
+        // finally the position for a whole iteration, it moved once per better one
+        const size_t pengu_idx = ranks[rank_j].idx;
+        pen_mean_position(&population[pengu_idx * dim], dim, position_sum, n_better[rank_j]);
       }
-      // free(mean_pos);
-    }
 
-    free(n_updates_per_pengu);
-    free(updated_positions);
+      #pragma omp barrier
+
+      // the ranking is only needed again next iteration, every thread evaluates its rows of
+      // the moved colony in one batch
+      pen_update_fitness(&fitness[begin], count, dim, &population[begin * dim], obj_func);
 
-    #ifdef DEBUG
-      print_population(colony_size, dim, population);
-      printf("# AVG FITNESS: %f\n", average_value(colony_size, fitness));
-      printf("# BEST FITNESS: %f\n", lowest_value(colony_size, fitness));
-    #endif
-  } // end loop on iterations
+      #pragma omp barrier
+
+      #ifdef DEBUG
+        #pragma omp single
+        {
+          print_population(colony_size, dim, population);
+          printf("# AVG FITNESS: %f\n", average_value(colony_size, fitness));
+          printf("# BEST FITNESS: %f\n", lowest_value(colony_size, fitness));
+        }
+      #endif
+    } // end loop on iterations
+  }
 
   // final selection and cleanup
   size_t best_solution = pen_get_fittest_idx(colony_size, fitness);
   float *const final_solution = (float *) malloc(dim * sizeof(float));
-  memcpy(final_solution, &population[best_solution], dim * sizeof(float));
+  memcpy(final_solution, &population[best_solution * dim], dim * sizeof(float));
 
   free(r_matrix);
+  free(r_matrix_t);
+  free(rotated);
+  free(population_t);
+  free(attractiveness);
+  free(ranks);
+  free(n_better);
+  free(ranked);
+  free(scratch);
+  free(rngs);
   free(population);
   free(fitness);
 
   return final_solution;
 }
+
+/**
+   Run the emperor penguin metaheuristic on one thread, see `pen_emperor_penguin_parallel`.
+ */
+float *pen_emperor_penguin(obj_func_t obj_func,
+                            size_t colony_size,
+                            size_t dim,
+                            size_t max_iterations,
+                            const float min_position,
+                            const float max_position) {
+  return pen_emperor_penguin_parallel(obj_func, colony_size, dim, max_iterations,
+                                      min_position, max_position, 1);
+}
+
+/**
+   Run the emperor penguin metaheuristic on the default number of threads, see
+   `pen_emperor_penguin_parallel`.
+ */
+float *pen_emperor_penguin_mt(obj_func_t obj_func,
+                              size_t colony_size,
+                              size_t dim,
+                              size_t max_iterations,
+                              const float min_position,
+                              const float max_position) {
+  return pen_emperor_penguin_parallel(obj_func, colony_size, dim, max_iterations,
+                                      min_position, max_position, 0);
+}
@@ -7,17 +7,21 @@
 #include <time.h>
 #include <float.h>
 #include <limits.h>
+#include <stdint.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 #include "pso.h"
+#include "pso_kernels.h"
+#include "rng.h"
 #include "utils.h"
 #include "objectives.h"
+#include "dispatch.h"
 
 
 #define EPS 0.001
-#define COG 0.5
-#define SOCIAL .9
-#define INERTIA 0.5
-#define VEL_LIMIT_SCALE 5
 #ifndef M_PI
 #define M_PI (3.14159265358979323846)
 #endif
@@ -25,90 +29,93 @@
 #define min(a, b) (((a) < (b)) ? (a) : (b))
 #define max(a, b) (((a) > (b)) ? (a) : (b))
 
-__m256i seed_a;
-__m256i seed_b;
-__m256 mul_factor;
-
-__m256 factor_min_to_max;
-
-__m256 inertia;
-__m256 cog;
-__m256 social;
-
-__m256 quarter;
-
-__m256 v_min_vel;
-__m256 v_max_vel;
-
-__m256 v_min_pos;
-__m256 v_max_pos;
-
 /**
-   Seed a parallel floating point RNG.
+   Seed `n_streams` independent parallel floating point RNG streams. The streams
+   only depend on `seed`, no global RNG state is touched.
  */
-void seed_simd_rng(size_t seed) {
-  srand(seed);
-  seed_a = _mm256_set_epi32(rand(), rand(), rand(), rand(),
-                            rand(), rand(), rand(), rand());
-  seed_b = _mm256_set_epi32(rand(), rand(), rand(), rand(),
-                            rand(), rand(), rand(), rand());
-
-  mul_factor = _mm256_set1_ps(1.0f / 2147483648.0f);
-
-  inertia = _mm256_set1_ps(INERTIA);
-  cog = _mm256_set1_ps(COG);
-  social = _mm256_set1_ps(SOCIAL);
-
-  quarter = _mm256_set1_ps(0.25);
-}
-
-void initialise_velocity_bounds(float min_vel, float max_vel) {
-  v_min_vel = _mm256_set1_ps(min_vel);
-  v_max_vel = _mm256_set1_ps(max_vel);
-}
-
-void initialise_position_bounds(float min_position, float max_position) {
-  v_min_pos = _mm256_set1_ps(min_position);
-  v_max_pos = _mm256_set1_ps(max_position);
-  factor_min_to_max = _mm256_sub_ps(v_max_pos, v_min_pos);
+void seed_simd_rng(simd_rng_t *const streams, size_t n_streams, size_t seed) {
+  uint64_t state = seed;
+  for(size_t stream = 0; stream < n_streams; stream++) {
+    for(size_t chain = 0; chain < SIMD_RNG_CHAINS; chain++) {
+      uint64_t s0 = splitmix64(&state);
+      uint64_t s1 = splitmix64(&state);
+      uint64_t s2 = splitmix64(&state);
+      uint64_t s3 = splitmix64(&state);
+      streams[stream].state[chain] = _mm256_set_epi64x((long long)s3, (long long)s2,
+                                                       (long long)s1, (long long)s0);
+    }
+  }
 }
 
-
 /**
-   Generate a vector of random floats between `min` and `max`.
+   `simd_rand_fill` for a constant `n_chains`, the chains live in registers.
  */
-inline __m256 simd_rand_min_max() {
-  const __m256 rands = simd_rand_0_to_1();
-  return _mm256_fmadd_ps(rands, factor_min_to_max, v_min_pos);
+static inline void simd_rand_fill_chains(simd_rng_t *const rng, __m256 *const out,
+                                         size_t n_vectors, const size_t n_chains) {
+  __m256i chains[SIMD_RNG_CHAINS];
+  for(size_t chain = 0; chain < n_chains; chain++) {
+    chains[chain] = rng->state[chain];
+  }
+  size_t idx = 0;
+  for(; idx + n_chains <= n_vectors; idx += n_chains) {
+    for(size_t chain = 0; chain < n_chains; chain++) {
+      out[idx + chain] = simd_xorshift_0_to_1(&chains[chain]);
+    }
+  }
+  for(size_t chain = 0; idx < n_vectors; idx++, chain++) {
+    out[idx] = simd_xorshift_0_to_1(&chains[chain]);
+  }
+  for(size_t chain = 0; chain < n_chains; chain++) {
+    rng->state[chain] = chains[chain];
+  }
 }
 
-/**
-   Generate a vector of random floats between 0 and 1.
-*/
-inline __m256 simd_rand_0_to_1() {
-  seed_a = seed_b;
+void simd_rand_fill(simd_rng_t *const rng, __m256 *const out, size_t n_vectors, size_t n_chains) {
+  switch(n_chains) {
+    case 1: simd_rand_fill_chains(rng, out, n_vectors, 1); break;
+    case 2: simd_rand_fill_chains(rng, out, n_vectors, 2); break;
+    case 4: simd_rand_fill_chains(rng, out, n_vectors, 4); break;
+    default: assert(!"n_chains must be 1, 2 or 4");
+  }
+}
 
-  const __m256i s0 = seed_b;
-  const __m256i s1 = _mm256_xor_si256(seed_b, _mm256_slli_epi64(seed_b, 23));
+void simd_philox_fill(uint64_t seed, uint64_t counter, __m256 *const out, size_t n_vectors) {
+  const __m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+  for(size_t idx = 0; idx < n_vectors; idx += 4, counter++) {
+    __m256i ctr[4] = {_mm256_set1_epi32((int)(uint32_t)counter),
+                      _mm256_set1_epi32((int)(uint32_t)(counter >> 32)),
+                      _mm256_setzero_si256(), lanes};
+    simd_philox4x32(ctr, seed);
+    for(size_t word = 0; word < 4 && idx + word < n_vectors; word++) {
+      out[idx + word] = simd_bits_0_to_1(ctr[word]);
+    }
+  }
+}
 
-  const __m256i lhs = _mm256_xor_si256(_mm256_xor_si256(s1, s0), _mm256_srli_epi64(s1, 18));
-  const __m256i rhs = _mm256_srli_epi64(s0, 5);
+void initialise_velocity_bounds(pso_bounds_t *const bounds, float min_vel, float max_vel) {
+  bounds->min_vel = _mm256_set1_ps(min_vel);
+  bounds->max_vel = _mm256_set1_ps(max_vel);
+}
 
-  seed_b = _mm256_xor_si256(lhs, rhs);
-  const __m256 rands = _mm256_cvtepi32_ps(_mm256_abs_epi32(_mm256_add_epi64(seed_b, s0)));
-  return _mm256_mul_ps(rands, mul_factor);
+void initialise_position_bounds(pso_bounds_t *const bounds, float min_position, float max_position) {
+  bounds->min_pos = _mm256_set1_ps(min_position);
+  bounds->max_pos = _mm256_set1_ps(max_position);
 }
 
+
 /**
    Initialise an array to random numbers between `min` and `max`.
 
    Arguments:
+     rng     the random stream to draw from
+     bounds  the position bounds `min` and `max`
      array   the array to randomly initialise
      length  the length of the array to initialise in terms of __m256
  */
-void pso_rand_init(__m256 *const array, size_t length) {
+void pso_rand_init(simd_rng_t *const rng, const pso_bounds_t *const bounds,
+                   __m256 *const array, size_t length) {
   for(size_t idx = 0; idx < length; idx++) {
-    array[idx] = simd_rand_min_max();
+    array[idx] = simd_rand_min_max(rng, bounds);
   }
 }
 
@@ -119,15 +126,45 @@ void pso_rand_init(__m256 *const array, size_t length) {
    Arguments:
      obj_func    objective function with which to compute the fitness
      swarm_size  number of particles for which to compute the fitness
-     simd_dim    dimension of the position of each particle in terms of __m256
+     dim         dimension of the position of each particle, rows are padded to whole __m256
      positions   position array of the particles
      fitness     array where to store the result
  */
 void pso_eval_fitness(simd_obj_func_t obj_func,
-                      size_t swarm_size, size_t simd_dim,
+                      size_t swarm_size, size_t dim,
                       const __m256 *const positions, float *fitness) {
+  const size_t simd_dim = (dim + 7) / 8;
+  simd_lanes_obj_func_t lanes_obj_func = opt_simd_lanes_variant(obj_func);
+  if(!lanes_obj_func) {
+    for(size_t particle = 0; particle < swarm_size; particle++) {
+      fitness[particle] = obj_func(&positions[particle * simd_dim], dim);
+    }
+    return;
+  }
+
+  // 8 particles per call, transposed into one vector per dimension
+  __m256 *lanes = (__m256*)aligned_alloc(sizeof(__m256), simd_dim * 8 * sizeof(__m256));
+  if (!lanes) { perror("malloc arr"); exit(EXIT_FAILURE); };
+  for(size_t first = 0; first < swarm_size; first += 8) {
+    const size_t n_particles = swarm_size - first < 8 ? swarm_size - first : 8;
+    float block_fitness[8];
+    pso_transpose_block(&positions[first * simd_dim], n_particles, simd_dim, lanes);
+    lanes_obj_func(lanes, dim, block_fitness);
+    memcpy(&fitness[first], block_fitness, n_particles * sizeof(float));
+  }
+  free(lanes);
+}
+
+/**
+   Zero the padding lanes past `dim` in the last vector of every particle, such that
+   the padding is neutral for objectives that ignore the true dimension.
+ */
+static void pso_clear_tails(__m256 *const array, size_t swarm_size, size_t dim) {
+  const size_t simd_dim = (dim + 7) / 8;
+  const __m256 tail = _mm256_castsi256_ps(simd_tail_mask(dim));
   for(size_t particle = 0; particle < swarm_size; particle++) {
-    fitness[particle] = obj_func(&positions[particle], simd_dim);
+    size_t last = (particle + 1) * simd_dim - 1;
+    array[last] = _mm256_and_ps(array[last], tail);
   }
 }
 
@@ -135,17 +172,21 @@ void pso_eval_fitness(simd_obj_func_t obj_func,
    Randomly generate initial velocity for all particles.
 
    Arguments:
+     rng           the random stream to draw from
+     bounds        the position bounds
      velocity      array where to store the result
      positions     position array of the particles
      swarm_size    number of particles for which to compute the initial velocity
      simd_dim      dimension of the position of each particle in terms of __m256
  */
-void pso_gen_init_velocity(__m256 *const velocity, const __m256 *const positions,
+void pso_gen_init_velocity(simd_rng_t *const rng, const pso_bounds_t *const bounds,
+                           __m256 *const velocity, const __m256 *const positions,
                            size_t swarm_size, size_t simd_dim) {
-  __m256* u = (__m256*)malloc(swarm_size * simd_dim * sizeof(__m256));
+  __m256* u = (__m256*)aligned_alloc(sizeof(__m256), swarm_size * simd_dim * sizeof(__m256));
   if (!u) { perror("malloc arr"); exit(EXIT_FAILURE); };
-  pso_rand_init(u, swarm_size * simd_dim);
+  pso_rand_init(rng, bounds, u, swarm_size * simd_dim);
 
+  const __m256 quarter = _mm256_set1_ps(0.25);
   for(size_t idx = 0; idx < swarm_size * simd_dim; idx++) {
     __m256 diff = _mm256_sub_ps(u[idx], positions[idx]);
     velocity[idx] = _mm256_mul_ps(quarter, diff);
@@ -155,28 +196,22 @@ void pso_gen_init_velocity(__m256 *const velocity, const __m256 *const positions
 }
 
 /**
-   Returns the index of the particle with lowest fitness.
-
-   Arguments:
-     fitness     array containing the fitness values for all particles
-     swarm_size  number of particles in fitness array
-
-   Returns:
-     A `size_t` representing the index.
+   Update the local best fitness and position of `particle` if its current fitness beats it.
  */
-size_t pso_best_fitness(float *fitness, size_t swarm_size) {
-  size_t min_idx = 0;
-  float min = fitness[0];
-  for(size_t particle = 1; particle < swarm_size; particle++) {
-    if(fitness[particle] < min) {
-      min = fitness[particle];
-      min_idx = particle;
+static inline void pso_update_local_best(__m256 *const local_best_positions,
+                                         const __m256 *const positions,
+                                         const float *const current_fitness,
+                                         float *const local_best_fitness,
+                                         size_t particle, size_t simd_dim) {
+  if(current_fitness[particle] < local_best_fitness[particle]) {
+    local_best_fitness[particle] = current_fitness[particle];
+    for(size_t dimension = 0; dimension < simd_dim; dimension++) {
+      size_t j = (particle * simd_dim) + dimension;
+      local_best_positions[j] = positions[j];
     }
   }
-  return min_idx;
 }
 
-
 /**
    Update the velocity, positions, local best positions, global best positions,
    fitness, and local best fitness of each particle in the swarm.
@@ -189,145 +224,550 @@ size_t pso_best_fitness(float *fitness, size_t swarm_size) {
    current_fitness       fitness of particles
    local_best_fitess     local best fitness of each particle
    obj_func              objective function used to compute fitnesss
+   bounds                velocity and position bounds
+   rng                   random stream owned by the calling thread
    swarm_size            number of particles in the swarm
-   simd_dim              dimension of a single particle in terms of __m256
+   dim                   dimension of a single particle, rows are padded to whole __m256
  */
 void update_everything(__m256 *velocity, __m256 *positions,
                        __m256 *local_best_positions,
                        __m256 *global_best_position,
                        float *current_fitness, float* local_best_fitness,
-                       simd_obj_func_t obj_func,
-                       size_t swarm_size, size_t simd_dim) {
+                       simd_obj_func_t obj_func, const pso_bounds_t *bounds,
+                       simd_rng_t *rng, size_t swarm_size, size_t dim) {
+  const size_t simd_dim = (dim + 7) / 8;
+  const __m256 tail = _mm256_castsi256_ps(simd_tail_mask(dim));
+
   for(size_t particle = 0; particle < swarm_size; particle++) {
-    // update velocity for particle
-    for(size_t dimension = 0; dimension < simd_dim; dimension++) {
-      size_t idx = (particle * simd_dim) + dimension;
-      __m256 rand1 = simd_rand_0_to_1();
-      __m256 rand2 = simd_rand_0_to_1();
-      __m256 term1 = _mm256_mul_ps(rand1, _mm256_sub_ps(local_best_positions[idx], positions[idx]));
-      __m256 term2 = _mm256_mul_ps(rand2, _mm256_sub_ps(global_best_position[dimension], positions[idx]));
-      __m256 res = _mm256_mul_ps(inertia, velocity[idx]);
-      res = _mm256_fmadd_ps(cog, term1, res);
-      res = _mm256_fmadd_ps(social, term2, res);
-
-      res = _mm256_min_ps(_mm256_max_ps(v_min_vel, res), v_max_vel);
-
-      velocity[idx] = res;
+    size_t offset = particle * simd_dim;
+    pso_move_vectors(&velocity[offset], &positions[offset], &local_best_positions[offset],
+                     global_best_position, bounds, rng, simd_dim);
+    pso_clear_tail(&velocity[offset], &positions[offset], simd_dim, tail);
+
+    // update fitness for particle
+    current_fitness[particle] = obj_func(&positions[offset], dim);
+
+    pso_update_local_best(local_best_positions, positions, current_fitness, local_best_fitness,
+                          particle, simd_dim);
+  }
+}
+
+void update_everything_counter(__m256 *velocity, __m256 *positions,
+                               __m256 *local_best_positions,
+                               __m256 *global_best_position,
+                               float *current_fitness, float* local_best_fitness,
+                               simd_obj_func_t obj_func, const pso_bounds_t *bounds,
+                               uint64_t seed, size_t iteration, size_t first_particle,
+                               size_t swarm_size, size_t dim) {
+  const size_t simd_dim = (dim + 7) / 8;
+  const __m256 tail = _mm256_castsi256_ps(simd_tail_mask(dim));
+
+  for(size_t particle = 0; particle < swarm_size; particle++) {
+    size_t offset = particle * simd_dim;
+    pso_move_vectors_counter(&velocity[offset], &positions[offset], &local_best_positions[offset],
+                             global_best_position, bounds, seed, (uint32_t)iteration,
+                             (uint32_t)(first_particle + particle), simd_dim);
+    pso_clear_tail(&velocity[offset], &positions[offset], simd_dim, tail);
+
+    current_fitness[particle] = obj_func(&positions[offset], dim);
+
+    pso_update_local_best(local_best_positions, positions, current_fitness, local_best_fitness,
+                          particle, simd_dim);
+  }
+}
+
+/**
+   Transpose the 8x8 block of floats held in `rows` in place.
+ */
+static inline void transpose8x8(__m256 *const rows) {
+  __m256 t0 = _mm256_unpacklo_ps(rows[0], rows[1]);
+  __m256 t1 = _mm256_unpackhi_ps(rows[0], rows[1]);
+  __m256 t2 = _mm256_unpacklo_ps(rows[2], rows[3]);
+  __m256 t3 = _mm256_unpackhi_ps(rows[2], rows[3]);
+  __m256 t4 = _mm256_unpacklo_ps(rows[4], rows[5]);
+  __m256 t5 = _mm256_unpackhi_ps(rows[4], rows[5]);
+  __m256 t6 = _mm256_unpacklo_ps(rows[6], rows[7]);
+  __m256 t7 = _mm256_unpackhi_ps(rows[6], rows[7]);
+  __m256 s0 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0));
+  __m256 s1 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2));
+  __m256 s2 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0));
+  __m256 s3 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(3, 2, 3, 2));
+  __m256 s4 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(1, 0, 1, 0));
+  __m256 s5 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(3, 2, 3, 2));
+  __m256 s6 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(1, 0, 1, 0));
+  __m256 s7 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(3, 2, 3, 2));
+  rows[0] = _mm256_permute2f128_ps(s0, s4, 0x20);
+  rows[1] = _mm256_permute2f128_ps(s1, s5, 0x20);
+  rows[2] = _mm256_permute2f128_ps(s2, s6, 0x20);
+  rows[3] = _mm256_permute2f128_ps(s3, s7, 0x20);
+  rows[4] = _mm256_permute2f128_ps(s0, s4, 0x31);
+  rows[5] = _mm256_permute2f128_ps(s1, s5, 0x31);
+  rows[6] = _mm256_permute2f128_ps(s2, s6, 0x31);
+  rows[7] = _mm256_permute2f128_ps(s3, s7, 0x31);
+}
+
+/**
+   Transpose the rows of `n_particles` (at most 8) consecutive particles into `lanes`,
+   `8 * simd_dim` vectors where vector `d` holds dimension `d` of every particle.
+ */
+void pso_transpose_block(const __m256 *const positions, size_t n_particles, size_t simd_dim,
+                         __m256 *const lanes) {
+  for(size_t vec = 0; vec < simd_dim; vec++) {
+    __m256 *const rows = &lanes[vec * 8];
+    for(size_t particle = 0; particle < 8; particle++) {
+      rows[particle] = particle < n_particles ? positions[particle * simd_dim + vec]
+                                              : _mm256_setzero_ps();
     }
+    transpose8x8(rows);
+  }
+}
 
-    // update position for particle
-    for(size_t dimension = 0; dimension < simd_dim; dimension++) {
-      size_t idx = (particle * simd_dim) + dimension;
-      positions[idx] = _mm256_add_ps(positions[idx], velocity[idx]);
-      positions[idx] = _mm256_min_ps(_mm256_max_ps(v_min_pos, positions[idx]), v_max_pos);
+/**
+   Same as `update_everything`, but the fitness of every block of 8 particles is evaluated
+   with a single call of `lanes_obj_func` on their transposed positions, stored in the
+   `8 * simd_dim` vectors of `lanes`.
+ */
+void update_everything_lanes(__m256 *velocity, __m256 *positions,
+                             __m256 *local_best_positions,
+                             __m256 *global_best_position,
+                             float *current_fitness, float* local_best_fitness,
+                             simd_lanes_obj_func_t lanes_obj_func, const pso_bounds_t *bounds,
+                             simd_rng_t *rng, size_t swarm_size, size_t dim,
+                             __m256 *lanes) {
+  const size_t simd_dim = (dim + 7) / 8;
+  const __m256 tail = _mm256_castsi256_ps(simd_tail_mask(dim));
+
+  for(size_t block = 0; block < swarm_size; block += 8) {
+    size_t n_particles = swarm_size - block < 8 ? swarm_size - block : 8;
+
+    for(size_t particle = block; particle < block + n_particles; particle++) {
+      size_t offset = particle * simd_dim;
+      pso_move_vectors(&velocity[offset], &positions[offset], &local_best_positions[offset],
+                       global_best_position, bounds, rng, simd_dim);
+      pso_clear_tail(&velocity[offset], &positions[offset], simd_dim, tail);
     }
 
-    // update fitness for particle
-    current_fitness[particle] = obj_func(&positions[particle], simd_dim);
-
-    // update local best fitness and position for particle
-    if(current_fitness[particle] < local_best_fitness[particle]) {
-      local_best_fitness[particle] = current_fitness[particle];
-      for(size_t dimension = 0; dimension < simd_dim; dimension++) {
-        size_t j = (particle * simd_dim) + dimension;
-        local_best_positions[j] = positions[j];
-      }
+    // one lane per particle, the missing particles of a partial block are zero
+    float fitness[8];
+    pso_transpose_block(&positions[block * simd_dim], n_particles, simd_dim, lanes);
+    lanes_obj_func(lanes, dim, fitness);
+    memcpy(&current_fitness[block], fitness, n_particles * sizeof(float));
+
+    for(size_t particle = block; particle < block + n_particles; particle++) {
+      pso_update_local_best(local_best_positions, positions, current_fitness, local_best_fitness,
+                            particle, simd_dim);
     }
   }
 }
 
+size_t pso_tile_vectors(size_t l1_size, size_t l2_size) {
+  // velocity, position, local best and global best tiles, the rest of L1 is left to
+  // the stack and to the hardware prefetcher running ahead
+  const size_t bytes_per_vector = 4 * sizeof(__m256);
+  size_t budget = l1_size / 4;
+  if(budget == 0) {
+    budget = l2_size / 32;
+  }
+  if(budget == 0) {
+    budget = 32 * 1024 / 4;
+  }
+  size_t tile = budget / bytes_per_vector / 8 * 8;
+  return tile > 0 ? tile : 8;
+}
 
 /**
-   PSO algorithm.
+   Same as `update_everything`, but each particle is moved in tiles of `tile_vectors`
+   vectors and the objective terms of a tile are accumulated right after it moved. The
+   terms of the last vector of a tile may need the first vector of the next tile, so
+   they are deferred until that one moved as well.
  */
-float *pso_basic(simd_obj_func_t obj_func,
-                 size_t swarm_size,
-                 size_t dim,
-                 size_t max_iter,
-                 const float min_position,
-                 const float max_position) {
-  assert(dim % 8 == 0);
-  assert(swarm_size % 8 == 0);
+void update_everything_tiled(__m256 *velocity, __m256 *positions,
+                             __m256 *local_best_positions,
+                             __m256 *global_best_position,
+                             float *current_fitness, float* local_best_fitness,
+                             simd_tile_obj_func_t tile_obj_func, const pso_bounds_t *bounds,
+                             simd_rng_t *rng, size_t swarm_size, size_t dim,
+                             size_t tile_vectors) {
+  const size_t simd_dim = (dim + 7) / 8;
+  const __m256 tail = _mm256_castsi256_ps(simd_tail_mask(dim));
+
+  for(size_t particle = 0; particle < swarm_size; particle++) {
+    __m256 *const vel = &velocity[particle * simd_dim];
+    __m256 *const pos = &positions[particle * simd_dim];
+    const __m256 *const lbest = &local_best_positions[particle * simd_dim];
+    __m256 fitness = _mm256_setzero_ps();
+    size_t evaluated = 0;
+
+    for(size_t begin = 0; begin < simd_dim; begin += tile_vectors) {
+      size_t end = min(begin + tile_vectors, simd_dim);
+      pso_move_vectors(&vel[begin], &pos[begin], &lbest[begin], &global_best_position[begin],
+                       bounds, rng, end - begin);
+      if(end < simd_dim) {
+        fitness = _mm256_add_ps(fitness, tile_obj_func(pos, evaluated, end - 1, dim));
+        evaluated = end - 1;
+      }
+    }
+    pso_clear_tail(vel, pos, simd_dim, tail);
+    fitness = _mm256_add_ps(fitness, tile_obj_func(pos, evaluated, simd_dim, dim));
+    current_fitness[particle] = horizontal_add(fitness);
+
+    pso_update_local_best(local_best_positions, positions, current_fitness, local_best_fitness,
+                          particle, simd_dim);
+  }
+}
 
-  init_obj_globals();
+/**
+   Computes the first particle of the slice of the swarm owned by `thread` when the
+   swarm is split into `n_threads` contiguous slices.
+ */
+static size_t pso_slice_begin(size_t swarm_size, size_t thread, size_t n_threads) {
+  return swarm_size * thread / n_threads;
+}
 
-  size_t simd_dim = dim / 8;
+/**
+   Create a PSO solve. All state of the solve lives in the returned context, so any
+   number of contexts can be used concurrently from different threads.
+
+   Arguments:
+     obj_func      objective function to minimise
+     swarm_size    number of particles
+     dim           dimension of a particle, rows are padded to whole __m256
+     min_position  lower bound of every dimension
+     max_position  upper bound of every dimension
+     n_threads     number of threads `pso_step` uses, 0 uses `pso_default_num_threads()`
+     seed          seed of the random streams of this solve
+
+   Returns:
+     The context, to be released with `pso_destroy`.
+ */
+pso_ctx_t *pso_create(simd_obj_func_t obj_func,
+                      size_t swarm_size,
+                      size_t dim,
+                      const float min_position,
+                      const float max_position,
+                      size_t n_threads,
+                      size_t seed) {
+  assert(dim > 0);
+  assert(swarm_size > 0);
+
+  pso_ctx_t *const ctx = (pso_ctx_t*)aligned_alloc(sizeof(__m256), sizeof(pso_ctx_t));
+  if (!ctx) { perror("malloc arr"); exit(EXIT_FAILURE); };
+
+  size_t simd_dim = (dim + 7) / 8;
+
+  if(n_threads == 0) {
+    n_threads = pso_default_num_threads();
+  }
 
-  seed_simd_rng(100);
+  ctx->obj_func = opt_simd_dim_variant(obj_func, dim);
+  ctx->update_func = NULL;
+  ctx->lanes_obj_func = NULL;
+  ctx->tile_obj_func = NULL;
+  ctx->tile_vectors = 0;
+  ctx->swarm_size = swarm_size;
+  ctx->dim = dim;
+  ctx->simd_dim = simd_dim;
+  ctx->n_threads = n_threads;
+  ctx->iteration = 0;
+  ctx->seed = seed;
+  ctx->counter_rng = 0;
+
+  ctx->rngs = (simd_rng_t*)aligned_alloc(sizeof(simd_rng_t), n_threads * sizeof(simd_rng_t));
+  if (!ctx->rngs) { perror("malloc arr"); exit(EXIT_FAILURE); };
+  seed_simd_rng(ctx->rngs, n_threads, seed);
 
   float min_vel = min_position/VEL_LIMIT_SCALE;
   float max_vel = max_position/VEL_LIMIT_SCALE;
 
-  initialise_velocity_bounds(min_vel, max_vel);
-  initialise_position_bounds(min_position, max_position);
+  initialise_velocity_bounds(&ctx->bounds, min_vel, max_vel);
+  initialise_position_bounds(&ctx->bounds, min_position, max_position);
 
   size_t sizeof_position = swarm_size * simd_dim * sizeof(__m256);
-  __m256 *current_positions = (__m256*)malloc(sizeof_position);
-  if (!current_positions) { perror("malloc arr"); exit(EXIT_FAILURE); };
-  pso_rand_init(current_positions, swarm_size * simd_dim);
-  __m256 *local_best_positions = (__m256*)malloc(sizeof_position);
-  if (!local_best_positions) { perror("malloc arr"); exit(EXIT_FAILURE); };
-  memcpy(local_best_positions, current_positions, sizeof_position);
-  __m256 *global_best_position = (__m256*)malloc(simd_dim * sizeof(__m256));
+  ctx->positions = (__m256*)aligned_alloc(sizeof(__m256), sizeof_position);
+  if (!ctx->positions) { perror("malloc arr"); exit(EXIT_FAILURE); };
+  pso_rand_init(&ctx->rngs[0], &ctx->bounds, ctx->positions, swarm_size * simd_dim);
+  pso_clear_tails(ctx->positions, swarm_size, dim);
+  ctx->local_best_positions = (__m256*)aligned_alloc(sizeof(__m256), sizeof_position);
+  if (!ctx->local_best_positions) { perror("malloc arr"); exit(EXIT_FAILURE); };
+  memcpy(ctx->local_best_positions, ctx->positions, sizeof_position);
+  ctx->global_best_position = (__m256*)aligned_alloc(sizeof(__m256), simd_dim * sizeof(__m256));
+  if (!ctx->global_best_position) { perror("malloc arr"); exit(EXIT_FAILURE); };
 
   size_t sizeof_fitness = swarm_size * sizeof(float);
-  float *current_fitness = (float*)malloc(sizeof_fitness);
-  if (!current_fitness) { perror("malloc arr"); exit(EXIT_FAILURE); };
-  pso_eval_fitness(obj_func, swarm_size, simd_dim, current_positions, current_fitness);
+  ctx->current_fitness = (float*)malloc(sizeof_fitness);
+  if (!ctx->current_fitness) { perror("malloc arr"); exit(EXIT_FAILURE); };
+  pso_eval_fitness(obj_func, swarm_size, dim, ctx->positions, ctx->current_fitness);
 
-  float *local_best_fitness = (float*)malloc(sizeof_fitness);
-  if (!local_best_fitness) { perror("malloc arr"); exit(EXIT_FAILURE); };
-  memcpy(local_best_fitness, current_fitness, sizeof_fitness);
+  ctx->local_best_fitness = (float*)malloc(sizeof_fitness);
+  if (!ctx->local_best_fitness) { perror("malloc arr"); exit(EXIT_FAILURE); };
+  memcpy(ctx->local_best_fitness, ctx->current_fitness, sizeof_fitness);
 
   #ifdef DEBUG
-      simd_print_population(swarm_size, dim, current_positions);
-      printf("# AVG FITNESS: %f\n", average_value(swarm_size, current_fitness));
-      printf("# BEST FITNESS: %f\n", lowest_value(swarm_size, local_best_fitness));
+      simd_print_population(swarm_size, dim, ctx->positions);
+      printf("# AVG FITNESS: %f\n", average_value(swarm_size, ctx->current_fitness));
+      printf("# BEST FITNESS: %f\n", lowest_value(swarm_size, ctx->local_best_fitness));
   #endif
 
-  __m256 *p_velocity = (__m256*)malloc(sizeof_position);
-  if (!p_velocity) { perror("malloc arr"); exit(EXIT_FAILURE); };
+  ctx->velocity = (__m256*)aligned_alloc(sizeof(__m256), sizeof_position);
+  if (!ctx->velocity) { perror("malloc arr"); exit(EXIT_FAILURE); };
 
-  pso_gen_init_velocity(p_velocity, current_positions, swarm_size, simd_dim);
+  pso_gen_init_velocity(&ctx->rngs[0], &ctx->bounds, ctx->velocity, ctx->positions,
+                        swarm_size, simd_dim);
+  pso_clear_tails(ctx->velocity, swarm_size, dim);
 
-  size_t global_best_idx = pso_best_fitness(local_best_fitness, swarm_size);
-  memcpy(global_best_position, &local_best_positions[simd_dim * global_best_idx], simd_dim * sizeof(__m256));
+  ctx->global_best_idx = pso_best_fitness(ctx->local_best_fitness, swarm_size);
+  memcpy(ctx->global_best_position, &ctx->local_best_positions[simd_dim * ctx->global_best_idx],
+         simd_dim * sizeof(__m256));
 
-  float global_best_fitness = local_best_fitness[global_best_idx];
+  ctx->slice_best_idx = filled_size_t_array(n_threads, SIZE_MAX);
+  if (!ctx->slice_best_idx) { perror("malloc arr"); exit(EXIT_FAILURE); };
 
-  for(size_t iter = 0; iter < max_iter; iter++) {
-    update_everything(p_velocity, current_positions, local_best_positions,
-                      global_best_position, current_fitness, local_best_fitness,
-                      obj_func, swarm_size, simd_dim);
+  return ctx;
+}
 
-    global_best_idx = pso_best_fitness(local_best_fitness, swarm_size);
-    memcpy(global_best_position, &local_best_positions[simd_dim * global_best_idx], simd_dim * sizeof(__m256));
+/**
+   Run `n_iter` iterations of the solve on `ctx->n_threads` threads.
 
-    global_best_fitness = local_best_fitness[global_best_idx];
+   The swarm is split into one contiguous slice per thread and every thread draws from
+   its own random stream. Between iterations each thread finds the best particle of its
+   own slice, after which a single thread combines the per-thread candidates and
+   broadcasts the new global best position.
+ */
+void pso_step(pso_ctx_t *const ctx, size_t n_iter) {
+  const size_t swarm_size = ctx->swarm_size;
+  const size_t simd_dim = ctx->simd_dim;
+
+  #pragma omp parallel num_threads(ctx->n_threads)
+  {
+#ifdef _OPENMP
+    size_t thread = (size_t)omp_get_thread_num();
+    size_t team_size = (size_t)omp_get_num_threads();
+#else
+    size_t thread = 0;
+    size_t team_size = 1;
+#endif
+    size_t begin = pso_slice_begin(swarm_size, thread, team_size);
+    size_t count = pso_slice_begin(swarm_size, thread + 1, team_size) - begin;
+    size_t offset = begin * simd_dim;
+
+    // transposed positions of one block of 8 particles for the cross-particle objective
+    __m256 *lanes = NULL;
+    if(ctx->lanes_obj_func && !ctx->update_func && !ctx->counter_rng) {
+      lanes = (__m256*)aligned_alloc(sizeof(__m256), simd_dim * 8 * sizeof(__m256));
+      if (!lanes) { perror("malloc arr"); exit(EXIT_FAILURE); };
+    }
 
-  #ifdef DEBUG
-      simd_print_population(swarm_size, dim, current_positions);
-      printf("# AVG FITNESS: %f\n", average_value(swarm_size, local_best_fitness));
-      printf("# BEST FITNESS: %f\n", lowest_value(swarm_size, local_best_fitness));
-  #endif
+    for(size_t iter = 0; iter < n_iter; iter++) {
+      if(ctx->counter_rng) {
+        update_everything_counter(&ctx->velocity[offset], &ctx->positions[offset],
+                                  &ctx->local_best_positions[offset], ctx->global_best_position,
+                                  &ctx->current_fitness[begin], &ctx->local_best_fitness[begin],
+                                  ctx->obj_func, &ctx->bounds, ctx->seed, ctx->iteration, begin,
+                                  count, ctx->dim);
+      } else if(ctx->update_func) {
+        ctx->update_func(ctx, begin, count, &ctx->rngs[thread]);
+      } else if(lanes) {
+        update_everything_lanes(&ctx->velocity[offset], &ctx->positions[offset],
+                                &ctx->local_best_positions[offset], ctx->global_best_position,
+                                &ctx->current_fitness[begin], &ctx->local_best_fitness[begin],
+                                ctx->lanes_obj_func, &ctx->bounds, &ctx->rngs[thread], count,
+                                ctx->dim, lanes);
+      } else if(ctx->tile_obj_func) {
+        update_everything_tiled(&ctx->velocity[offset], &ctx->positions[offset],
+                                &ctx->local_best_positions[offset], ctx->global_best_position,
+                                &ctx->current_fitness[begin], &ctx->local_best_fitness[begin],
+                                ctx->tile_obj_func, &ctx->bounds, &ctx->rngs[thread], count,
+                                ctx->dim, ctx->tile_vectors);
+      } else {
+        update_everything(&ctx->velocity[offset], &ctx->positions[offset],
+                          &ctx->local_best_positions[offset], ctx->global_best_position,
+                          &ctx->current_fitness[begin], &ctx->local_best_fitness[begin],
+                          ctx->obj_func, &ctx->bounds, &ctx->rngs[thread], count, ctx->dim);
+      }
+
+      if(count > 0) {
+        ctx->slice_best_idx[thread] = begin + pso_best_fitness(&ctx->local_best_fitness[begin], count);
+      }
+
+      // every slice must be updated before the global best can change
+      #pragma omp barrier
+
+      #pragma omp single
+      {
+        for(size_t candidate = 0; candidate < team_size; candidate++) {
+          size_t idx = ctx->slice_best_idx[candidate];
+          if(idx != SIZE_MAX &&
+             ctx->local_best_fitness[idx] < ctx->local_best_fitness[ctx->global_best_idx]) {
+            ctx->global_best_idx = idx;
+          }
+        }
+        memcpy(ctx->global_best_position,
+               &ctx->local_best_positions[simd_dim * ctx->global_best_idx],
+               simd_dim * sizeof(__m256));
+
+        ctx->iteration++;
+
+      #ifdef DEBUG
+          simd_print_population(swarm_size, ctx->dim, ctx->positions);
+          printf("# AVG FITNESS: %f\n", average_value(swarm_size, ctx->local_best_fitness));
+          printf("# BEST FITNESS: %f\n", lowest_value(swarm_size, ctx->local_best_fitness));
+      #endif
+      } // implicit barrier, all threads see the new global best
+    }
+
+    free(lanes);
+  }
+}
+
+void pso_use_lanes_objective(pso_ctx_t *const ctx, simd_lanes_obj_func_t lanes_obj_func) {
+  ctx->lanes_obj_func = lanes_obj_func;
+}
+
+void pso_use_counter_rng(pso_ctx_t *const ctx, int enable) {
+  ctx->counter_rng = enable;
+}
+
+void pso_use_update(pso_ctx_t *const ctx, pso_update_func_t update_func) {
+  ctx->update_func = update_func;
+}
+
+void pso_use_tiled_objective(pso_ctx_t *const ctx, simd_tile_obj_func_t tile_obj_func,
+                             size_t tile_vectors) {
+  if(tile_vectors == 0) {
+    tile_vectors = pso_tile_vectors(detect_cache_size(1), detect_cache_size(2));
+  }
+  ctx->tile_obj_func = tile_obj_func;
+  ctx->tile_vectors = tile_vectors;
+}
+
+/**
+   Copy the best position found so far into `solution` (`ctx->dim` floats).
+
+   Returns:
+     The objective value of that position.
+ */
+float pso_result(const pso_ctx_t *const ctx, float *const solution) {
+  const size_t last = ctx->simd_dim - 1;
+  for(size_t idx = 0; idx < last; idx++) {
+    _mm256_storeu_ps(&solution[idx * 8], ctx->global_best_position[idx]);
+  }
+  // `solution` has no room for the padding lanes
+  _mm256_maskstore_ps(&solution[last * 8], simd_tail_mask(ctx->dim), ctx->global_best_position[last]);
+  return ctx->local_best_fitness[ctx->global_best_idx];
+}
+
+/**
+   Release all memory held by `ctx`.
+ */
+void pso_destroy(pso_ctx_t *const ctx) {
+  free(ctx->positions);
+  free(ctx->local_best_positions);
+  free(ctx->current_fitness);
+  free(ctx->local_best_fitness);
+  free(ctx->velocity);
+  free(ctx->global_best_position);
+  free(ctx->slice_best_idx);
+  free(ctx->rngs);
+  free(ctx);
+}
 
+/**
+   PSO algorithm running the swarm on `n_threads` threads.
+
+   Arguments:
+     n_threads  number of threads to use, 0 uses `pso_default_num_threads()`
+ */
+float *pso_parallel(simd_obj_func_t obj_func,
+                    size_t swarm_size,
+                    size_t dim,
+                    size_t max_iter,
+                    const float min_position,
+                    const float max_position,
+                    size_t n_threads) {
+  pso_ctx_t *ctx = pso_create(obj_func, swarm_size, dim, min_position, max_position,
+                              n_threads, 100);
+  if(dim >= PSO_TILED_MIN_DIM) {
+    pso_use_tiled_objective(ctx, opt_simd_tile_variant(obj_func), 0);
   }
 
+  pso_step(ctx, max_iter);
+
   float *const best_solution = (float *const)malloc(dim * sizeof(float));
   if (!best_solution) { perror("malloc arr"); exit(EXIT_FAILURE); };
+  pso_result(ctx, best_solution);
 
-  // TODO copy this properly
-  for(size_t idx = 0; idx < simd_dim; idx++) {
-    _mm256_storeu_ps(&best_solution[idx * 8], global_best_position[idx]);
-  }
-  /* memcpy(best_solution, global_best_position , dim * sizeof(float)); */
-
-  free(current_positions);
-  free(local_best_positions);
-  free(current_fitness);
-  free(local_best_fitness);
-  free(p_velocity);
-  free(global_best_position);
+  pso_destroy(ctx);
+
+  return best_solution;
+}
+/**
+   PSO algorithm, single threaded.
+ */
+float *pso_basic(simd_obj_func_t obj_func,
+                 size_t swarm_size,
+                 size_t dim,
+                 size_t max_iter,
+                 const float min_position,
+                 const float max_position) {
+  return pso_parallel(obj_func, swarm_size, dim, max_iter, min_position, max_position, 1);
+}
+
+/**
+   PSO algorithm using `pso_default_num_threads()` threads.
+ */
+float *pso_basic_mt(simd_obj_func_t obj_func,
+                    size_t swarm_size,
+                    size_t dim,
+                    size_t max_iter,
+                    const float min_position,
+                    const float max_position) {
+  return pso_parallel(obj_func, swarm_size, dim, max_iter, min_position, max_position, 0);
+}
+
+/**
+   PSO algorithm evaluating the fitness of 8 particles at a time with the cross-particle
+   variant of `obj_func`. Falls back to one particle at a time if there is none.
+ */
+float *pso_basic_x8(simd_obj_func_t obj_func,
+                    size_t swarm_size,
+                    size_t dim,
+                    size_t max_iter,
+                    const float min_position,
+                    const float max_position) {
+  pso_ctx_t *ctx = pso_create(obj_func, swarm_size, dim, min_position, max_position, 1, 100);
+  pso_use_lanes_objective(ctx, opt_simd_lanes_variant(obj_func));
+
+  pso_step(ctx, max_iter);
+
+  float *const best_solution = (float *const)malloc(dim * sizeof(float));
+  if (!best_solution) { perror("malloc arr"); exit(EXIT_FAILURE); };
+  pso_result(ctx, best_solution);
+
+  pso_destroy(ctx);
+
+  return best_solution;
+}
+
+/**
+   PSO algorithm using `pso_default_num_threads()` threads and Philox counters for the
+   random draws, reproducible on any number of threads.
+ */
+float *pso_basic_mt_counter(simd_obj_func_t obj_func,
+                            size_t swarm_size,
+                            size_t dim,
+                            size_t max_iter,
+                            const float min_position,
+                            const float max_position) {
+  pso_ctx_t *ctx = pso_create(obj_func, swarm_size, dim, min_position, max_position, 0, 100);
+  pso_use_counter_rng(ctx, 1);
+
+  pso_step(ctx, max_iter);
+
+  float *const best_solution = (float *const)malloc(dim * sizeof(float));
+  if (!best_solution) { perror("malloc arr"); exit(EXIT_FAILURE); };
+  pso_result(ctx, best_solution);
+
+  pso_destroy(ctx);
 
   return best_solution;
 }
@@ -0,0 +1,283 @@
+/**
+   AVX2 PSO engine with interleaved (AoSoA) storage of the position, velocity and local
+   best position of every particle, see `pso_aosoa_ctx_t`.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <stdint.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "pso.h"
+#include "pso_aosoa.h"
+#include "pso_kernels.h"
+#include "utils.h"
+
+
+/**
+   First vector of block `block` of `particle`, its position. The velocity follows after
+   `aosoa_block_len` vectors and the local best position after twice as many.
+ */
+static inline __m256 *aosoa_block(const pso_aosoa_ctx_t *const ctx, size_t particle, size_t block) {
+  return &ctx->particles[(particle * 3 * ctx->simd_dim) + (block * 3 * ctx->block_size)];
+}
+
+/**
+   Number of vectors in block `block` of every stream, only the last one may be shorter.
+ */
+static inline size_t aosoa_block_len(const pso_aosoa_ctx_t *const ctx, size_t block) {
+  size_t begin = block * ctx->block_size;
+  return ctx->simd_dim - begin < ctx->block_size ? ctx->simd_dim - begin : ctx->block_size;
+}
+
+/**
+   Copy the local best position of `particle` into the contiguous `dest`.
+ */
+static void aosoa_gather_local_best(const pso_aosoa_ctx_t *const ctx, size_t particle,
+                                    __m256 *const dest) {
+  for(size_t block = 0; block * ctx->block_size < ctx->simd_dim; block++) {
+    size_t len = aosoa_block_len(ctx, block);
+    memcpy(&dest[block * ctx->block_size], aosoa_block(ctx, particle, block) + 2 * len,
+           len * sizeof(__m256));
+  }
+}
+
+/**
+   Move the particles `begin` to `begin + count` and update their fitness and local best.
+   With more than one block, the position of the current particle is collected in
+   `scratch` for the objective.
+ */
+static void aosoa_update_everything(pso_aosoa_ctx_t *const ctx, size_t begin, size_t count,
+                                    simd_rng_t *const rng, __m256 *const scratch) {
+  const size_t block_size = ctx->block_size;
+  const size_t simd_dim = ctx->simd_dim;
+  const __m256 tail = _mm256_castsi256_ps(simd_tail_mask(ctx->dim));
+
+  for(size_t particle = begin; particle < begin + count; particle++) {
+    size_t block = 0;
+    size_t len = 0;
+    __m256 *pos = NULL;
+    for(; block * block_size < simd_dim; block++) {
+      len = aosoa_block_len(ctx, block);
+      pos = aosoa_block(ctx, particle, block);
+      pso_move_vectors(pos + len, pos, pos + 2 * len, &ctx->global_best_position[block * block_size],
+                       &ctx->bounds, rng, len);
+    }
+    // pos and len still describe the last block
+    pso_clear_tail(pos + len, pos, len, tail);
+
+    if(block == 1) {
+      // a single block holds the whole position contiguously
+      ctx->current_fitness[particle] = ctx->obj_func(pos, ctx->dim);
+    } else {
+      for(block = 0; block * block_size < simd_dim; block++) {
+        memcpy(&scratch[block * block_size], aosoa_block(ctx, particle, block),
+               aosoa_block_len(ctx, block) * sizeof(__m256));
+      }
+      ctx->current_fitness[particle] = ctx->obj_func(scratch, ctx->dim);
+    }
+
+    if(ctx->current_fitness[particle] < ctx->local_best_fitness[particle]) {
+      ctx->local_best_fitness[particle] = ctx->current_fitness[particle];
+      for(block = 0; block * block_size < simd_dim; block++) {
+        len = aosoa_block_len(ctx, block);
+        pos = aosoa_block(ctx, particle, block);
+        memcpy(pos + 2 * len, pos, len * sizeof(__m256));
+      }
+    }
+  }
+}
+
+/**
+   First particle of the slice of the swarm owned by `thread`.
+ */
+static size_t aosoa_slice_begin(size_t swarm_size, size_t thread, size_t n_threads) {
+  return swarm_size * thread / n_threads;
+}
+
+pso_aosoa_ctx_t *pso_aosoa_create(simd_obj_func_t obj_func,
+                                  size_t swarm_size,
+                                  size_t dim,
+                                  const float min_position,
+                                  const float max_position,
+                                  size_t block_size,
+                                  size_t n_threads,
+                                  size_t seed) {
+  assert(dim > 0);
+  assert(swarm_size > 0);
+
+  pso_aosoa_ctx_t *const ctx = (pso_aosoa_ctx_t*)aligned_alloc(sizeof(__m256), sizeof(pso_aosoa_ctx_t));
+  if (!ctx) { perror("malloc arr"); exit(EXIT_FAILURE); };
+
+  size_t simd_dim = (dim + 7) / 8;
+
+  if(n_threads == 0) {
+    n_threads = pso_default_num_threads();
+  }
+  if(block_size == 0) {
+    block_size = PSO_AOSOA_DEFAULT_BLOCK;
+  }
+
+  ctx->obj_func = obj_func;
+  ctx->swarm_size = swarm_size;
+  ctx->dim = dim;
+  ctx->simd_dim = simd_dim;
+  ctx->block_size = block_size;
+  ctx->n_threads = n_threads;
+  ctx->iteration = 0;
+
+  ctx->rngs = (simd_rng_t*)aligned_alloc(sizeof(simd_rng_t), n_threads * sizeof(simd_rng_t));
+  if (!ctx->rngs) { perror("malloc arr"); exit(EXIT_FAILURE); };
+  seed_simd_rng(ctx->rngs, n_threads, seed);
+
+  initialise_velocity_bounds(&ctx->bounds, min_position / VEL_LIMIT_SCALE, max_position / VEL_LIMIT_SCALE);
+  initialise_position_bounds(&ctx->bounds, min_position, max_position);
+
+  ctx->particles = (__m256*)aligned_alloc(sizeof(__m256), swarm_size * 3 * simd_dim * sizeof(__m256));
+  if (!ctx->particles) { perror("malloc arr"); exit(EXIT_FAILURE); };
+  ctx->global_best_position = (__m256*)aligned_alloc(sizeof(__m256), simd_dim * sizeof(__m256));
+  if (!ctx->global_best_position) { perror("malloc arr"); exit(EXIT_FAILURE); };
+  // keep the scratch rows of different threads on different cache lines
+  ctx->scratch_stride = (simd_dim + 1) / 2 * 2;
+  ctx->scratch = (__m256*)aligned_alloc(64, n_threads * ctx->scratch_stride * sizeof(__m256));
+  if (!ctx->scratch) { perror("malloc arr"); exit(EXIT_FAILURE); };
+
+  ctx->current_fitness = (float*)malloc(swarm_size * sizeof(float));
+  if (!ctx->current_fitness) { perror("malloc arr"); exit(EXIT_FAILURE); };
+  ctx->local_best_fitness = (float*)malloc(swarm_size * sizeof(float));
+  if (!ctx->local_best_fitness) { perror("malloc arr"); exit(EXIT_FAILURE); };
+
+  // random positions, initial velocity a quarter of the way towards another random position
+  const __m256 tail = _mm256_castsi256_ps(simd_tail_mask(dim));
+  const __m256 quarter = _mm256_set1_ps(0.25);
+  for(size_t particle = 0; particle < swarm_size; particle++) {
+    size_t len = 0;
+    __m256 *pos = NULL;
+    for(size_t block = 0; block * block_size < simd_dim; block++) {
+      len = aosoa_block_len(ctx, block);
+      pos = aosoa_block(ctx, particle, block);
+      for(size_t idx = 0; idx < len; idx++) {
+        pos[idx] = simd_rand_min_max(&ctx->rngs[0], &ctx->bounds);
+        __m256 target = simd_rand_min_max(&ctx->rngs[0], &ctx->bounds);
+        pos[len + idx] = _mm256_mul_ps(quarter, _mm256_sub_ps(target, pos[idx]));
+      }
+    }
+    pso_clear_tail(pos + len, pos, len, tail);
+    for(size_t block = 0; block * block_size < simd_dim; block++) {
+      len = aosoa_block_len(ctx, block);
+      pos = aosoa_block(ctx, particle, block);
+      memcpy(pos + 2 * len, pos, len * sizeof(__m256));
+    }
+
+    aosoa_gather_local_best(ctx, particle, ctx->scratch);
+    ctx->current_fitness[particle] = obj_func(ctx->scratch, dim);
+  }
+  memcpy(ctx->local_best_fitness, ctx->current_fitness, swarm_size * sizeof(float));
+
+  ctx->global_best_idx = pso_best_fitness(ctx->local_best_fitness, swarm_size);
+  aosoa_gather_local_best(ctx, ctx->global_best_idx, ctx->global_best_position);
+
+  ctx->slice_best_idx = filled_size_t_array(n_threads, SIZE_MAX);
+  if (!ctx->slice_best_idx) { perror("malloc arr"); exit(EXIT_FAILURE); };
+
+  return ctx;
+}
+
+void pso_aosoa_step(pso_aosoa_ctx_t *const ctx, size_t n_iter) {
+  const size_t swarm_size = ctx->swarm_size;
+
+  #pragma omp parallel num_threads(ctx->n_threads)
+  {
+#ifdef _OPENMP
+    size_t thread = (size_t)omp_get_thread_num();
+    size_t team_size = (size_t)omp_get_num_threads();
+#else
+    size_t thread = 0;
+    size_t team_size = 1;
+#endif
+    size_t begin = aosoa_slice_begin(swarm_size, thread, team_size);
+    size_t count = aosoa_slice_begin(swarm_size, thread + 1, team_size) - begin;
+    __m256 *const scratch = &ctx->scratch[thread * ctx->scratch_stride];
+
+    for(size_t iter = 0; iter < n_iter; iter++) {
+      aosoa_update_everything(ctx, begin, count, &ctx->rngs[thread], scratch);
+
+      if(count > 0) {
+        ctx->slice_best_idx[thread] = begin + pso_best_fitness(&ctx->local_best_fitness[begin], count);
+      }
+
+      // every slice must be updated before the global best can change
+      #pragma omp barrier
+
+      #pragma omp single
+      {
+        for(size_t candidate = 0; candidate < team_size; candidate++) {
+          size_t idx = ctx->slice_best_idx[candidate];
+          if(idx != SIZE_MAX &&
+             ctx->local_best_fitness[idx] < ctx->local_best_fitness[ctx->global_best_idx]) {
+            ctx->global_best_idx = idx;
+          }
+        }
+        aosoa_gather_local_best(ctx, ctx->global_best_idx, ctx->global_best_position);
+
+        ctx->iteration++;
+      } // implicit barrier, all threads see the new global best
+    }
+  }
+}
+
+float pso_aosoa_result(const pso_aosoa_ctx_t *const ctx, float *const solution) {
+  const size_t last = ctx->simd_dim - 1;
+  for(size_t idx = 0; idx < last; idx++) {
+    _mm256_storeu_ps(&solution[idx * 8], ctx->global_best_position[idx]);
+  }
+  _mm256_maskstore_ps(&solution[last * 8], simd_tail_mask(ctx->dim), ctx->global_best_position[last]);
+  return ctx->local_best_fitness[ctx->global_best_idx];
+}
+
+void pso_aosoa_destroy(pso_aosoa_ctx_t *const ctx) {
+  free(ctx->particles);
+  free(ctx->global_best_position);
+  free(ctx->scratch);
+  free(ctx->current_fitness);
+  free(ctx->local_best_fitness);
+  free(ctx->slice_best_idx);
+  free(ctx->rngs);
+  free(ctx);
+}
+
+float *pso_parallel_aosoa(simd_obj_func_t obj_func,
+                          size_t swarm_size,
+                          size_t dim,
+                          size_t max_iter,
+                          const float min_position,
+                          const float max_position,
+                          size_t block_size,
+                          size_t n_threads) {
+  pso_aosoa_ctx_t *ctx = pso_aosoa_create(obj_func, swarm_size, dim, min_position, max_position,
+                                          block_size, n_threads, 100);
+
+  pso_aosoa_step(ctx, max_iter);
+
+  float *const best_solution = (float *const)malloc(dim * sizeof(float));
+  if (!best_solution) { perror("malloc arr"); exit(EXIT_FAILURE); };
+  pso_aosoa_result(ctx, best_solution);
+
+  pso_aosoa_destroy(ctx);
+
+  return best_solution;
+}
+
+float *pso_basic_aosoa(simd_obj_func_t obj_func,
+                       size_t swarm_size,
+                       size_t dim,
+                       size_t max_iter,
+                       const float min_position,
+                       const float max_position) {
+  return pso_parallel_aosoa(obj_func, swarm_size, dim, max_iter, min_position, max_position, 0, 1);
+}
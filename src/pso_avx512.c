@@ -0,0 +1,332 @@
+/**
+   AVX-512 implementation of the PSO engine. Works on 16 lanes per vector and keeps
+   the particles inside their bounds with mask registers instead of min/max chains.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <stdint.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "pso.h"
+#include "pso_avx512.h"
+#include "rng.h"
+#include "utils.h"
+
+
+void seed_simd512_rng(simd512_rng_t *const streams, size_t n_streams, size_t seed) {
+  uint64_t state = seed;
+  for(size_t stream = 0; stream < n_streams; stream++) {
+    long long lanes[8];
+    for(size_t lane = 0; lane < 8; lane++) {
+      lanes[lane] = (long long)splitmix64(&state);
+    }
+    streams[stream].state = _mm512_loadu_si512(lanes);
+  }
+}
+
+/**
+   Generate a vector of 16 random floats between 0 and 1, same xorshift as the
+   AVX2 engine on eight 64 bit lanes.
+ */
+static inline __m512 simd512_rand_0_to_1(simd512_rng_t *const rng) {
+  const __m512i s0 = rng->state;
+  const __m512i s1 = _mm512_xor_si512(s0, _mm512_slli_epi64(s0, 23));
+
+  const __m512i lhs = _mm512_xor_si512(_mm512_xor_si512(s1, s0), _mm512_srli_epi64(s1, 18));
+  const __m512i rhs = _mm512_srli_epi64(s0, 5);
+
+  rng->state = _mm512_xor_si512(lhs, rhs);
+  const __m512 rands = _mm512_cvtepi32_ps(_mm512_abs_epi32(_mm512_add_epi64(rng->state, s0)));
+  return _mm512_mul_ps(rands, _mm512_set1_ps(1.0f / 2147483648.0f));
+}
+
+/**
+   Clamp all lanes of `x` into [`lo`, `hi`] using comparison masks.
+ */
+static inline __m512 clamp512(__m512 x, const __m512 lo, const __m512 hi) {
+  const __mmask16 below = _mm512_cmp_ps_mask(x, lo, _CMP_LT_OQ);
+  const __mmask16 above = _mm512_cmp_ps_mask(x, hi, _CMP_GT_OQ);
+  x = _mm512_mask_mov_ps(x, below, lo);
+  return _mm512_mask_mov_ps(x, above, hi);
+}
+
+void pso512_rand_init(simd512_rng_t *const rng, const pso512_bounds_t *const bounds,
+                      __m512 *const array, size_t length) {
+  const __m512 factor_min_to_max = _mm512_sub_ps(bounds->max_pos, bounds->min_pos);
+  for(size_t idx = 0; idx < length; idx++) {
+    array[idx] = _mm512_fmadd_ps(simd512_rand_0_to_1(rng), factor_min_to_max, bounds->min_pos);
+  }
+}
+
+/**
+   Mask of the lanes of the last vector of a `dim` long particle that hold data.
+ */
+static inline __mmask16 pso512_tail_mask(size_t dim) {
+  const size_t rem = dim % 16;
+  return rem ? (__mmask16)((1u << rem) - 1) : (__mmask16)0xffff;
+}
+
+/**
+   Evaluate the fitness of `swarm_size` particles of `dim` floats each.
+ */
+static void pso512_eval_fitness(avx512_obj_func_t obj_func,
+                                size_t swarm_size, size_t dim,
+                                const __m512 *const positions, float *const fitness) {
+  const size_t simd_dim = (dim + 15) / 16;
+  for(size_t particle = 0; particle < swarm_size; particle++) {
+    fitness[particle] = obj_func(&positions[particle * simd_dim], dim);
+  }
+}
+
+/**
+   Zero the padding lanes past `dim` in the last vector of every particle.
+ */
+static void pso512_clear_tails(__m512 *const array, size_t swarm_size, size_t dim) {
+  const size_t simd_dim = (dim + 15) / 16;
+  const __mmask16 tail = pso512_tail_mask(dim);
+  for(size_t particle = 0; particle < swarm_size; particle++) {
+    size_t last = (particle + 1) * simd_dim - 1;
+    array[last] = _mm512_maskz_mov_ps(tail, array[last]);
+  }
+}
+
+void pso512_update_everything(__m512 *const velocity, __m512 *const positions,
+                              __m512 *const local_best_positions,
+                              const __m512 *const global_best_position,
+                              float *const current_fitness, float *const local_best_fitness,
+                              avx512_obj_func_t obj_func, const pso512_bounds_t *const bounds,
+                              simd512_rng_t *const rng, size_t swarm_size, size_t dim) {
+  const __m512 inertia = _mm512_set1_ps(INERTIA);
+  const __m512 cog = _mm512_set1_ps(COG);
+  const __m512 social = _mm512_set1_ps(SOCIAL);
+  const size_t simd_dim = (dim + 15) / 16;
+  const __mmask16 tail = pso512_tail_mask(dim);
+
+  for(size_t particle = 0; particle < swarm_size; particle++) {
+    // update velocity and position for particle
+    for(size_t dimension = 0; dimension < simd_dim; dimension++) {
+      size_t idx = (particle * simd_dim) + dimension;
+      __m512 rand1 = simd512_rand_0_to_1(rng);
+      __m512 rand2 = simd512_rand_0_to_1(rng);
+      __m512 term1 = _mm512_mul_ps(rand1, _mm512_sub_ps(local_best_positions[idx], positions[idx]));
+      __m512 term2 = _mm512_mul_ps(rand2, _mm512_sub_ps(global_best_position[dimension], positions[idx]));
+      __m512 res = _mm512_mul_ps(inertia, velocity[idx]);
+      res = _mm512_fmadd_ps(cog, term1, res);
+      res = _mm512_fmadd_ps(social, term2, res);
+      res = clamp512(res, bounds->min_vel, bounds->max_vel);
+
+      velocity[idx] = res;
+      positions[idx] = clamp512(_mm512_add_ps(positions[idx], res), bounds->min_pos, bounds->max_pos);
+    }
+    // padding lanes stay at zero, the bounds may not contain zero
+    size_t last = (particle + 1) * simd_dim - 1;
+    velocity[last] = _mm512_maskz_mov_ps(tail, velocity[last]);
+    positions[last] = _mm512_maskz_mov_ps(tail, positions[last]);
+
+    // update fitness for particle
+    current_fitness[particle] = obj_func(&positions[particle * simd_dim], dim);
+
+    // update local best fitness and position for particle
+    if(current_fitness[particle] < local_best_fitness[particle]) {
+      local_best_fitness[particle] = current_fitness[particle];
+      memcpy(&local_best_positions[particle * simd_dim], &positions[particle * simd_dim],
+             simd_dim * sizeof(__m512));
+    }
+  }
+}
+
+/**
+   First particle of the slice of the swarm owned by `thread`.
+ */
+static size_t pso512_slice_begin(size_t swarm_size, size_t thread, size_t n_threads) {
+  return swarm_size * thread / n_threads;
+}
+
+pso512_ctx_t *pso512_create(avx512_obj_func_t obj_func,
+                            size_t swarm_size,
+                            size_t dim,
+                            const float min_position,
+                            const float max_position,
+                            size_t n_threads,
+                            size_t seed) {
+  assert(dim > 0);
+  assert(swarm_size > 0);
+
+  pso512_ctx_t *const ctx = (pso512_ctx_t*)aligned_alloc(sizeof(__m512), sizeof(pso512_ctx_t));
+  if (!ctx) { perror("malloc arr"); exit(EXIT_FAILURE); };
+
+  size_t simd_dim = (dim + 15) / 16;
+
+  if(n_threads == 0) {
+    n_threads = pso_default_num_threads();
+  }
+
+  ctx->obj_func = obj_func;
+  ctx->swarm_size = swarm_size;
+  ctx->dim = dim;
+  ctx->simd_dim = simd_dim;
+  ctx->n_threads = n_threads;
+  ctx->iteration = 0;
+
+  ctx->rngs = (simd512_rng_t*)aligned_alloc(sizeof(simd512_rng_t), n_threads * sizeof(simd512_rng_t));
+  if (!ctx->rngs) { perror("malloc arr"); exit(EXIT_FAILURE); };
+  seed_simd512_rng(ctx->rngs, n_threads, seed);
+
+  ctx->bounds.min_vel = _mm512_set1_ps(min_position / VEL_LIMIT_SCALE);
+  ctx->bounds.max_vel = _mm512_set1_ps(max_position / VEL_LIMIT_SCALE);
+  ctx->bounds.min_pos = _mm512_set1_ps(min_position);
+  ctx->bounds.max_pos = _mm512_set1_ps(max_position);
+
+  size_t sizeof_position = swarm_size * simd_dim * sizeof(__m512);
+  ctx->positions = (__m512*)aligned_alloc(sizeof(__m512), sizeof_position);
+  if (!ctx->positions) { perror("malloc arr"); exit(EXIT_FAILURE); };
+  pso512_rand_init(&ctx->rngs[0], &ctx->bounds, ctx->positions, swarm_size * simd_dim);
+  pso512_clear_tails(ctx->positions, swarm_size, dim);
+  ctx->local_best_positions = (__m512*)aligned_alloc(sizeof(__m512), sizeof_position);
+  if (!ctx->local_best_positions) { perror("malloc arr"); exit(EXIT_FAILURE); };
+  memcpy(ctx->local_best_positions, ctx->positions, sizeof_position);
+  ctx->global_best_position = (__m512*)aligned_alloc(sizeof(__m512), simd_dim * sizeof(__m512));
+  if (!ctx->global_best_position) { perror("malloc arr"); exit(EXIT_FAILURE); };
+
+  size_t sizeof_fitness = swarm_size * sizeof(float);
+  ctx->current_fitness = (float*)malloc(sizeof_fitness);
+  if (!ctx->current_fitness) { perror("malloc arr"); exit(EXIT_FAILURE); };
+  pso512_eval_fitness(obj_func, swarm_size, dim, ctx->positions, ctx->current_fitness);
+
+  ctx->local_best_fitness = (float*)malloc(sizeof_fitness);
+  if (!ctx->local_best_fitness) { perror("malloc arr"); exit(EXIT_FAILURE); };
+  memcpy(ctx->local_best_fitness, ctx->current_fitness, sizeof_fitness);
+
+  // initial velocity is a quarter of the way towards a random position
+  ctx->velocity = (__m512*)aligned_alloc(sizeof(__m512), sizeof_position);
+  if (!ctx->velocity) { perror("malloc arr"); exit(EXIT_FAILURE); };
+  pso512_rand_init(&ctx->rngs[0], &ctx->bounds, ctx->velocity, swarm_size * simd_dim);
+  const __m512 quarter = _mm512_set1_ps(0.25);
+  for(size_t idx = 0; idx < swarm_size * simd_dim; idx++) {
+    ctx->velocity[idx] = _mm512_mul_ps(quarter, _mm512_sub_ps(ctx->velocity[idx], ctx->positions[idx]));
+  }
+  pso512_clear_tails(ctx->velocity, swarm_size, dim);
+
+  ctx->global_best_idx = pso_best_fitness(ctx->local_best_fitness, swarm_size);
+  memcpy(ctx->global_best_position, &ctx->local_best_positions[simd_dim * ctx->global_best_idx],
+         simd_dim * sizeof(__m512));
+
+  ctx->slice_best_idx = filled_size_t_array(n_threads, SIZE_MAX);
+  if (!ctx->slice_best_idx) { perror("malloc arr"); exit(EXIT_FAILURE); };
+
+  return ctx;
+}
+
+void pso512_step(pso512_ctx_t *const ctx, size_t n_iter) {
+  const size_t swarm_size = ctx->swarm_size;
+  const size_t simd_dim = ctx->simd_dim;
+
+  #pragma omp parallel num_threads(ctx->n_threads)
+  {
+#ifdef _OPENMP
+    size_t thread = (size_t)omp_get_thread_num();
+    size_t team_size = (size_t)omp_get_num_threads();
+#else
+    size_t thread = 0;
+    size_t team_size = 1;
+#endif
+    size_t begin = pso512_slice_begin(swarm_size, thread, team_size);
+    size_t count = pso512_slice_begin(swarm_size, thread + 1, team_size) - begin;
+    size_t offset = begin * simd_dim;
+
+    for(size_t iter = 0; iter < n_iter; iter++) {
+      pso512_update_everything(&ctx->velocity[offset], &ctx->positions[offset],
+                               &ctx->local_best_positions[offset], ctx->global_best_position,
+                               &ctx->current_fitness[begin], &ctx->local_best_fitness[begin],
+                               ctx->obj_func, &ctx->bounds, &ctx->rngs[thread], count, ctx->dim);
+
+      if(count > 0) {
+        ctx->slice_best_idx[thread] = begin + pso_best_fitness(&ctx->local_best_fitness[begin], count);
+      }
+
+      #pragma omp barrier
+
+      #pragma omp single
+      {
+        for(size_t candidate = 0; candidate < team_size; candidate++) {
+          size_t idx = ctx->slice_best_idx[candidate];
+          if(idx != SIZE_MAX &&
+             ctx->local_best_fitness[idx] < ctx->local_best_fitness[ctx->global_best_idx]) {
+            ctx->global_best_idx = idx;
+          }
+        }
+        memcpy(ctx->global_best_position,
+               &ctx->local_best_positions[simd_dim * ctx->global_best_idx],
+               simd_dim * sizeof(__m512));
+
+        ctx->iteration++;
+      }
+    }
+  }
+}
+
+float pso512_result(const pso512_ctx_t *const ctx, float *const solution) {
+  const size_t last = ctx->simd_dim - 1;
+  for(size_t idx = 0; idx < last; idx++) {
+    _mm512_storeu_ps(&solution[idx * 16], ctx->global_best_position[idx]);
+  }
+  _mm512_mask_storeu_ps(&solution[last * 16], pso512_tail_mask(ctx->dim), ctx->global_best_position[last]);
+  return ctx->local_best_fitness[ctx->global_best_idx];
+}
+
+void pso512_destroy(pso512_ctx_t *const ctx) {
+  free(ctx->positions);
+  free(ctx->local_best_positions);
+  free(ctx->current_fitness);
+  free(ctx->local_best_fitness);
+  free(ctx->velocity);
+  free(ctx->global_best_position);
+  free(ctx->slice_best_idx);
+  free(ctx->rngs);
+  free(ctx);
+}
+
+float *pso_parallel_avx512(avx512_obj_func_t obj_func,
+                           size_t swarm_size,
+                           size_t dim,
+                           size_t max_iter,
+                           const float min_position,
+                           const float max_position,
+                           size_t n_threads) {
+  pso512_ctx_t *ctx = pso512_create(obj_func, swarm_size, dim, min_position, max_position,
+                                    n_threads, 100);
+
+  pso512_step(ctx, max_iter);
+
+  float *const best_solution = (float *const)malloc(dim * sizeof(float));
+  if (!best_solution) { perror("malloc arr"); exit(EXIT_FAILURE); };
+  pso512_result(ctx, best_solution);
+
+  pso512_destroy(ctx);
+
+  return best_solution;
+}
+
+float *pso_basic_avx512(avx512_obj_func_t obj_func,
+                        size_t swarm_size,
+                        size_t dim,
+                        size_t max_iter,
+                        const float min_position,
+                        const float max_position) {
+  return pso_parallel_avx512(obj_func, swarm_size, dim, max_iter, min_position, max_position, 1);
+}
+
+float *pso_basic_mt_avx512(avx512_obj_func_t obj_func,
+                           size_t swarm_size,
+                           size_t dim,
+                           size_t max_iter,
+                           const float min_position,
+                           const float max_position) {
+  return pso_parallel_avx512(obj_func, swarm_size, dim, max_iter, min_position, max_position, 0);
+}
@@ -0,0 +1,190 @@
+/**
+   PSO update with the objective function inlined: `fused_update` is instantiated once
+   per objective, so the compiler sees the objective terms next to the position update.
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "pso.h"
+#include "pso_fused.h"
+#include "pso_kernels.h"
+#include "objectives.h"
+#include "utils.h"
+
+
+namespace {
+
+/**
+   Sum of squares, one term per dimension.
+ */
+struct SumOfSquares {
+  static size_t n_terms(size_t dim) { return dim; }
+
+  static inline __m256 terms(const __m256 cur, const __m256 /* next */) {
+    return _mm256_mul_ps(cur, cur);
+  }
+};
+
+/**
+   Rosenbrock, the terms of a vector need the first lane of the next one.
+ */
+struct Rosenbrock {
+  static size_t n_terms(size_t dim) { return dim - 1; }
+
+  static inline __m256 terms(const __m256 cur, const __m256 next) {
+    const __m256 ones = _mm256_set1_ps(1.0);
+    const __m256 cent = _mm256_set1_ps(100.0);
+    const __m256i rotate = _mm256_setr_epi32(1, 2, 3, 4, 5, 6, 7, 0);
+    __m256 shift1 = _mm256_blend_ps(_mm256_permutevar8x32_ps(cur, rotate),
+                                    _mm256_permutevar8x32_ps(next, rotate), 0x80);
+    __m256 r1 = _mm256_fmsub_ps(cur, cur, shift1);
+    r1 = _mm256_mul_ps(r1, r1);
+    __m256 temp = _mm256_sub_ps(ones, cur);
+    return _mm256_fmadd_ps(cent, r1, _mm256_mul_ps(temp, temp));
+  }
+};
+
+/**
+   Move the particles `begin` to `begin + count` of `ctx` like `pso_move_vectors` and add
+   up the `Objective` terms of every vector as soon as the next vector has moved. The
+   positions are bit for bit the ones of `update_everything`. A non-zero `SimdDim` fixes
+   the number of vectors per particle at compile time, so the loop over them unrolls.
+ */
+template <typename Objective, size_t SimdDim>
+void fused_update(pso_ctx *const ctx, size_t begin, size_t count, simd_rng_t *const rng) {
+  const size_t simd_dim = SimdDim ? SimdDim : ctx->simd_dim;
+  const size_t dim = SimdDim ? 8 * SimdDim : ctx->dim;
+  const size_t n_terms = Objective::n_terms(dim);
+  const size_t term_vecs = (n_terms + 7) / 8;
+  const __m256 tail = _mm256_castsi256_ps(simd_tail_mask(dim));
+  const __m256 term_tail = _mm256_castsi256_ps(simd_tail_mask(n_terms));
+  const pso_bounds_t bounds = ctx->bounds;
+  const __m256 *const global_best_position = ctx->global_best_position;
+
+  // terms of vector `idx` of the particle, the padding lanes have no terms
+  auto add_terms = [&](__m256 fitness, size_t idx, const __m256 cur, const __m256 next) {
+    if(idx >= term_vecs) {
+      return fitness;
+    }
+    __m256 terms = Objective::terms(cur, next);
+    if(idx + 1 == term_vecs) {
+      terms = _mm256_and_ps(terms, term_tail);
+    }
+    return _mm256_add_ps(fitness, terms);
+  };
+
+  // local copies of the chains stay in registers, the stores to the swarm could alias them
+  __m256i chain1 = rng->state[0];
+  __m256i chain2 = rng->state[1];
+
+  for(size_t particle = begin; particle < begin + count; particle++) {
+    __m256 *const velocity = &ctx->velocity[particle * simd_dim];
+    __m256 *const positions = &ctx->positions[particle * simd_dim];
+    __m256 *const local_best = &ctx->local_best_positions[particle * simd_dim];
+
+    // new velocity and position of vector `dimension`, returns the position
+    auto move = [&](size_t dimension, bool last) {
+      __m256 pos = positions[dimension];
+      __m256 rand1 = simd_xorshift_0_to_1(&chain1);
+      __m256 rand2 = simd_xorshift_0_to_1(&chain2);
+      __m256 vel = pso_new_velocity(velocity[dimension], pos, local_best[dimension],
+                                    global_best_position[dimension], &bounds, rand1, rand2);
+
+      pos = _mm256_add_ps(pos, vel);
+      pos = _mm256_min_ps(_mm256_max_ps(bounds.min_pos, pos), bounds.max_pos);
+      if(last) {
+        vel = _mm256_and_ps(vel, tail);
+        pos = _mm256_and_ps(pos, tail);
+      }
+      velocity[dimension] = vel;
+      positions[dimension] = pos;
+      return pos;
+    };
+
+    // all but the last two vectors have a full vector of terms, two accumulators
+    // take turns so consecutive additions do not wait on each other
+    __m256 fitness[2] = {_mm256_setzero_ps(), _mm256_setzero_ps()};
+    __m256 prev = move(0, simd_dim == 1);
+    for(size_t dimension = 1; dimension + 1 < simd_dim; dimension++) {
+      __m256 pos = move(dimension, false);
+      fitness[dimension & 1] = _mm256_add_ps(fitness[dimension & 1], Objective::terms(prev, pos));
+      prev = pos;
+    }
+    if(simd_dim > 1) {
+      __m256 last = move(simd_dim - 1, true);
+      fitness[0] = add_terms(fitness[0], simd_dim - 2, prev, last);
+      prev = last;
+    }
+    fitness[1] = add_terms(fitness[1], simd_dim - 1, prev, _mm256_setzero_ps());
+    ctx->current_fitness[particle] = horizontal_add(_mm256_add_ps(fitness[0], fitness[1]));
+
+    if(ctx->current_fitness[particle] < ctx->local_best_fitness[particle]) {
+      ctx->local_best_fitness[particle] = ctx->current_fitness[particle];
+      memcpy(local_best, positions, simd_dim * sizeof(__m256));
+    }
+  }
+
+  rng->state[0] = chain1;
+  rng->state[1] = chain2;
+}
+
+/**
+   `fused_update` of `Objective` with the number of vectors fixed for `dim`, or the
+   generic one if `dim` is not one of the fixed dimensions.
+ */
+template <typename Objective>
+pso_update_func_t fused_update_for(size_t dim) {
+  switch (dim) {
+    case 8:   return &fused_update<Objective, 1>;
+    case 16:  return &fused_update<Objective, 2>;
+    case 32:  return &fused_update<Objective, 4>;
+    case 64:  return &fused_update<Objective, 8>;
+    case 128: return &fused_update<Objective, 16>;
+    default:  return &fused_update<Objective, 0>;
+  }
+}
+
+} // namespace
+
+
+pso_update_func_t pso_fused_update(simd_obj_func_t obj_func) {
+  if (obj_func == opt_simd_sum_of_squares) {
+    return &fused_update<SumOfSquares, 0>;
+  }
+  if (obj_func == opt_simd_rosenbrock) {
+    return &fused_update<Rosenbrock, 0>;
+  }
+  return nullptr;
+}
+
+pso_update_func_t pso_fused_update_dim(simd_obj_func_t obj_func, size_t dim) {
+  if (obj_func == opt_simd_sum_of_squares) {
+    return fused_update_for<SumOfSquares>(dim);
+  }
+  if (obj_func == opt_simd_rosenbrock) {
+    return fused_update_for<Rosenbrock>(dim);
+  }
+  return nullptr;
+}
+
+float *pso_basic_fused(simd_obj_func_t obj_func,
+                       size_t swarm_size,
+                       size_t dim,
+                       size_t max_iter,
+                       const float min_position,
+                       const float max_position) {
+  pso_ctx_t *ctx = pso_create(obj_func, swarm_size, dim, min_position, max_position, 1, 100);
+  pso_use_update(ctx, pso_fused_update_dim(obj_func, dim));
+
+  pso_step(ctx, max_iter);
+
+  float *const best_solution = (float *)malloc(dim * sizeof(float));
+  if (!best_solution) { perror("malloc arr"); exit(EXIT_FAILURE); };
+  pso_result(ctx, best_solution);
+
+  pso_destroy(ctx);
+
+  return best_solution;
+}
@@ -0,0 +1,222 @@
+/**
+   Portable parts of the PSO: the helpers shared by all engines and a scalar engine
+   for CPUs without AVX2. Nothing in this file may be compiled with ISA flags.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "pso.h"
+#include "pso_scalar.h"
+#include "utils.h"
+
+#define min(a, b) (((a) < (b)) ? (a) : (b))
+#define max(a, b) (((a) > (b)) ? (a) : (b))
+
+
+/**
+   Returns the index of the particle with lowest fitness.
+
+   Arguments:
+     fitness     array containing the fitness values for all particles
+     swarm_size  number of particles in fitness array
+
+   Returns:
+     A `size_t` representing the index.
+ */
+size_t pso_best_fitness(float *fitness, size_t swarm_size) {
+  size_t min_idx = 0;
+  float min = fitness[0];
+  for(size_t particle = 1; particle < swarm_size; particle++) {
+    if(fitness[particle] < min) {
+      min = fitness[particle];
+      min_idx = particle;
+    }
+  }
+  return min_idx;
+}
+
+/**
+   Returns the number of threads `pso_parallel` uses when asked for 0 threads.
+ */
+size_t pso_default_num_threads() {
+  return default_num_threads();
+}
+
+
+/**
+   State of one scalar xorshift RNG stream, one per thread on its own cache line.
+ */
+typedef struct {
+  uint64_t state;
+} __attribute__((aligned(64))) scalar_rng_t;
+
+/**
+   Generate a random float between 0 and 1.
+ */
+static inline float scalar_rand_0_to_1(scalar_rng_t *const rng) {
+  uint64_t x = rng->state;
+  x ^= x << 13;
+  x ^= x >> 7;
+  x ^= x << 17;
+  rng->state = x;
+  return (float)(x >> 40) * (1.0f / 16777216.0f);
+}
+
+/**
+   Update the velocity, position, fitness and local best of `swarm_size` particles
+   of `dim` floats each.
+ */
+static void scalar_update_everything(float *const velocity, float *const positions,
+                                     float *const local_best_positions,
+                                     const float *const global_best_position,
+                                     float *const current_fitness, float *const local_best_fitness,
+                                     obj_func_t obj_func, scalar_rng_t *const rng,
+                                     size_t swarm_size, size_t dim,
+                                     float min_vel, float max_vel,
+                                     float min_position, float max_position) {
+  for(size_t particle = 0; particle < swarm_size; particle++) {
+    for(size_t dimension = 0; dimension < dim; dimension++) {
+      size_t idx = (particle * dim) + dimension;
+      float rand1 = scalar_rand_0_to_1(rng);
+      float rand2 = scalar_rand_0_to_1(rng);
+      float vel = INERTIA * velocity[idx]
+                  + COG * rand1 * (local_best_positions[idx] - positions[idx])
+                  + SOCIAL * rand2 * (global_best_position[dimension] - positions[idx]);
+      vel = min(max(vel, min_vel), max_vel);
+      velocity[idx] = vel;
+      positions[idx] = min(max(positions[idx] + vel, min_position), max_position);
+    }
+
+    current_fitness[particle] = obj_func(&positions[particle * dim], dim);
+
+    if(current_fitness[particle] < local_best_fitness[particle]) {
+      local_best_fitness[particle] = current_fitness[particle];
+      memcpy(&local_best_positions[particle * dim], &positions[particle * dim],
+             dim * sizeof(float));
+    }
+  }
+}
+
+float *pso_parallel_scalar(obj_func_t obj_func,
+                           size_t swarm_size,
+                           size_t dim,
+                           size_t max_iter,
+                           const float min_position,
+                           const float max_position,
+                           size_t n_threads) {
+  if(n_threads == 0) {
+    n_threads = pso_default_num_threads();
+  }
+  const float min_vel = min_position / VEL_LIMIT_SCALE;
+  const float max_vel = max_position / VEL_LIMIT_SCALE;
+
+  scalar_rng_t *const rngs = (scalar_rng_t*)aligned_alloc(sizeof(scalar_rng_t),
+                                                           n_threads * sizeof(scalar_rng_t));
+  if (!rngs) { perror("malloc arr"); exit(EXIT_FAILURE); };
+  for(size_t thread = 0; thread < n_threads; thread++) {
+    // xorshift must not start from 0
+    rngs[thread].state = 0x9E3779B97F4A7C15ULL * (100 + thread + 1);
+  }
+
+  size_t sizeof_position = swarm_size * dim * sizeof(float);
+  float *const positions = (float*)malloc(sizeof_position);
+  float *const velocity = (float*)malloc(sizeof_position);
+  float *const local_best_positions = (float*)malloc(sizeof_position);
+  float *const global_best_position = (float*)malloc(dim * sizeof(float));
+  float *const current_fitness = (float*)malloc(swarm_size * sizeof(float));
+  float *const local_best_fitness = (float*)malloc(swarm_size * sizeof(float));
+  size_t *const slice_best_idx = filled_size_t_array(n_threads, SIZE_MAX);
+  if (!positions || !velocity || !local_best_positions || !global_best_position ||
+      !current_fitness || !local_best_fitness || !slice_best_idx) {
+    perror("malloc arr"); exit(EXIT_FAILURE);
+  };
+
+  // initial velocity is a quarter of the way towards a random position
+  for(size_t idx = 0; idx < swarm_size * dim; idx++) {
+    positions[idx] = min_position + scalar_rand_0_to_1(&rngs[0]) * (max_position - min_position);
+    float target = min_position + scalar_rand_0_to_1(&rngs[0]) * (max_position - min_position);
+    velocity[idx] = 0.25f * (target - positions[idx]);
+  }
+  memcpy(local_best_positions, positions, sizeof_position);
+  for(size_t particle = 0; particle < swarm_size; particle++) {
+    current_fitness[particle] = obj_func(&positions[particle * dim], dim);
+  }
+  memcpy(local_best_fitness, current_fitness, swarm_size * sizeof(float));
+
+  size_t global_best_idx = pso_best_fitness(local_best_fitness, swarm_size);
+  memcpy(global_best_position, &local_best_positions[dim * global_best_idx], dim * sizeof(float));
+
+  #pragma omp parallel num_threads(n_threads)
+  {
+#ifdef _OPENMP
+    size_t thread = (size_t)omp_get_thread_num();
+    size_t team_size = (size_t)omp_get_num_threads();
+#else
+    size_t thread = 0;
+    size_t team_size = 1;
+#endif
+    size_t begin = swarm_size * thread / team_size;
+    size_t count = swarm_size * (thread + 1) / team_size - begin;
+
+    for(size_t iter = 0; iter < max_iter; iter++) {
+      scalar_update_everything(&velocity[begin * dim], &positions[begin * dim],
+                               &local_best_positions[begin * dim], global_best_position,
+                               &current_fitness[begin], &local_best_fitness[begin],
+                               obj_func, &rngs[thread], count, dim,
+                               min_vel, max_vel, min_position, max_position);
+
+      if(count > 0) {
+        slice_best_idx[thread] = begin + pso_best_fitness(&local_best_fitness[begin], count);
+      }
+
+      #pragma omp barrier
+
+      #pragma omp single
+      {
+        for(size_t candidate = 0; candidate < team_size; candidate++) {
+          size_t idx = slice_best_idx[candidate];
+          if(idx != SIZE_MAX && local_best_fitness[idx] < local_best_fitness[global_best_idx]) {
+            global_best_idx = idx;
+          }
+        }
+        memcpy(global_best_position, &local_best_positions[dim * global_best_idx],
+               dim * sizeof(float));
+      }
+    }
+  }
+
+  free(positions);
+  free(velocity);
+  free(local_best_positions);
+  free(current_fitness);
+  free(local_best_fitness);
+  free(slice_best_idx);
+  free(rngs);
+
+  return global_best_position;
+}
+
+float *pso_basic_scalar(obj_func_t obj_func,
+                        size_t swarm_size,
+                        size_t dim,
+                        size_t max_iter,
+                        const float min_position,
+                        const float max_position) {
+  return pso_parallel_scalar(obj_func, swarm_size, dim, max_iter, min_position, max_position, 1);
+}
+
+float *pso_basic_mt_scalar(obj_func_t obj_func,
+                           size_t swarm_size,
+                           size_t dim,
+                           size_t max_iter,
+                           const float min_position,
+                           const float max_position) {
+  return pso_parallel_scalar(obj_func, swarm_size, dim, max_iter, min_position, max_position, 0);
+}
@@ -0,0 +1,137 @@
+/**
+   Random number generator shared by the scalar algorithms, see `rng_t`. The AVX2
+   rounds live in rng_avx2.c and are picked at runtime.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "dispatch.h"
+#include "rng.h"
+
+#ifndef M_PI
+#define M_PI (3.14159265358979323846)
+#endif
+
+
+void rng_seed(rng_t *const rng, uint64_t seed) {
+  for(size_t idx = 0; idx < RNG_STATE_WORDS; idx++) {
+    rng->state[idx] = splitmix64(&seed);
+  }
+  rng->next = RNG_ROUND;
+}
+
+rng_stream_t *rng_alloc_streams(size_t n, uint64_t seed) {
+  // the size of the padded type is a multiple of the alignment, as aligned_alloc requires
+  rng_stream_t *const streams = (rng_stream_t*)aligned_alloc(RNG_CACHE_LINE,
+                                                             n * sizeof(rng_stream_t));
+  if(!streams) { perror("malloc arr"); exit(EXIT_FAILURE); };
+  for(size_t idx = 0; idx < n; idx++) {
+    rng_seed(&streams[idx].rng, seed + idx);
+  }
+  return streams;
+}
+
+void rng_fill_rounds_scalar(uint64_t state[RNG_STATE_WORDS], float *const out, size_t n_rounds,
+                            float min, float max) {
+  const float range = max - min;
+  for(size_t round = 0; round < n_rounds; round++) {
+    for(size_t word = 0; word < RNG_STATE_WORDS; word++) {
+      // same step as simd_xorshift_0_to_1 of the PSO engines
+      const uint64_t s0 = state[word];
+      const uint64_t s1 = s0 ^ (s0 << 23);
+      state[word] = s1 ^ s0 ^ (s1 >> 18) ^ (s0 >> 5);
+      const uint64_t bits = state[word] + s0;
+
+      // top 24 bits of each 32 bit half, lower half first
+      float *const dest = &out[round * RNG_ROUND + 2 * word];
+      dest[0] = min + (float)((uint32_t)bits >> 8) * (1.0f / 16777216.0f) * range;
+      dest[1] = min + (float)((uint32_t)(bits >> 32) >> 8) * (1.0f / 16777216.0f) * range;
+    }
+  }
+}
+
+/**
+   Generate `n_rounds` rounds with the widest implementation the binary runs with.
+ */
+static void rng_fill_rounds(uint64_t state[RNG_STATE_WORDS], float *const out, size_t n_rounds,
+                            float min, float max) {
+  if(n_rounds == 0) {
+    return;
+  }
+  if(active_isa() >= ISA_AVX2) {
+    rng_fill_rounds_avx2(state, out, n_rounds, min, max);
+  } else {
+    rng_fill_rounds_scalar(state, out, n_rounds, min, max);
+  }
+}
+
+void rng_uniform(rng_t *const rng, float *const out, size_t n, float min, float max) {
+  const float range = max - min;
+  size_t idx = 0;
+
+  // the rest of the buffer comes first, so fills and single draws share one stream
+  for(; idx < n && rng->next < RNG_ROUND; idx++) {
+    out[idx] = min + rng->buffer[rng->next++] * range;
+  }
+
+  const size_t n_rounds = (n - idx) / RNG_ROUND;
+  rng_fill_rounds(rng->state, &out[idx], n_rounds, min, max);
+  idx += n_rounds * RNG_ROUND;
+
+  if(idx < n) {
+    rng_fill_rounds(rng->state, rng->buffer, 1, 0.0f, 1.0f);
+    rng->next = 0;
+    for(; idx < n; idx++) {
+      out[idx] = min + rng->buffer[rng->next++] * range;
+    }
+  }
+}
+
+float rng_0_to_1(rng_t *const rng) {
+  if(rng->next == RNG_ROUND) {
+    rng_fill_rounds(rng->state, rng->buffer, 1, 0.0f, 1.0f);
+    rng->next = 0;
+  }
+  return rng->buffer[rng->next++];
+}
+
+float rng_min_max(rng_t *const rng, float min, float max) {
+  return min + rng_0_to_1(rng) * (max - min);
+}
+
+void rng_normal(rng_t *const rng, float *const out, size_t n, float mean, float stddev) {
+  rng_uniform(rng, out, n, 0.0f, 1.0f);
+
+  for(size_t idx = 0; idx < n; idx += 2) {
+    // 1 - u is in (0, 1], the logarithm stays finite
+    const float radius = stddev * sqrtf(-2.0f * logf(1.0f - out[idx]));
+    const float angle = (float)(2.0 * M_PI) * (idx + 1 < n ? out[idx + 1] : rng_0_to_1(rng));
+    out[idx] = mean + radius * cosf(angle);
+    if(idx + 1 < n) {
+      out[idx + 1] = mean + radius * sinf(angle);
+    }
+  }
+}
+
+float rng_levy_sigma(float beta) {
+  const double num = tgamma(1.0 + beta) * sin(M_PI * beta / 2.0);
+  const double den = tgamma((1.0 + beta) / 2.0) * beta * pow(2.0, (beta - 1.0) / 2.0);
+  return (float)pow(num / den, 1.0 / beta);
+}
+
+void rng_levy(rng_t *const rng, float *const out, size_t n, float beta) {
+  const float sigma_u = rng_levy_sigma(beta);
+  const float inv_beta = 1.0f / beta;
+
+  float v[2 * RNG_ROUND];
+  for(size_t begin = 0; begin < n; begin += 2 * RNG_ROUND) {
+    const size_t len = n - begin < 2 * RNG_ROUND ? n - begin : 2 * RNG_ROUND;
+    rng_normal(rng, &out[begin], len, 0.0f, sigma_u);
+    rng_normal(rng, v, len, 0.0f, 1.0f);
+    for(size_t idx = 0; idx < len; idx++) {
+      out[begin + idx] /= powf(fabsf(v[idx]), inv_beta);
+    }
+  }
+}
@@ -0,0 +1,39 @@
+#include <immintrin.h>
+
+#include "rng.h"
+
+
+/**
+   Four independent chains are kept in registers and stepped in turn, so each round is
+   four dependency chains the CPU overlaps.
+ */
+void rng_fill_rounds_avx2(uint64_t state[RNG_STATE_WORDS], float *const out, size_t n_rounds,
+                          float min, float max) {
+  const __m256 scale = _mm256_set1_ps(1.0f / 16777216.0f);
+  const __m256 v_min = _mm256_set1_ps(min);
+  const __m256 range = _mm256_set1_ps(max - min);
+
+  __m256i chains[4];
+  for(size_t chain = 0; chain < 4; chain++) {
+    chains[chain] = _mm256_loadu_si256((const __m256i*)&state[4 * chain]);
+  }
+
+  for(size_t round = 0; round < n_rounds; round++) {
+    for(size_t chain = 0; chain < 4; chain++) {
+      const __m256i s0 = chains[chain];
+      const __m256i s1 = _mm256_xor_si256(s0, _mm256_slli_epi64(s0, 23));
+      const __m256i lhs = _mm256_xor_si256(_mm256_xor_si256(s1, s0), _mm256_srli_epi64(s1, 18));
+      chains[chain] = _mm256_xor_si256(lhs, _mm256_srli_epi64(s0, 5));
+      const __m256i bits = _mm256_add_epi64(chains[chain], s0);
+
+      // top 24 bits of every 32 bit lane, mul and add like the scalar path for equal bits
+      __m256 rands = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_srli_epi32(bits, 8)), scale);
+      rands = _mm256_add_ps(v_min, _mm256_mul_ps(rands, range));
+      _mm256_storeu_ps(&out[round * RNG_ROUND + 8 * chain], rands);
+    }
+  }
+
+  for(size_t chain = 0; chain < 4; chain++) {
+    _mm256_storeu_si256((__m256i*)&state[4 * chain], chains[chain]);
+  }
+}
@@ -0,0 +1,28 @@
+#include <cstdlib>
+#include <iostream>
+
+#include "microbench.h"
+
+
+int main(int argc, char *argv[]) {
+
+  auto bench_map = create_microbench_map();
+
+  if (argc < 2 || bench_map.find(argv[1]) == bench_map.end()) {
+    std::cerr << "Usage: " << argv[0] << " <micro benchmark> [repetitions]\n\nMicro benchmarks:\n";
+    for (const auto &bench : bench_map) {
+      std::cerr << "  " << bench.first << "\n";
+    }
+    return EXIT_FAILURE;
+  }
+
+  int n_repetitions = argc > 2 ? std::atoi(argv[2]) : 3;
+  if (n_repetitions < 1) {
+    std::cerr << "The number of repetitions must be positive." << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  bench_map[argv[1]](std::cout, n_repetitions);
+
+  return 0;
+}
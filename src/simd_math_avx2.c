@@ -0,0 +1,41 @@
+#include <immintrin.h>
+
+#include "simd_math.h"
+#include "utils.h"
+
+
+/**
+   Apply `kernel` to the whole vectors of `x` and to the masked last one.
+ */
+#define SIMD_MATH_ARRAY(kernel)                                         \
+  size_t idx = 0;                                                       \
+  for(; idx + 8 <= n; idx += 8) {                                       \
+    _mm256_storeu_ps(&out[idx], kernel(_mm256_loadu_ps(&x[idx])));      \
+  }                                                                     \
+  if(idx < n) {                                                         \
+    const __m256i tail = simd_tail_mask(n);                             \
+    _mm256_maskstore_ps(&out[idx], tail, kernel(_mm256_maskload_ps(&x[idx], tail))); \
+  }
+
+void simd_sin_array(const float *const x, float *const out, size_t n) {
+  SIMD_MATH_ARRAY(simd_sin)
+}
+
+void simd_cos_array(const float *const x, float *const out, size_t n) {
+  SIMD_MATH_ARRAY(simd_cos)
+}
+
+void simd_exp_array(const float *const x, float *const out, size_t n) {
+  SIMD_MATH_ARRAY(simd_exp)
+}
+
+void simd_log_array(const float *const x, float *const out, size_t n) {
+  SIMD_MATH_ARRAY(simd_log)
+}
+
+void simd_pow_array(const float *const x, float y, float *const out, size_t n) {
+  const __m256 v_y = _mm256_set1_ps(y);
+#define SIMD_POW_Y(v) simd_pow(v, v_y)
+  SIMD_MATH_ARRAY(SIMD_POW_Y)
+#undef SIMD_POW_Y
+}
@@ -6,20 +6,11 @@
 #include <time.h>
 #include <float.h>
 
+#include "objectives.h"
+#include "rng.h"
 #include "squirrel.h"
 #include "utils.h"
 
-#define NUM_JUMP_HICK 0.2
-#define T_MAX 100
-#define PREDATOR_PROB 0.1
-#define BETA 1.5
-#define GLIDING_CONST 1.9
-#define CD 0.60
-#define CL_MIN 0.675
-#define CL_MAX 1.5
-#define SF 18
-#define DROP 8
-
 #ifndef M_PI
 #define M_PI (3.14159265358979323846)
 #endif
@@ -32,25 +23,21 @@
 #define max(a, b) (((a) > (b)) ? (a) : (b))
 
 
-void sqr_rand_init(float* const positions,
+void sqr_rand_init(rng_t* const rng,
+                      float* const positions,
                       size_t pop_size,
                       size_t dim,
                       const float min_position,
                       const float max_position) {
-  for (size_t particle=0; particle < pop_size; particle++){
-    for (size_t d=0; d<dim; d++){
-      size_t idx = (particle*dim) + d;
-      positions[idx] = random_min_max(min_position,max_position);
-    }
-  }
+  rng_uniform(rng, positions, pop_size*dim, min_position, max_position);
 }
 
 
-int sqr_bernoulli_distribution(float probability){
+int sqr_bernoulli_distribution(rng_t* const rng, float probability){
   if (probability < 0 || probability > 1)
     return -1;
 
-  if (random_0_to_1() < probability )
+  if (rng_0_to_1(rng) < probability )
     return 1;
   return 0;
 }
@@ -59,9 +46,7 @@ void sqr_eval_fitness(obj_func_t obj_func,
                       size_t pop_size, size_t dim,
                       const float* const positions,
                       float* fitness) {
-  for (size_t pop=0; pop<pop_size; pop++){
-    fitness[pop] = obj_func(positions+(pop*dim),dim);
-  }
+  obj_eval_batch(obj_func, positions, pop_size, dim, fitness);
 }
 
 
@@ -101,58 +86,62 @@ void sqr_lowest4_vals_to_front(float* fitness,float* positions, size_t pop_size,
   }
 }
 
-float sqr_gliding_dist(){
-  float lift = random_min_max(CL_MIN,CL_MAX);
+float sqr_gliding_dist(rng_t* const rng){
+  float lift = rng_min_max(rng,CL_MIN,CL_MAX);
   float drag = CD;
   return DROP/(SF*drag/lift);
 }
 
-void sqr_move_to_hickory(float* positions,
+void sqr_move_to_hickory(rng_t* const rng,
+                    float* positions,
                     size_t pop_size,
                     size_t dim,
                     const float min_position,
                     const float max_position){
   float p = PREDATOR_PROB;
-  if (!sqr_bernoulli_distribution(p)){
+  if (!sqr_bernoulli_distribution(rng,p)){
+    // lift coefficients of a whole squirrel in one bulk fill
+    float lift[dim];
     for (size_t pop_idx = 1; pop_idx < 4+NUM_JUMP_HICK*pop_size ; pop_idx ++){
+      rng_uniform(rng, lift, dim, CL_MIN, CL_MAX);
       for (size_t d = 0; d < dim; d++){
         size_t idx = pop_idx*dim + d;
+        float gliding_dist = DROP/(SF*CD/lift[d]);
         positions[idx] = positions[idx] +
-                        sqr_gliding_dist()*GLIDING_CONST*(positions[d]-positions[idx]);
+                        gliding_dist*GLIDING_CONST*(positions[d]-positions[idx]);
       }
     }
   } else {
     for (size_t pop_idx = 1; pop_idx < 4+NUM_JUMP_HICK*pop_size ; pop_idx ++){
-      for (size_t d = 0; d < dim; d++){
-        size_t idx = pop_idx*dim + d;
-        positions[idx] = random_min_max(min_position,max_position);
-      }
+      rng_uniform(rng, positions+(pop_idx*dim), dim, min_position, max_position);
     }
   }
   return;
 }
 
-void sqr_move_normal_to_acorn(float* positions,
+void sqr_move_normal_to_acorn(rng_t* const rng,
+                          float* positions,
                           size_t pop_size,
                           size_t dim,
                           const float min_position,
                           const float max_position){
   float p = PREDATOR_PROB;
-  if (!sqr_bernoulli_distribution(p)){
+  if (!sqr_bernoulli_distribution(rng,p)){
+    // lift coefficients of a whole squirrel in one bulk fill
+    float lift[dim];
     for (size_t pop_idx = 4+NUM_JUMP_HICK*pop_size; pop_idx < pop_size; pop_idx ++){
+      rng_uniform(rng, lift, dim, CL_MIN, CL_MAX);
       for (size_t d = 0; d < dim; d++){
         size_t idx = pop_idx*dim + d;
         size_t acorn_idx = ( 1 + ( idx % 3))*dim + d;
+        float gliding_dist = DROP/(SF*CD/lift[d]);
         positions[idx] = positions[idx] +
-                        sqr_gliding_dist()*GLIDING_CONST*(positions[acorn_idx]-positions[idx]);
+                        gliding_dist*GLIDING_CONST*(positions[acorn_idx]-positions[idx]);
       }
     }
   } else {
     for (size_t pop_idx = 4+NUM_JUMP_HICK*pop_size; pop_idx < pop_size; pop_idx ++){
-      for (size_t d = 0; d < dim; d++){
-        size_t idx = pop_idx*dim + d;
-        positions[idx] = random_min_max(min_position,max_position);
-      }
+      rng_uniform(rng, positions+(pop_idx*dim), dim, min_position, max_position);
     }
   }
   return;
@@ -189,19 +178,20 @@ float sqr_eval_gamma(float x){
   }
 }
 
-float sqr_levy_flight(){
-  float sigma = pow( ( ( sqr_eval_gamma( 1+BETA)*sin( 0.5*M_PI*BETA))/
-                 ( sqr_eval_gamma( 0.5*( 1+BETA))*BETA*pow( 2,( 0.5*( BETA-1))))),( 1/BETA));
-
-  return 0.01*random_0_to_1()*sigma/pow( random_0_to_1(),( 1/BETA) );
+float sqr_levy_flight(rng_t* const rng){
+  float step;
+  rng_levy(rng, &step, 1, BETA);
+  return 0.01*fabs(step);
 }
 
-void random_restart(float* positions,size_t pop_size, size_t dim, const float min_position, const float max_position){
+void random_restart(rng_t* const rng, float* positions,size_t pop_size, size_t dim, const float min_position, const float max_position){
   float range = max_position - min_position;
   for (size_t pop_idx = 4+NUM_JUMP_HICK*pop_size; pop_idx < pop_size; pop_idx ++){
+    // levy steps of a whole squirrel in one bulk fill, same as sqr_levy_flight
+    float* const row = positions+(pop_idx*dim);
+    rng_levy(rng, row, dim, BETA);
     for (size_t d = 0; d < dim; d++){
-      size_t idx = pop_idx*dim + d;
-      positions[idx] =  min_position + sqr_levy_flight()*(range);
+      row[d] =  min_position + 0.01*fabs(row[d])*(range);
     }
   }
   return;
@@ -214,7 +204,8 @@ float* squirrel (obj_func_t obj_func,
                   size_t max_iter,
                   const float min_position,
                   const float max_position) {
-  srand(100);
+  rng_t rng;
+  rng_seed(&rng, 100);
 
   // float p_dp = PREDATOR_PROB;
   // size_t num_jump_hick = ceil(NUM_JUMP_HICK*pop_size);
@@ -222,7 +213,7 @@ float* squirrel (obj_func_t obj_func,
   size_t sizeof_position = pop_size*dim*sizeof(float);
   float* positions = (float*)malloc(sizeof_position);
   if (!positions) { perror("malloc arr"); exit(EXIT_FAILURE); };
-  sqr_rand_init(positions,pop_size,dim,min_position,max_position);
+  sqr_rand_init(&rng,positions,pop_size,dim,min_position,max_position);
 
   size_t sizeof_fitness = pop_size*sizeof(float);
   float* fitness = (float*)malloc(sizeof_fitness);
@@ -244,12 +235,12 @@ float* squirrel (obj_func_t obj_func,
   while (iter < max_iter) {
     iter++;
 
-    sqr_move_to_hickory(positions,pop_size,dim,min_position,max_position);
-    sqr_move_normal_to_acorn(positions,pop_size,dim,min_position,max_position);
+    sqr_move_to_hickory(&rng,positions,pop_size,dim,min_position,max_position);
+    sqr_move_normal_to_acorn(&rng,positions,pop_size,dim,min_position,max_position);
 
     s_c = sqr_eval_seasonal_cons(positions, dim);
     if (s_c < s_min){
-      random_restart(positions,pop_size,dim,min_position,max_position);
+      random_restart(&rng,positions,pop_size,dim,min_position,max_position);
     }
     s_min = sqr_eval_smin(iter);
 
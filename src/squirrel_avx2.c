@@ -0,0 +1,273 @@
+/**
+   Squirrel search on AVX2, 8 dimensions of a squirrel at a time and the squirrels of every
+   group split across threads.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <string.h>
+#include <immintrin.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "rng.h"
+#include "simd_math.h"
+#include "squirrel.h"
+#include "utils.h"
+
+#ifndef M_PI
+#define M_PI (3.14159265358979323846)
+#endif
+
+// gliding distance times the gliding constant per unit of lift, DROP / (SF * CD / lift)
+#define SQR_GLIDE_PER_LIFT (DROP * GLIDING_CONST / (SF * CD))
+
+
+void sqr_simd_levy_steps(float *const steps, const float *const uniforms, size_t n_vectors,
+                         float sigma_u, float inv_beta) {
+  const __m256 ones = _mm256_set1_ps(1.0);
+  const __m256 minus_two = _mm256_set1_ps(-2.0);
+  const __m256 two_pi = _mm256_set1_ps(2.0 * M_PI);
+  const __m256 v_sigma_u = _mm256_set1_ps(sigma_u);
+  const __m256 v_inv_beta = _mm256_set1_ps(inv_beta);
+  const __m256 sign_mask = _mm256_set1_ps(-0.0);
+  for (size_t idx = 0; idx < n_vectors; idx++) {
+    const __m256 u1 = _mm256_loadu_ps(&uniforms[16 * idx]);
+    const __m256 u2 = _mm256_loadu_ps(&uniforms[16 * idx + 8]);
+    // Box-Muller gives two independent normals, the numerator u and the denominator v
+    // of Mantegna's step; 1 - u1 is in (0, 1], the logarithm stays finite
+    const __m256 radius = _mm256_sqrt_ps(_mm256_mul_ps(minus_two,
+                                                       simd_log(_mm256_sub_ps(ones, u1))));
+    __m256 sin_angle, cos_angle;
+    simd_sincos(_mm256_mul_ps(two_pi, u2), &sin_angle, &cos_angle);
+    const __m256 u = _mm256_andnot_ps(sign_mask, _mm256_mul_ps(radius, cos_angle));
+    const __m256 v = _mm256_andnot_ps(sign_mask, _mm256_mul_ps(radius, sin_angle));
+    const __m256 step = _mm256_div_ps(_mm256_mul_ps(v_sigma_u, u), simd_pow(v, v_inv_beta));
+    _mm256_storeu_ps(&steps[8 * idx], step);
+  }
+}
+
+/**
+   Glide `squirrel` towards `target`, the lift coefficients of its dimensions are drawn in
+   `glides` already scaled to the step `SQR_GLIDE_PER_LIFT * lift`.
+ */
+static inline void sqr_simd_glide(__m256 *const squirrel, const __m256 *const target,
+                                  const float *const glides, size_t simd_dim) {
+  for (size_t idx = 0; idx < simd_dim; idx++) {
+    const __m256 glide = _mm256_loadu_ps(&glides[8 * idx]);
+    squirrel[idx] = _mm256_fmadd_ps(glide, _mm256_sub_ps(target[idx], squirrel[idx]),
+                                    squirrel[idx]);
+  }
+}
+
+/**
+   Glide `squirrel`, row `row` of the colony, towards the acorn trees. Like
+   `sqr_move_normal_to_acorn` the tree is picked per element, tree `1 + (element % 3)`
+   where `element` counts the dimensions of the unpadded colony, `dim` per squirrel.
+ */
+static inline void sqr_simd_glide_to_acorns(__m256 *const squirrel, const __m256 *const acorns,
+                                            const float *const glides, size_t row, size_t dim,
+                                            size_t simd_dim) {
+  const __m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+  const __m256i threes = _mm256_set1_epi32(3);
+  // tree of every lane for each of the three offsets of the first lane
+  __m256 second_tree[3], third_tree[3];
+  for (int offset = 0; offset < 3; offset++) {
+    __m256i tree = _mm256_add_epi32(lanes, _mm256_set1_epi32(offset));
+    for (int wrap = 0; wrap < 3; wrap++) {
+      tree = _mm256_sub_epi32(tree, _mm256_andnot_si256(_mm256_cmpgt_epi32(threes, tree), threes));
+    }
+    second_tree[offset] = _mm256_castsi256_ps(_mm256_cmpeq_epi32(tree, _mm256_set1_epi32(1)));
+    third_tree[offset] = _mm256_castsi256_ps(_mm256_cmpeq_epi32(tree, _mm256_set1_epi32(2)));
+  }
+
+  const size_t first_offset = (row * dim) % 3;
+  for (size_t idx = 0; idx < simd_dim; idx++) {
+    // 8 dimensions further, the tree of the first lane moves on by 2
+    const size_t offset = (first_offset + 2 * idx) % 3;
+    __m256 target = acorns[idx];
+    target = _mm256_blendv_ps(target, acorns[simd_dim + idx], second_tree[offset]);
+    target = _mm256_blendv_ps(target, acorns[2 * simd_dim + idx], third_tree[offset]);
+    const __m256 glide = _mm256_loadu_ps(&glides[8 * idx]);
+    squirrel[idx] = _mm256_fmadd_ps(glide, _mm256_sub_ps(target, squirrel[idx]), squirrel[idx]);
+  }
+}
+
+
+/**
+   Squirrel search on AVX2 and `n_threads` threads, 0 uses the OpenMP default. Every
+   thread moves a contiguous slice of each group of squirrels with its own random stream,
+   so the result depends on the number of threads, runs on the same number are identical.
+
+   Returns:
+     The position minimising the objective function. This array has size `dim`.
+ */
+float *squirrel_parallel(simd_obj_func_t obj_func,
+                         size_t pop_size,
+                         size_t dim,
+                         size_t max_iter,
+                         const float min_position,
+                         const float max_position,
+                         size_t n_threads) {
+  if (n_threads == 0) {
+    n_threads = default_num_threads();
+  }
+  const size_t simd_dim = (dim + 7) / 8;
+  const size_t padded_dim = simd_dim * 8;
+  // the hickory tree, the acorn trees and the squirrels gliding to the hickory tree
+  size_t hickory_end = (size_t)ceil(4 + NUM_JUMP_HICK * pop_size);
+  hickory_end = hickory_end < pop_size ? hickory_end : pop_size;
+
+  // the Levy constants only depend on BETA
+  const float sigma_u = rng_levy_sigma(BETA);
+  const float inv_beta = 1.0f / BETA;
+  const float range = max_position - min_position;
+
+  rng_stream_t *rngs = rng_alloc_streams(n_threads, 100);
+  // the predator coins of the whole colony, only drawn in `single` blocks, by any thread
+  rng_t coins;
+  rng_seed(&coins, 99);
+
+  __m256 *positions = (__m256*)aligned_alloc(sizeof(__m256),
+                                             pop_size * simd_dim * sizeof(__m256));
+  float *fitness = (float*)malloc(pop_size * sizeof(float));
+  // random numbers of the squirrel every thread moves, two per dimension for a Levy step
+  float *scratch = (float*)aligned_alloc(sizeof(__m256), n_threads * 2 * padded_dim * sizeof(float));
+  if (!positions || !fitness || !scratch) { perror("malloc arr"); exit(EXIT_FAILURE); };
+
+  const __m256 tail = _mm256_castsi256_ps(simd_tail_mask(dim));
+  for (size_t row = 0; row < pop_size; row++) {
+    rng_uniform(&rngs[0].rng, (float*)&positions[row * simd_dim], padded_dim,
+                min_position, max_position);
+    positions[(row + 1) * simd_dim - 1] = _mm256_and_ps(positions[(row + 1) * simd_dim - 1], tail);
+  }
+
+  int hickory_predator = 0, normal_predator = 0, restart = 0;
+  float s_min = sqr_eval_smin(0);
+
+  #pragma omp parallel num_threads(n_threads)
+  {
+#ifdef _OPENMP
+    size_t thread = (size_t)omp_get_thread_num();
+    size_t team_size = (size_t)omp_get_num_threads();
+#else
+    size_t thread = 0;
+    size_t team_size = 1;
+#endif
+    rng_t *const rng = &rngs[thread].rng;
+    float *const rands = &scratch[thread * 2 * padded_dim];
+    // slices of the squirrels gliding to the hickory tree and of those on normal trees
+    const size_t n_hickory = hickory_end - 1;
+    const size_t hickory_begin = 1 + n_hickory * thread / team_size;
+    const size_t hickory_stop = 1 + n_hickory * (thread + 1) / team_size;
+    const size_t n_normal = pop_size - hickory_end;
+    const size_t normal_begin = hickory_end + n_normal * thread / team_size;
+    const size_t normal_stop = hickory_end + n_normal * (thread + 1) / team_size;
+
+    for (size_t row = pop_size * thread / team_size; row < pop_size * (thread + 1) / team_size; row++) {
+      fitness[row] = obj_func(&positions[row * simd_dim], dim);
+    }
+    #pragma omp barrier
+
+    #pragma omp single
+    {
+      // positions[0] is hickory, positions[1:3] are acorn, rest are normal.
+      sqr_lowest4_vals_to_front(fitness, (float*)positions, pop_size, padded_dim);
+      hickory_predator = sqr_bernoulli_distribution(&coins, PREDATOR_PROB);
+      normal_predator = sqr_bernoulli_distribution(&coins, PREDATOR_PROB);
+    }
+
+    for (size_t iter = 1; iter <= max_iter; iter++) {
+      for (size_t row = hickory_begin; row < hickory_stop; row++) {
+        __m256 *const squirrel = &positions[row * simd_dim];
+        if (hickory_predator) {
+          rng_uniform(rng, (float*)squirrel, padded_dim, min_position, max_position);
+          squirrel[simd_dim - 1] = _mm256_and_ps(squirrel[simd_dim - 1], tail);
+        } else {
+          // gliding distances of the whole squirrel in one bulk fill
+          rng_uniform(rng, rands, padded_dim,
+                      SQR_GLIDE_PER_LIFT * CL_MIN, SQR_GLIDE_PER_LIFT * CL_MAX);
+          sqr_simd_glide(squirrel, positions, rands, simd_dim);
+        }
+        fitness[row] = obj_func(squirrel, dim);
+      }
+      // `single` has no barrier on entry, the acorn trees must be final before the season
+      #pragma omp barrier
+
+      #pragma omp single
+      {
+        // the acorn trees have moved, a new season relocates the squirrels on normal trees
+        restart = sqr_eval_seasonal_cons((float*)positions, padded_dim) < s_min;
+        s_min = sqr_eval_smin(iter);
+      } // implicit barrier, all threads see the season
+
+      for (size_t row = normal_begin; row < normal_stop; row++) {
+        __m256 *const squirrel = &positions[row * simd_dim];
+        if (restart) {
+          rng_uniform(rng, rands, 2 * padded_dim, 0.0, 1.0);
+          sqr_simd_levy_steps((float*)squirrel, rands, simd_dim, sigma_u, inv_beta);
+          const __m256 scale = _mm256_set1_ps(0.01 * range);
+          const __m256 min_pos = _mm256_set1_ps(min_position);
+          for (size_t idx = 0; idx < simd_dim; idx++) {
+            squirrel[idx] = _mm256_fmadd_ps(scale, squirrel[idx], min_pos);
+          }
+          squirrel[simd_dim - 1] = _mm256_and_ps(squirrel[simd_dim - 1], tail);
+        } else if (normal_predator) {
+          rng_uniform(rng, (float*)squirrel, padded_dim, min_position, max_position);
+          squirrel[simd_dim - 1] = _mm256_and_ps(squirrel[simd_dim - 1], tail);
+        } else {
+          rng_uniform(rng, rands, padded_dim,
+                      SQR_GLIDE_PER_LIFT * CL_MIN, SQR_GLIDE_PER_LIFT * CL_MAX);
+          sqr_simd_glide_to_acorns(squirrel, &positions[simd_dim], rands, row, dim, simd_dim);
+        }
+        fitness[row] = obj_func(squirrel, dim);
+      }
+      #pragma omp barrier
+
+      #pragma omp single
+      {
+        sqr_lowest4_vals_to_front(fitness, (float*)positions, pop_size, padded_dim);
+        hickory_predator = sqr_bernoulli_distribution(&coins, PREDATOR_PROB);
+        normal_predator = sqr_bernoulli_distribution(&coins, PREDATOR_PROB);
+      } // implicit barrier, all threads see the new trees
+    }
+  }
+
+  float *const best_solution = (float *const) malloc(dim * sizeof(float));
+  if (!best_solution) { perror("malloc arr"); exit(EXIT_FAILURE); };
+  memcpy(best_solution, positions, dim * sizeof(float));
+
+  free(rngs);
+  free(positions);
+  free(fitness);
+  free(scratch);
+
+  return best_solution;
+}
+
+/**
+   Squirrel search on AVX2, single threaded.
+ */
+float *squirrel_simd(simd_obj_func_t obj_func,
+                     size_t pop_size,
+                     size_t dim,
+                     size_t max_iter,
+                     const float min_position,
+                     const float max_position) {
+  return squirrel_parallel(obj_func, pop_size, dim, max_iter, min_position, max_position, 1);
+}
+
+/**
+   Squirrel search on AVX2 and the default number of threads.
+ */
+float *squirrel_simd_mt(simd_obj_func_t obj_func,
+                        size_t pop_size,
+                        size_t dim,
+                        size_t max_iter,
+                        const float min_position,
+                        const float max_position) {
+  return squirrel_parallel(obj_func, pop_size, dim, max_iter, min_position, max_position, 0);
+}
@@ -1,28 +1,12 @@
-#include <immintrin.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <math.h>
 
-#include "utils.h"
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
-float horizontal_add(__m256 a) {
-  __m256 t1 = _mm256_hadd_ps(a,a);
-  __m256 t2 = _mm256_hadd_ps(t1,t1);
-  __m128 t3 = _mm256_extractf128_ps(t2,1);
-  __m128 t4 = _mm_add_ss(_mm256_castps256_ps128(t2),t3);
-  return _mm_cvtss_f32(t4);
-}
-
-// Possibly more efficient solution than above
-/* float horizontal_add(__m256 x) { */
-/*   __m128 hi = _mm256_extractf128_ps(x, 1); */
-/*   __m128 lo = _mm256_extractf128_ps(x, 0); */
-/*   lo = _mm_add_ps(hi, lo); */
-/*   hi = _mm_movehl_ps(hi, lo); */
-/*   lo = _mm_add_ps(hi, lo); */
-/*   hi = _mm_shuffle_ps(lo, lo, 1); */
-/*   lo = _mm_add_ss(hi, lo); */
-/*   return _mm_cvtss_f32(lo); */
-/* } */
+#include "utils.h"
 
 float *filled_float_array(size_t length, float val) {
   float *res = (float *) malloc(length * sizeof(float));
@@ -82,6 +66,14 @@ float linear_scale(float start, float end, size_t iter_max, size_t iter) {
   return (start + factor);
 }
 
+size_t default_num_threads(void) {
+#ifdef _OPENMP
+  return (size_t)omp_get_max_threads();
+#else
+  return 1;
+#endif
+}
+
 
 /**
    Prints the population to standard output.
@@ -126,6 +118,56 @@ void mmm(size_t dim, const float* const a, const float* const b, float* const re
 }
 
 
+// rows of `b` per block of `gemm`
+#define GEMM_BLOCK 64
+
+void gemm(size_t m, size_t n, size_t k, const float* const a, const float* const b,
+          float* const res) {
+  fill_float_array(res, m * n, 0.0);
+  for(size_t block = 0; block < k; block += GEMM_BLOCK) {
+    const size_t block_end = block + GEMM_BLOCK < k ? block + GEMM_BLOCK : k;
+    for(size_t row = 0; row < m; row++) {
+      for(size_t runner = block; runner < block_end; runner++) {
+        const float factor = a[row * k + runner];
+        for(size_t col = 0; col < n; col++) {
+          res[row * n + col] += factor * b[runner * n + col];
+        }
+      }
+    }
+  }
+}
+
+
+void transpose(size_t rows, size_t cols, const float* const a, float* const res) {
+  for(size_t row = 0; row < rows; row++) {
+    for(size_t col = 0; col < cols; col++) {
+      res[col * rows + row] = a[row * cols + col];
+    }
+  }
+}
+
+
+void pairwise_distances(size_t count, size_t dim, const float* const points,
+                        float* const points_t, float* const distances) {
+  transpose(count, dim, points, points_t);
+  gemm(count, count, dim, points, points_t, distances);
+
+  // the squared norms are the diagonal of the Gram matrix
+  float norms[count];
+  for(size_t idx = 0; idx < count; idx++) {
+    norms[idx] = distances[idx * count + idx];
+  }
+  for(size_t row = 0; row < count; row++) {
+    for(size_t col = 0; col < count; col++) {
+      // rounding can leave close points slightly below zero
+      const float squared = norms[row] + norms[col] - 2.0f * distances[row * count + col];
+      distances[row * count + col] = squared > 0.0f ? sqrtf(squared) : 0.0f;
+    }
+    distances[row * count + row] = 0.0;
+  }
+}
+
+
 void mvm(size_t dim, const float* m, const float* v, float* res) {
   for(size_t idx = 0; idx < dim; idx++) {
     float sum = 0.0;
@@ -196,21 +238,3 @@ void print_float_array(size_t length, const float * arr) {
   }
   printf("#-----\n");
 }
-
-void simd_print_solution(size_t dim, const __m256 *const solution) {
-  float tmp[8];
-  for (size_t idx = 0; idx < dim / 8; idx++) {
-    _mm256_storeu_ps(tmp, solution[idx]);
-    for (size_t j = 0; j < 8; j++) {
-      printf("%.4f, ", tmp[j]);
-    }
-  }
-  printf("\n");
-}
-
-void simd_print_population(size_t colony_size, size_t dim, const __m256 *population) {
-  for (size_t idx = 0; idx < colony_size; idx++) {
-    printf("member%03ld, ", idx);
-    print_solution(dim, &population[idx * dim / 8]);
-  }
-}
@@ -0,0 +1,135 @@
+#include <immintrin.h>
+#include <stdio.h>
+
+#include "utils.h"
+
+float horizontal_add(__m256 a) {
+  __m256 t1 = _mm256_hadd_ps(a,a);
+  __m256 t2 = _mm256_hadd_ps(t1,t1);
+  __m128 t3 = _mm256_extractf128_ps(t2,1);
+  __m128 t4 = _mm_add_ss(_mm256_castps256_ps128(t2),t3);
+  return _mm_cvtss_f32(t4);
+}
+
+// Possibly more efficient solution than above
+/* float horizontal_add(__m256 x) { */
+/*   __m128 hi = _mm256_extractf128_ps(x, 1); */
+/*   __m128 lo = _mm256_extractf128_ps(x, 0); */
+/*   lo = _mm_add_ps(hi, lo); */
+/*   hi = _mm_movehl_ps(hi, lo); */
+/*   lo = _mm_add_ps(hi, lo); */
+/*   hi = _mm_shuffle_ps(lo, lo, 1); */
+/*   lo = _mm_add_ss(hi, lo); */
+/*   return _mm_cvtss_f32(lo); */
+/* } */
+
+__m256i simd_tail_mask(size_t dim) {
+  const size_t rem = dim % 8;
+  const __m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+  return _mm256_cmpgt_epi32(_mm256_set1_epi32(rem ? (int)rem : 8), lanes);
+}
+
+void simd_print_solution(size_t dim, const __m256 *const solution) {
+  float tmp[8];
+  for (size_t idx = 0; idx < dim / 8; idx++) {
+    _mm256_storeu_ps(tmp, solution[idx]);
+    for (size_t j = 0; j < 8; j++) {
+      printf("%.4f, ", tmp[j]);
+    }
+  }
+  printf("\n");
+}
+
+void simd_print_population(size_t colony_size, size_t dim, const __m256 *population) {
+  for (size_t idx = 0; idx < colony_size; idx++) {
+    printf("member%03ld, ", idx);
+    print_solution(dim, &population[idx * dim / 8]);
+  }
+}
+
+// rows of `b` per block of `simd_gemm`, 128 rows of 512 columns fill 256KB
+#define SIMD_GEMM_BLOCK 128
+
+/**
+   `rows` (at most 4) rows times 16 columns of `res` += `a` times the rows `begin` to
+   `end` of `b`. `mask` selects the columns of the two vectors that exist.
+ */
+static inline __attribute__((always_inline))
+void simd_gemm_block(size_t rows, size_t n, size_t k, size_t begin, size_t end,
+                     const float* a, const float* b, float* res, const __m256i mask[2]) {
+  __m256 acc[4][2];
+  for(size_t row = 0; row < rows; row++) {
+    acc[row][0] = _mm256_maskload_ps(&res[row * n], mask[0]);
+    acc[row][1] = _mm256_maskload_ps(&res[row * n + 8], mask[1]);
+  }
+  for(size_t runner = begin; runner < end; runner++) {
+    const __m256 b0 = _mm256_maskload_ps(&b[runner * n], mask[0]);
+    const __m256 b1 = _mm256_maskload_ps(&b[runner * n + 8], mask[1]);
+    for(size_t row = 0; row < rows; row++) {
+      const __m256 factor = _mm256_broadcast_ss(&a[row * k + runner]);
+      acc[row][0] = _mm256_fmadd_ps(factor, b0, acc[row][0]);
+      acc[row][1] = _mm256_fmadd_ps(factor, b1, acc[row][1]);
+    }
+  }
+  for(size_t row = 0; row < rows; row++) {
+    _mm256_maskstore_ps(&res[row * n], mask[0], acc[row][0]);
+    _mm256_maskstore_ps(&res[row * n + 8], mask[1], acc[row][1]);
+  }
+}
+
+void simd_gemm(size_t m, size_t n, size_t k, const float* const a, const float* const b,
+               float* const res) {
+  const __m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+  fill_float_array(res, m * n, 0.0);
+  for(size_t begin = 0; begin < k; begin += SIMD_GEMM_BLOCK) {
+    const size_t end = begin + SIMD_GEMM_BLOCK < k ? begin + SIMD_GEMM_BLOCK : k;
+    for(size_t col = 0; col < n; col += 16) {
+      // columns past `n` are masked out of every load and store
+      const int width = n - col < 16 ? (int)(n - col) : 16;
+      const __m256i mask[2] = {_mm256_cmpgt_epi32(_mm256_set1_epi32(width), lanes),
+                               _mm256_cmpgt_epi32(_mm256_set1_epi32(width - 8), lanes)};
+      // the 16 columns of the block of `b` stay in L1 while all rows of `a` pass
+      size_t row = 0;
+      for(; row + 4 <= m; row += 4) {
+        simd_gemm_block(4, n, k, begin, end, &a[row * k], &b[col], &res[row * n + col], mask);
+      }
+      for(; row < m; row++) {
+        simd_gemm_block(1, n, k, begin, end, &a[row * k], &b[col], &res[row * n + col], mask);
+      }
+    }
+  }
+}
+
+
+void simd_pairwise_distances(size_t count, size_t dim, const float* const points,
+                             float* const points_t, float* const distances) {
+  transpose(count, dim, points, points_t);
+  simd_gemm(count, count, dim, points, points_t, distances);
+
+  // the squared norms are the diagonal of the Gram matrix
+  float norms[count];
+  for(size_t idx = 0; idx < count; idx++) {
+    norms[idx] = distances[idx * count + idx];
+  }
+  const __m256 minus_two = _mm256_set1_ps(-2.0);
+  const __m256 zeros = _mm256_setzero_ps();
+  const __m256i tail = simd_tail_mask(count);
+  for(size_t row = 0; row < count; row++) {
+    const __m256 norm_row = _mm256_set1_ps(norms[row]);
+    float* const dist_row = &distances[row * count];
+    size_t col = 0;
+    for(; col + 8 <= count; col += 8) {
+      const __m256 norm_sum = _mm256_add_ps(norm_row, _mm256_loadu_ps(&norms[col]));
+      // rounding can leave close points slightly below zero
+      const __m256 squared = _mm256_fmadd_ps(minus_two, _mm256_loadu_ps(&dist_row[col]), norm_sum);
+      _mm256_storeu_ps(&dist_row[col], _mm256_sqrt_ps(_mm256_max_ps(squared, zeros)));
+    }
+    if(col < count) {
+      const __m256 norm_sum = _mm256_add_ps(norm_row, _mm256_maskload_ps(&norms[col], tail));
+      const __m256 squared = _mm256_fmadd_ps(minus_two, _mm256_maskload_ps(&dist_row[col], tail),
+                                             norm_sum);
+      _mm256_maskstore_ps(&dist_row[col], tail, _mm256_sqrt_ps(_mm256_max_ps(squared, zeros)));
+    }
+    dist_row[row] = 0.0;
+  }
+}
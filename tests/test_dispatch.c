@@ -0,0 +1,28 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "dispatch.h"
+
+#include <criterion/criterion.h>
+
+Test(dispatch_unit, detect_isa) {
+  isa_t isa = detect_isa();
+  cr_expect_eq(isa >= ISA_AVX2, __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"),
+               "AVX2 should be detected iff the CPU supports AVX2 and FMA, got %s", isa_name(isa));
+  cr_expect_eq(isa >= ISA_AVX512, !!__builtin_cpu_supports("avx512f"),
+               "AVX-512 should be detected iff the CPU supports AVX-512F, got %s", isa_name(isa));
+}
+
+Test(dispatch_unit, resolve_isa) {
+  cr_expect_eq(resolve_isa(NULL, ISA_AVX2), ISA_AVX2, "no request should keep the detected ISA");
+  cr_expect_eq(resolve_isa("scalar", ISA_AVX512), ISA_SCALAR, "narrower requests should be honoured");
+  cr_expect_eq(resolve_isa("avx2", ISA_AVX512), ISA_AVX2, "narrower requests should be honoured");
+  cr_expect_eq(resolve_isa("avx512", ISA_AVX2), ISA_AVX2, "wider requests should be lowered");
+  cr_expect_eq(resolve_isa("sse9", ISA_AVX2), ISA_AVX2, "unknown requests should be ignored");
+}
+
+Test(dispatch_unit, isa_name) {
+  for(isa_t isa = ISA_SCALAR; isa <= ISA_AVX512; isa++) {
+    cr_expect_eq(resolve_isa(isa_name(isa), ISA_AVX512), isa, "isa_name should round trip");
+  }
+}
@@ -1,5 +1,6 @@
 #include <float.h>
 #include <math.h>
+#include <string.h>
 
 #include "objectives.h"
 #include "hgwosca.h"
@@ -14,7 +15,9 @@ Test(hgwosca_unit, init_population) {
   float min = 0.0;
   float max = 10.0;
   float population[wolf_count * dim];
-  gwo_init_population(population, wolf_count, dim, min, max);
+  rng_t rng;
+  rng_seed(&rng, 100);
+  gwo_init_population(&rng, population, wolf_count, dim, min, max);
   for(size_t wolf = 0; wolf < wolf_count * dim; wolf++) {
     cr_expect_leq(population[wolf], max,
                   "dimension of wolf %ld should be bound above", wolf);
@@ -110,3 +113,37 @@ Test(hgwosca_unit, clamp_all_positions) {
                   "clamped value at index %ld is bound below by min", idx);
   }
 }
+
+
+Test(hgwosca_unit, simd_update_wolf_position) {
+  if(!__builtin_cpu_supports("avx2") || !__builtin_cpu_supports("fma")) {
+    cr_skip_test();
+  }
+  // 19 dimensions, the last vector is partial
+  const size_t dim = 19, simd_dim = 3;
+  __m256 wolf[3], alpha[3], beta[3], delta[3];
+  float *const wolf_f = (float*)wolf, *const alpha_f = (float*)alpha;
+  float *const beta_f = (float*)beta, *const delta_f = (float*)delta;
+  float expected[24];
+  float planar[GWO_WOLF_RANDS * 24], interleaved[GWO_WOLF_RANDS * 24];
+  rng_t rng;
+  rng_seed(&rng, 5);
+  rng_uniform(&rng, wolf_f, 24, -10.0, 10.0);
+  rng_uniform(&rng, alpha_f, 24, -10.0, 10.0);
+  rng_uniform(&rng, beta_f, 24, -10.0, 10.0);
+  rng_uniform(&rng, delta_f, 24, -10.0, 10.0);
+  rng_uniform(&rng, planar, GWO_WOLF_RANDS * 24, 0.0, 1.0);
+  for(size_t idx = 0; idx < 24; idx++) {
+    for(size_t draw = 0; draw < GWO_WOLF_RANDS; draw++) {
+      interleaved[idx * GWO_WOLF_RANDS + draw] = planar[draw * 24 + idx];
+    }
+  }
+  memcpy(expected, wolf_f, sizeof(expected));
+
+  gwo_update_wolf_position(dim, 1.3, expected, alpha_f, beta_f, delta_f, interleaved);
+  gwo_simd_update_wolf_position(simd_dim, 1.3, wolf, alpha, beta, delta, planar);
+  for(size_t idx = 0; idx < dim; idx++) {
+    cr_expect_float_eq(wolf_f[idx], expected[idx], 1e-4,
+                       "dimension %ld should match the scalar update", idx);
+  }
+}
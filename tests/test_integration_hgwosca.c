@@ -28,3 +28,18 @@ Test(hgwosca_integration, sphere) {
   test_algo(sphere, 30, 10, -100, 100, 800, gwo_hgwosca, 0, 0.5,
             true, "HGWOSCA", "sphere");
 }
+
+Test(hgwosca_integration, opt_simd_sphere) {
+  test_simd_algo(opt_simd_sphere, 30, 10, -100, 100, 800, gwo_hgwosca_simd, 0, 0.5,
+                 true, "HGWOSCA", "simd_sphere");
+}
+
+Test(hgwosca_integration, opt_simd_rosenbrock) {
+  test_simd_algo(opt_simd_rosenbrock, 40, 3, -100, 100, 1500, gwo_hgwosca_simd, 0, 0.001,
+                 true, "HGWOSCA", "simd_rosenbrock");
+}
+
+Test(hgwosca_integration, opt_simd_sum_of_squares_mt) {
+  test_simd_algo(opt_simd_sum_of_squares, 60, 21, -100, 100, 800, gwo_hgwosca_simd_mt, 0, 0.5,
+                 true, "HGWOSCA", "simd_sum_of_squares_mt");
+}
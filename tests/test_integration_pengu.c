@@ -1,9 +1,19 @@
+// setenv of the rotation cache
+#define _POSIX_C_SOURCE 200809L
+
 #include <criterion/criterion.h>
+#include <stdlib.h>
 
 #include "testing_utilities.h"
 #include "objectives.h"
 #include "penguin.h"
 
+// disable the rotation cache, a test run must not leave files in the user's cache
+static void disable_rotation_cache(void) {
+  setenv("FASTCODE_CACHE_DIR", "", 1);
+}
+
+TestSuite(pengu_integration, .init = disable_rotation_cache);
 
 Test(pengu_integration, sum) {
   test_algo(sum, 50, 2, -5, 5, 100, pen_emperor_penguin, -10, 0.1,
@@ -29,3 +39,13 @@ Test(pengu_integration, sphere) {
   test_algo(sphere, 100, 2, -5, 5, 200, pen_emperor_penguin, 0, 0.1,
             true, "EPC", "sphere");
 }
+
+Test(pengu_integration, sum_of_squares_mt) {
+  test_algo(sum_of_squares, 50, 2, -5, 5, 100, pen_emperor_penguin_mt, 0, 0.1,
+            true, "EPC", "sum_of_squares_mt");
+}
+
+Test(pengu_integration, rosenbrock_mt) {
+  test_algo(rosenbrock, 100, 2, -5, 5, 300, pen_emperor_penguin_mt, 0, 0.3,
+            true, "EPC", "rosenbrock_mt");
+}
@@ -3,6 +3,10 @@
 #include "testing_utilities.h"
 #include "objectives.h"
 #include "pso.h"
+#include "pso_aosoa.h"
+#include "pso_avx512.h"
+#include "pso_fused.h"
+#include "pso_scalar.h"
 
 #define SWARM_SIZE 1024
 #define DIM 8
@@ -17,3 +21,89 @@ Test(pso_integration, opt_simd_rosenbrock) {
   test_simd_algo(opt_simd_rosenbrock, 6000, DIM, -30, 30, 3000, pso_basic, 0, 6,
             true, "PSO", "rosenbrock");
 }
+
+
+Test(pso_integration, opt_simd_sum_of_squares_parallel) {
+  size_t n_threads = 4;
+  float* solution = pso_parallel(opt_simd_sum_of_squares, SWARM_SIZE, DIM, 6000, -10, 10, n_threads);
+  __m256 tmp[] = {_mm256_loadu_ps(solution)};
+  cr_expect_float_eq(opt_simd_sum_of_squares(tmp, DIM), 0, 0.1,
+                     "objective should be minimised with %ld threads", n_threads);
+  free(solution);
+}
+
+
+Test(pso_integration, opt_avx512_sum_of_squares) {
+  if(!__builtin_cpu_supports("avx512f")) {
+    cr_skip_test();
+  }
+  float* solution = pso_basic_avx512(opt_avx512_sum_of_squares, SWARM_SIZE, 16, 6000, -10, 10);
+  cr_expect_float_eq(sum_of_squares(solution, 16), 0, 0.1, "objective should be minimised at 0");
+  free(solution);
+}
+
+Test(pso_integration, opt_avx512_sum_of_squares_parallel) {
+  if(!__builtin_cpu_supports("avx512f")) {
+    cr_skip_test();
+  }
+  size_t n_threads = 4;
+  float* solution = pso_parallel_avx512(opt_avx512_sum_of_squares, SWARM_SIZE, 16, 6000, -10, 10,
+                                        n_threads);
+  cr_expect_float_eq(sum_of_squares(solution, 16), 0, 0.1,
+                     "objective should be minimised with %ld threads", n_threads);
+  free(solution);
+}
+
+Test(pso_integration, sum_of_squares_scalar) {
+  test_algo(sum_of_squares, 128, 5, -10, 10, 500, pso_basic_scalar, 0, 0.1,
+            true, "PSO", "sum_of_squares_scalar");
+}
+
+Test(pso_integration, opt_simd_sum_of_squares_odd_sizes) {
+  test_simd_algo(opt_simd_sum_of_squares, 100, 13, -10, 10, 3000, pso_basic, 0, 0.1,
+            true, "PSO", "sum_of_squares_odd_sizes");
+}
+
+Test(pso_integration, opt_avx512_sum_of_squares_odd_sizes) {
+  if(!__builtin_cpu_supports("avx512f")) {
+    cr_skip_test();
+  }
+  float* solution = pso_basic_avx512(opt_avx512_sum_of_squares, 1000, 21, 3000, -10, 10);
+  cr_expect_float_eq(sum_of_squares(solution, 21), 0, 0.1, "objective should be minimised at 0");
+  free(solution);
+}
+
+Test(pso_integration, opt_simd_sum_of_squares_x8) {
+  test_simd_algo(opt_simd_sum_of_squares, 100, 13, -10, 10, 3000, pso_basic_x8, 0, 0.1,
+            true, "PSO", "sum_of_squares_x8");
+}
+
+Test(pso_integration, opt_simd_rosenbrock_x8) {
+  test_simd_algo(opt_simd_rosenbrock, 6000, DIM, -30, 30, 3000, pso_basic_x8, 0, 6,
+            true, "PSO", "rosenbrock_x8");
+}
+
+Test(pso_integration, opt_simd_sum_of_squares_aosoa) {
+  test_simd_algo(opt_simd_sum_of_squares, 100, 13, -10, 10, 3000, pso_basic_aosoa, 0, 0.1,
+            true, "PSO", "sum_of_squares_aosoa");
+}
+
+Test(pso_integration, opt_simd_sum_of_squares_mt_counter) {
+  test_simd_algo(opt_simd_sum_of_squares, 100, 13, -10, 10, 3000, pso_basic_mt_counter, 0, 0.1,
+            true, "PSO", "sum_of_squares_mt_counter");
+}
+
+Test(pso_integration, opt_simd_rosenbrock_mt_counter) {
+  test_simd_algo(opt_simd_rosenbrock, 6000, DIM, -30, 30, 3000, pso_basic_mt_counter, 0, 6,
+            true, "PSO", "rosenbrock_mt_counter");
+}
+
+Test(pso_integration, opt_simd_sum_of_squares_fused) {
+  test_simd_algo(opt_simd_sum_of_squares, 100, 13, -10, 10, 3000, pso_basic_fused, 0, 0.1,
+            true, "PSO", "sum_of_squares_fused");
+}
+
+Test(pso_integration, opt_simd_rosenbrock_fused) {
+  test_simd_algo(opt_simd_rosenbrock, 6000, DIM, -30, 30, 3000, pso_basic_fused, 0, 6,
+            true, "PSO", "rosenbrock_fused");
+}
@@ -27,3 +27,18 @@ Test(pso_basic_integration, rastigrin) {
   test_algo(rastigrin, POPULATION, DIM, -5, 5, 1000, squirrel, 0, 0.1,
             true, "Squirrel", "rastigrin");
 }
+
+Test(squirrel_integration, opt_simd_sum_of_squares) {
+  test_simd_algo(opt_simd_sum_of_squares, POPULATION, DIM, -10, 10, 250, squirrel_simd, 0, 0.1,
+                 true, "Squirrel", "simd_sum_of_squares");
+}
+
+Test(squirrel_integration, opt_simd_sphere) {
+  test_simd_algo(opt_simd_sphere, 100, 19, -5, 5, 500, squirrel_simd, 0, 0.1,
+                 true, "Squirrel", "simd_sphere");
+}
+
+Test(squirrel_integration, opt_simd_sum_of_squares_mt) {
+  test_simd_algo(opt_simd_sum_of_squares, POPULATION, 10, -10, 10, 250, squirrel_simd_mt, 0, 0.1,
+                 true, "Squirrel", "simd_sum_of_squares_mt");
+}
@@ -69,7 +69,6 @@ Test(obj_unit, rosenbrock) {
   Testing Multidimensional Rosenbrock Function
 */
 Test(obj_unit, simd_rosenbrock) {
-  init_obj_globals();
   float args[] = {2, 1, 1, 1000000, 1 , 5, 2, 1, 1, 1 , 2 , 12 , 13321 , 546 , 446 , 656, 64  , 654 , 654};
 
   cr_expect_float_eq(simd_rosenbrock(args,18), rosenbrock(args,18), FLT_EPSILON, "simd_rosenbrock function works as expected.");
@@ -79,11 +78,130 @@ Test(obj_unit, simd_rosenbrock) {
   Testing Multidimensional Rosenbrock Function
 */
 Test(obj_unit, opt_simd_rosenbrock) {
-  cr_skip_test();
-  init_obj_globals();
-  float args[] = {2, 1, 1, 1000000, 1 , 5, 2, 1, 1, 1 , 2 , 12 , 13321 , 546 , 446 , 656, 64};
+  float args[] = {2, 1, 1, -3, 1 , 5, 2, 1, 1, 1 , 2 , 12 , -4 , 6 , 4 , 6, 7};
   __m256 simd_args[] = {_mm256_loadu_ps(args), _mm256_loadu_ps(&args[8])};
-  cr_expect_float_eq(opt_simd_rosenbrock(simd_args,2), rosenbrock(args,16), FLT_EPSILON, "simd_rosenbrock function works as expected.");
+  cr_expect_float_eq(opt_simd_rosenbrock(simd_args,16), rosenbrock(args,16), FLT_EPSILON, "simd_rosenbrock function works as expected.");
+}
+
+/*
+  Testing the SIMD objectives on dimensions that are not multiples of 8
+*/
+Test(obj_unit, opt_simd_masked_tails) {
+  float args[24];
+  for(size_t idx = 0; idx < 24; idx++) {
+    args[idx] = (float)(idx % 5) - 2;
+  }
+  __m256 simd_args[] = {_mm256_loadu_ps(args), _mm256_loadu_ps(&args[8]), _mm256_loadu_ps(&args[16])};
+  size_t dims[] = {1, 5, 9, 13, 17, 23};
+  for(size_t test = 0; test < sizeof(dims) / sizeof(dims[0]); test++) {
+    size_t dim = dims[test];
+    // padding lanes hold garbage here, the objectives must ignore them
+    cr_expect_float_eq(opt_simd_sum_of_squares(simd_args, dim), sum_of_squares(args, dim), FLT_EPSILON,
+                       "opt_simd_sum_of_squares should ignore padding for dim %ld", dim);
+    cr_expect_float_eq(opt_simd_rosenbrock(simd_args, dim), rosenbrock(args, dim), FLT_EPSILON,
+                       "opt_simd_rosenbrock should ignore padding for dim %ld", dim);
+    cr_expect_float_eq(simd_sum_of_squares(args, dim), sum_of_squares(args, dim), FLT_EPSILON,
+                       "simd_sum_of_squares should work for dim %ld", dim);
+  }
+}
+
+/*
+  Testing AVX-512 sum of squares
+*/
+Test(obj_unit, opt_avx512_sum_of_squares) {
+  if(!__builtin_cpu_supports("avx512f")) {
+    cr_skip_test();
+  }
+  // this translation unit is not built with AVX-512, so view aligned floats as vectors
+  float args[32] __attribute__((aligned(64)));
+  fill_float_array(args, 32, 2.0);
+  const __m512 *simd_args = (const __m512 *)args;
+  cr_expect_float_eq(opt_avx512_sum_of_squares(simd_args, 32), sum_of_squares(args, 32), FLT_EPSILON,
+                     "opt_avx512_sum_of_squares should match the scalar version");
+}
+
+/*
+  Testing AVX-512 Multidimensional Rosenbrock Function
+*/
+Test(obj_unit, opt_avx512_rosenbrock) {
+  if(!__builtin_cpu_supports("avx512f")) {
+    cr_skip_test();
+  }
+  float args[32] __attribute__((aligned(64)));
+  for(size_t idx = 0; idx < 32; idx++) {
+    args[idx] = (float)(idx % 5) - 2;
+  }
+  const __m512 *simd_args = (const __m512 *)args;
+  cr_expect_float_eq(opt_avx512_rosenbrock(simd_args, 32), rosenbrock(args, 32), FLT_EPSILON,
+                     "opt_avx512_rosenbrock should match the scalar version");
+  size_t dims[] = {1, 7, 16, 21, 31};
+  for(size_t test = 0; test < sizeof(dims) / sizeof(dims[0]); test++) {
+    size_t dim = dims[test];
+    cr_expect_float_eq(opt_avx512_rosenbrock(simd_args, dim), rosenbrock(args, dim), FLT_EPSILON,
+                       "opt_avx512_rosenbrock should ignore padding for dim %ld", dim);
+    cr_expect_float_eq(opt_avx512_sum_of_squares(simd_args, dim), sum_of_squares(args, dim), FLT_EPSILON,
+                       "opt_avx512_sum_of_squares should ignore padding for dim %ld", dim);
+  }
+}
+
+/*
+  Testing the cross-particle objectives against one particle at a time
+*/
+Test(obj_unit, opt_simd_lanes) {
+  const size_t dim = 13;
+  float particles[8][13];
+  __m256 lanes[13];
+  for(size_t d = 0; d < dim; d++) {
+    float column[8];
+    for(size_t p = 0; p < 8; p++) {
+      particles[p][d] = (float)((p + 3 * d) % 7) - 3;
+      column[p] = particles[p][d];
+    }
+    lanes[d] = _mm256_loadu_ps(column);
+  }
+
+  float fitness[8];
+  opt_simd_sum_of_squares_lanes(lanes, dim, fitness);
+  for(size_t p = 0; p < 8; p++) {
+    cr_expect_float_eq(fitness[p], sum_of_squares(particles[p], dim), FLT_EPSILON,
+                       "opt_simd_sum_of_squares_lanes should match particle %ld", p);
+  }
+  opt_simd_rosenbrock_lanes(lanes, dim, fitness);
+  for(size_t p = 0; p < 8; p++) {
+    cr_expect_float_eq(fitness[p], rosenbrock(particles[p], dim), FLT_EPSILON,
+                       "opt_simd_rosenbrock_lanes should match particle %ld", p);
+  }
+  cr_expect_eq(opt_simd_lanes_variant(opt_simd_rosenbrock), opt_simd_rosenbrock_lanes,
+               "opt_simd_rosenbrock should have a cross-particle variant");
+}
+
+Test(obj_unit, opt_simd_tiles) {
+  const size_t dim = 37;
+  __m256 args[5];
+  float values[40] = {0};
+  for(size_t d = 0; d < dim; d++) {
+    values[d] = (float)((5 * d) % 7) - 3;
+  }
+  for(size_t idx = 0; idx < 5; idx++) {
+    args[idx] = _mm256_loadu_ps(&values[idx * 8]);
+  }
+
+  // any split of the vectors into consecutive ranges sums up to the whole objective
+  size_t splits[] = {0, 1, 3, 4, 5};
+  __m256 sum_of_squares_tiles = _mm256_setzero_ps();
+  __m256 rosenbrock_tiles = _mm256_setzero_ps();
+  for(size_t tile = 0; tile + 1 < sizeof(splits) / sizeof(splits[0]); tile++) {
+    sum_of_squares_tiles = _mm256_add_ps(sum_of_squares_tiles,
+      opt_simd_sum_of_squares_tile(args, splits[tile], splits[tile + 1], dim));
+    rosenbrock_tiles = _mm256_add_ps(rosenbrock_tiles,
+      opt_simd_rosenbrock_tile(args, splits[tile], splits[tile + 1], dim));
+  }
+  cr_expect_float_eq(horizontal_add(sum_of_squares_tiles), sum_of_squares(values, dim), FLT_EPSILON,
+                     "opt_simd_sum_of_squares_tile should sum up to sum_of_squares");
+  cr_expect_float_eq(horizontal_add(rosenbrock_tiles), rosenbrock(values, dim), FLT_EPSILON,
+                     "opt_simd_rosenbrock_tile should sum up to rosenbrock");
+  cr_expect_eq(opt_simd_tile_variant(opt_simd_sum_of_squares), opt_simd_sum_of_squares_tile,
+               "opt_simd_sum_of_squares should have a partial variant");
 }
 
 /*
@@ -144,3 +262,140 @@ Test(obj_unit, beale) {
   float args[] = {3.0, 0.5};
   cr_expect_float_eq(beale(args, 2), 0, FLT_EPSILON, "Beale function works as expected.");
 }
+
+/*
+  Testing the SIMD versions of the other objectives against the scalar ones
+*/
+Test(obj_unit, opt_simd_multi_dimensional) {
+  float args[24];
+  for(size_t idx = 0; idx < 24; idx++) {
+    args[idx] = 0.37 * (float)(idx % 7) - 1.1;
+  }
+  __m256 simd_args[] = {_mm256_loadu_ps(args), _mm256_loadu_ps(&args[8]), _mm256_loadu_ps(&args[16])};
+  size_t dims[] = {2, 5, 8, 13, 17, 24};
+  for(size_t test = 0; test < sizeof(dims) / sizeof(dims[0]); test++) {
+    size_t dim = dims[test];
+    cr_expect_float_eq(opt_simd_rastigrin(simd_args, dim), rastigrin(args, dim), 1e-4,
+                       "opt_simd_rastigrin should match rastigrin for dim %ld", dim);
+    cr_expect_float_eq(opt_simd_sphere(simd_args, dim), sphere(args, dim), 1e-5,
+                       "opt_simd_sphere should match sphere for dim %ld", dim);
+    cr_expect_float_eq(opt_simd_griewank(simd_args, dim), griewank(args, dim), 1e-5,
+                       "opt_simd_griewank should match griewank for dim %ld", dim);
+    cr_expect_float_eq(opt_simd_schwefel01(simd_args, dim), schwefel01(args, dim), 1e-4,
+                       "opt_simd_schwefel01 should match schwefel01 for dim %ld", dim);
+  }
+}
+
+Test(obj_unit, opt_simd_fixed_dimensional) {
+  float points[][8] = {{0.0, 0.0, 0.0, 0.0}, {3.0, 0.5, 1.0, -2.0}, {5.0, 4.0, -0.3, 0.7},
+                       {-1.7, 2.3, 0.9, 4.1}, {512.0, 404.2319, 0.0, 0.0}, {-300.5, 17.25, 3.0, 2.0}};
+  for(size_t test = 0; test < sizeof(points) / sizeof(points[0]); test++) {
+    const float *x = points[test];
+    __m256 simd_args[] = {_mm256_loadu_ps(x)};
+    float ref = powel(x, 4);
+    cr_expect_float_eq(opt_simd_powel(simd_args, 4), ref, 1e-5 * fmaxf(1.0, fabsf(ref)),
+                       "opt_simd_powel should match powel at point %ld", test);
+    ref = freundsteinroth(x, 2);
+    cr_expect_float_eq(opt_simd_freundsteinroth(simd_args, 2), ref, 1e-5 * fmaxf(1.0, fabsf(ref)),
+                       "opt_simd_freundsteinroth should match freundsteinroth at point %ld", test);
+    ref = beale(x, 2);
+    cr_expect_float_eq(opt_simd_beale(simd_args, 2), ref, 1e-5 * fmaxf(1.0, fabsf(ref)),
+                       "opt_simd_beale should match beale at point %ld", test);
+    ref = egghol2d(x, 2);
+    cr_expect_float_eq(opt_simd_egghol2d(simd_args, 2), ref, 1e-5 * fmaxf(1.0, fabsf(ref)),
+                       "opt_simd_egghol2d should match egghol2d at point %ld", test);
+    ref = schaf2d(x, 2);
+    cr_expect_float_eq(opt_simd_schaf2d(simd_args, 2), ref, 1e-5,
+                       "opt_simd_schaf2d should match schaf2d at point %ld", test);
+  }
+}
+
+/*
+  Testing the batched objectives against one call per candidate
+*/
+Test(obj_unit, obj_eval_batch) {
+  const size_t count = 21, dim = 11;
+  float positions[count * dim];
+  for(size_t idx = 0; idx < count * dim; idx++) {
+    positions[idx] = 0.13 * (float)(idx % 29) - 1.7;
+  }
+  obj_func_t objectives[] = {sum_of_squares, sphere, rosenbrock, rastigrin, griewank, sum};
+  for(size_t test = 0; test < sizeof(objectives) / sizeof(objectives[0]); test++) {
+    float fitness[count];
+    obj_eval_batch(objectives[test], positions, count, dim, fitness);
+    for(size_t idx = 0; idx < count; idx++) {
+      const float ref = objectives[test](&positions[idx * dim], dim);
+      cr_expect_float_eq(fitness[idx], ref, 1e-5 * fmaxf(1.0, fabsf(ref)),
+                         "obj_eval_batch of objective %ld should match candidate %ld", test, idx);
+    }
+  }
+  cr_expect_eq(opt_simd_batch_variant(rosenbrock), opt_simd_rosenbrock_batch,
+               "rosenbrock should have a batched variant");
+  cr_expect_eq(opt_simd_batch_variant(sum), NULL, "sum should have no batched variant");
+}
+
+/*
+  Testing the objectives specialised on the dimension against the generic ones
+*/
+Test(obj_unit, opt_simd_dim_variant) {
+  float args[128];
+  for(size_t idx = 0; idx < 128; idx++) {
+    args[idx] = 0.21 * (float)(idx % 13) - 1.2;
+  }
+  __m256 simd_args[16];
+  for(size_t idx = 0; idx < 16; idx++) {
+    simd_args[idx] = _mm256_loadu_ps(&args[8 * idx]);
+  }
+  simd_obj_func_t objectives[] = {opt_simd_sum_of_squares, opt_simd_rosenbrock};
+  size_t dims[] = {8, 16, 32, 64, 128};
+  for(size_t obj = 0; obj < 2; obj++) {
+    for(size_t test = 0; test < sizeof(dims) / sizeof(dims[0]); test++) {
+      const size_t dim = dims[test];
+      simd_obj_func_t fixed = opt_simd_dim_variant(objectives[obj], dim);
+      cr_expect_neq(fixed, objectives[obj], "objective %ld should be specialised on dim %ld", obj, dim);
+      const float ref = objectives[obj](simd_args, dim);
+      cr_expect_float_eq(fixed(simd_args, dim), ref, 1e-6 * ref,
+                         "objective %ld specialised on dim %ld should match the generic one", obj, dim);
+    }
+    cr_expect_eq(opt_simd_dim_variant(objectives[obj], 40), opt_simd_unroll_variant(objectives[obj], 40),
+                 "objective %ld should fall back to the unrolled variant on dim 40", obj);
+  }
+}
+
+/*
+  Testing the objectives with independent accumulators against the generic ones
+*/
+Test(obj_unit, opt_simd_unrolled) {
+  const size_t max_dim = 1027;
+  __m256 simd_args[(max_dim + 7) / 8];
+  float *args = (float *)simd_args;
+  for(size_t idx = 0; idx < 8 * ((max_dim + 7) / 8); idx++) {
+    args[idx] = 0.03 * (float)(idx % 41) - 0.6;
+  }
+  simd_obj_func_t objectives[] = {opt_simd_sum_of_squares, opt_simd_rosenbrock};
+  size_t unrolls[] = {4, 8};
+  // fewer vectors than accumulators, remainders and masked tails
+  size_t dims[] = {2, 9, 24, 33, 64, 71, 200, 1027};
+  for(size_t obj = 0; obj < 2; obj++) {
+    cr_expect_eq(opt_simd_unrolled(objectives[obj], 1), objectives[obj],
+                 "one accumulator should be the generic objective %ld", obj);
+    for(size_t unroll = 0; unroll < 2; unroll++) {
+      simd_obj_func_t unrolled = opt_simd_unrolled(objectives[obj], unrolls[unroll]);
+      cr_expect_neq(unrolled, objectives[obj], "objective %ld should have %ld accumulators",
+                    obj, unrolls[unroll]);
+      for(size_t test = 0; test < sizeof(dims) / sizeof(dims[0]); test++) {
+        const size_t dim = dims[test];
+        const float ref = objectives[obj](simd_args, dim);
+        cr_expect_float_eq(unrolled(simd_args, dim), ref, 1e-5 * ref,
+                           "objective %ld with %ld accumulators should match on dim %ld",
+                           obj, unrolls[unroll], dim);
+      }
+    }
+  }
+  for(size_t obj = 0; obj < sizeof(objectives) / sizeof(objectives[0]); obj++) {
+    size_t factor = opt_simd_unroll_factor(objectives[obj], 4096);
+    cr_expect(factor == 1 || factor == 4 || factor == 8, "unroll factor should be 1, 4 or 8, not %ld", factor);
+  }
+  cr_expect_eq(opt_simd_unroll_factor(opt_simd_rastigrin, 4096), 1,
+               "an objective without unrolled variants should have one accumulator");
+}
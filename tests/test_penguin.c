@@ -1,10 +1,27 @@
+// mkdtemp, setenv and the directory listing of the rotation cache tests
+#define _POSIX_C_SOURCE 200809L
+
 #include <criterion/criterion.h>
+#include <dirent.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
 
 #include "float.h"
 #include "math.h"
 #include "objectives.h"
 #include "penguin.h"
 
+/**
+   Keep the rotation matrices of the tests out of the user's cache, the cache tests point
+   FASTCODE_CACHE_DIR at a temporary directory of their own.
+ */
+static void disable_rotation_cache(void) {
+  setenv("FASTCODE_CACHE_DIR", "", 1);
+}
+
+TestSuite(penguin_unit, .init = disable_rotation_cache);
+
 Test(macro_tests, min_and_max) {
   cr_expect_eq(0, pen_min(0, 10), "minimum macro 1");
   cr_expect_eq(-10, pen_min(0.0, -10), "minimum macro 2");
@@ -17,7 +34,9 @@ Test(penguin_unit, initialise_population) {
   float max = 100.0;
   float min = -100.0;
   float population[100 * 4];
-  pen_initialise_population(population, 100, 4, min, max);
+  rng_t rng;
+  rng_seed(&rng, 100);
+  pen_initialise_population(&rng, population, 100, 4, min, max);
   for (size_t idx = 0; idx < 4 * 100; idx++) {
     cr_expect_leq(population[idx], 100.0,
                   "dimension of penguin %ld should be upper bound", idx);
@@ -80,13 +99,16 @@ Test(penguin_unit, mutate) {
   size_t dim = 4;
   float mutation_coef = 0.0;
   float expected[] = {0.0, 0.0, 0.0, 0.0};
-  pen_mutate(dim, original, mutation_coef);
+  float noise[4];
+  rng_t rng;
+  rng_seed(&rng, 100);
+  pen_mutate(&rng, dim, original, mutation_coef, noise);
   for(size_t idx = 0; idx < dim; idx++) {
     cr_expect_float_eq(original[idx], expected[idx], FLT_EPSILON,
                        "no mutation should happen at index %ld", idx);
   }
   mutation_coef = 1.0;
-  pen_mutate(dim, original, 1.0);
+  pen_mutate(&rng, dim, original, 1.0, noise);
   for (size_t idx = 0; idx < 4; idx++) {
     cr_expect_gt(original[idx], -1.0 * mutation_coef,
                  "permuted value should be lower bound at index %ld", idx);
@@ -99,7 +121,7 @@ Test(penguin_unit, mutate) {
   original[2] = 0.0;
   original[3] = 0.5;
   mutation_coef = 0.5;
-  pen_mutate(dim, original, mutation_coef);
+  pen_mutate(&rng, dim, original, mutation_coef, noise);
   cr_expect_float_eq(original[0], 10.0, 0.5, "first dimension out of bounds");
   cr_expect_float_eq(original[1], -10.0, 0.5, "second dimension out of bounds");
   cr_expect_float_eq(original[2], 0.0, 0.5, "third dimension out of bounds");
@@ -131,3 +153,215 @@ Test(penguin_unit, attractiveness) {
                "attractiveness should scale inverse exponentially with attenuation \
                 coefficient");
 }
+
+typedef void (*attractiveness_matrix_t)(float*, size_t, size_t, const float*, float*,
+                                        float, float);
+
+/**
+   Compare `matrix_func` with `pen_attractiveness` for every pair of a colony with two
+   identical penguins, whose distance from the Gram matrix must be clamped to 0.
+ */
+static void check_attractiveness_matrix(attractiveness_matrix_t matrix_func) {
+  const size_t colony_size = 9, dim = 11;
+  const float heat_rad = 2.3, attenuation_coef = 0.3;
+  float population[colony_size * dim], population_t[dim * colony_size];
+  float attract[colony_size * colony_size];
+  rng_t rng;
+  rng_seed(&rng, 42);
+  rng_uniform(&rng, population, colony_size * dim, -5.0, 5.0);
+  memcpy(&population[8 * dim], &population[3 * dim], dim * sizeof(float));
+
+  matrix_func(attract, colony_size, dim, population, population_t, heat_rad, attenuation_coef);
+  for (size_t i = 0; i < colony_size; i++) {
+    for (size_t j = 0; j < colony_size; j++) {
+      const float expected = pen_attractiveness(heat_rad, dim, &population[i * dim],
+                                                &population[j * dim], attenuation_coef);
+      cr_expect_float_eq(attract[i * colony_size + j], expected, 1e-3 * expected,
+                         "attractiveness of penguins %ld and %ld", i, j);
+    }
+  }
+  cr_expect_float_eq(attract[3 * colony_size + 8], heat_rad, 1e-3 * heat_rad,
+                     "identical penguins should attract with the full heat radiation");
+}
+
+Test(penguin_unit, attractiveness_matrix) {
+  check_attractiveness_matrix(pen_attractiveness_matrix_scalar);
+}
+
+Test(penguin_unit, attractiveness_matrix_simd) {
+  if (!__builtin_cpu_supports("avx2") || !__builtin_cpu_supports("fma")) {
+    cr_skip_test();
+  }
+  check_attractiveness_matrix(pen_attractiveness_matrix_simd);
+}
+
+
+Test(penguin_unit, rotated_spiral_movement) {
+  const size_t dim = 11, colony_size = 6;
+  float population[colony_size * dim];
+  rng_t rng;
+  rng_seed(&rng, 100);
+  pen_initialise_population(&rng, population, colony_size, dim, -5.0, 5.0);
+
+  float r_matrix[dim * dim], r_matrix_t[dim * dim], rotated[colony_size * dim];
+  pen_init_rotation_matrix(r_matrix, dim, B);
+  transpose(dim, dim, r_matrix, r_matrix_t);
+  pen_rotate_population(rotated, colony_size, dim, population, r_matrix_t);
+
+  for (size_t centre = 0; centre < colony_size; centre++) {
+    for (size_t penguin = 0; penguin < colony_size; penguin++) {
+      float expected[dim], spiral[dim];
+      pen_get_spiral_like_movement(expected, 0.7, dim, &population[centre * dim],
+                                   &population[penguin * dim], r_matrix);
+      pen_get_rotated_spiral_movement(spiral, 0.7, dim, &rotated[centre * dim],
+                                      &rotated[penguin * dim]);
+      for (size_t idx = 0; idx < dim; idx++) {
+        cr_expect_float_eq(spiral[idx], expected[idx], 1e-5,
+                           "spiral of penguin %ld towards %ld should match at %ld",
+                           penguin, centre, idx);
+      }
+    }
+  }
+}
+
+Test(penguin_unit, mean_position) {
+  const float position_sum[4] = {3.0, -6.0, 1.5, 0.0};
+  float position[4];
+  pen_mean_position(position, 4, position_sum, 3);
+  const float expected[4] = {1.0, -2.0, 0.5, 0.0};
+  for (size_t idx = 0; idx < 4; idx++) {
+    cr_expect_float_eq(position[idx], expected[idx], FLT_EPSILON,
+                       "mean of the moves should match at %ld", idx);
+  }
+}
+
+/**
+   The rotation matrix as a product of full Givens rotation matrices.
+ */
+static void reference_rotation_matrix(float* const matrix, size_t dim, const float theta) {
+  float tmp[dim * dim], basic_rotation[dim * dim];
+  identity(dim, matrix);
+  for (size_t idx = 0; idx < dim - 1; idx++) {
+    for (size_t runner = idx + 1; runner < dim; runner++) {
+      identity(dim, basic_rotation);
+      basic_rotation[idx * dim + idx] = cos(theta);
+      basic_rotation[idx * dim + runner] = -sin(theta);
+      basic_rotation[runner * dim + idx] = sin(theta);
+      basic_rotation[runner * dim + runner] = cos(theta);
+      negate(dim * dim, basic_rotation);
+      memcpy(tmp, matrix, sizeof(tmp));
+      mmm(dim, tmp, basic_rotation, matrix);
+    }
+  }
+  scalar_mul(dim * dim, A, matrix);
+}
+
+/**
+   Remove the files of the rotation cache test directory `dir` and the directory itself.
+   Returns the count of removed files.
+ */
+static size_t remove_cache_dir(const char* const dir) {
+  size_t removed = 0;
+  DIR* const listing = opendir(dir);
+  for (struct dirent* entry = readdir(listing); entry; entry = readdir(listing)) {
+    if (entry->d_name[0] != '.') {
+      char path[512];
+      snprintf(path, sizeof(path), "%s/%s", dir, entry->d_name);
+      removed += remove(path) == 0;
+    }
+  }
+  closedir(listing);
+  rmdir(dir);
+  return removed;
+}
+
+Test(penguin_unit, rotation_matrix) {
+  const size_t dims[] = {2, 3, 8, 13};
+  for (size_t run = 0; run < sizeof(dims) / sizeof(dims[0]); run++) {
+    const size_t dim = dims[run];
+    float matrix[dim * dim], expected[dim * dim];
+    pen_init_rotation_matrix(matrix, dim, B);
+    reference_rotation_matrix(expected, dim, B);
+    for (size_t idx = 0; idx < dim * dim; idx++) {
+      cr_expect_float_eq(matrix[idx], expected[idx], 1e-6,
+                         "rotation of dimension %ld should match at %ld", dim, idx);
+    }
+  }
+}
+
+Test(penguin_unit, rotation_matrix_cache) {
+  char dir[] = "/tmp/pen_rotation_XXXXXX";
+  cr_assert(mkdtemp(dir) != NULL, "should create the cache directory");
+  setenv("FASTCODE_CACHE_DIR", dir, 1);
+
+  const size_t dim = 9;
+  float built[dim * dim], loaded[dim * dim], other[dim * dim];
+  pen_init_rotation_matrix(built, dim, B);
+  pen_init_rotation_matrix(loaded, dim, B);
+  cr_expect_eq(memcmp(built, loaded, sizeof(built)), 0, "cached rotation should be unchanged");
+
+  // another key must not be served the cached matrix
+  pen_init_rotation_matrix(other, dim, -B);
+  cr_expect_neq(memcmp(built, other, sizeof(built)), 0, "theta should be part of the key");
+
+  disable_rotation_cache();
+  cr_expect_eq(remove_cache_dir(dir), 2, "one file should be cached per key");
+}
+
+Test(penguin_unit, rotation_matrix_cache_parents) {
+  char dir[] = "/tmp/pen_rotation_XXXXXX";
+  cr_assert(mkdtemp(dir) != NULL, "should create the cache directory");
+  char parent[64], nested[64];
+  snprintf(parent, sizeof(parent), "%s/missing", dir);
+  snprintf(nested, sizeof(nested), "%s/missing/fastcode", dir);
+  setenv("FASTCODE_CACHE_DIR", nested, 1);
+
+  const size_t dim = 5;
+  float matrix[dim * dim];
+  pen_init_rotation_matrix(matrix, dim, B);
+
+  disable_rotation_cache();
+  cr_expect_eq(remove_cache_dir(nested), 1, "missing parents of the cache should be created");
+  rmdir(parent);
+  cr_expect_eq(rmdir(dir), 0, "the cache should leave nothing else behind");
+}
+
+Test(penguin_unit, rank_colony) {
+  const size_t colony_size = 7;
+  const float fitness[] = {3.0, 1.0, NAN, 1.0, 2.0, 5.0, 2.0};
+  pen_rank_t ranks[colony_size];
+  size_t n_better[colony_size];
+  pen_rank_colony(ranks, n_better, colony_size, fitness);
+
+  const size_t expected_order[] = {1, 3, 4, 6, 0, 5, 2};
+  const size_t expected_better[] = {0, 0, 2, 2, 4, 5, 0};
+  for (size_t rank = 0; rank < colony_size; rank++) {
+    cr_expect_eq(ranks[rank].idx, expected_order[rank], "penguin at rank %ld", rank);
+    cr_expect_eq(n_better[rank], expected_better[rank], "better penguins of rank %ld", rank);
+    // the prefix holds exactly the strictly better penguins
+    for (size_t other = 0; other < colony_size; other++) {
+      const size_t penguin = ranks[other].idx;
+      cr_expect_eq(other < n_better[rank], fitness[ranks[rank].idx] > fitness[penguin],
+                   "penguin %ld in the prefix of rank %ld", penguin, rank);
+    }
+  }
+}
+
+Test(penguin_unit, parallel_reproducible) {
+  const size_t colony_size = 37, dim = 5;
+  float* first = pen_emperor_penguin_parallel(sum_of_squares, colony_size, dim, 10, -5.0, 5.0, 3);
+  float* second = pen_emperor_penguin_parallel(sum_of_squares, colony_size, dim, 10, -5.0, 5.0, 3);
+  cr_expect_eq(memcmp(first, second, dim * sizeof(float)), 0,
+               "runs on the same number of threads should be equal");
+  free(first);
+  free(second);
+}
+
+Test(penguin_unit, parallel_converges) {
+  // the threads move disjoint ranks of one shared colony, it must still converge
+  const size_t dim = 2;
+  float* solution = pen_emperor_penguin_parallel(sum_of_squares, 50, dim, 100, -5.0, 5.0, 3);
+  cr_expect_lt(sum_of_squares(solution, dim), 1e-3, "3 threads should find the minimum, got %f",
+               sum_of_squares(solution, dim));
+  free(solution);
+}
@@ -7,21 +7,26 @@ BASIC PSO UNIT TESTS
 
 #include "objectives.h"
 #include "pso.h"
+#include "pso_aosoa.h"
+#include "pso_fused.h"
+#include "pso_kernels.h"
 #include "utils.h"
 
 #include <criterion/criterion.h>
 
 
 Test(pso_unit, pso_rand_init) {
-  seed_simd_rng(100);
+  simd_rng_t rng;
+  seed_simd_rng(&rng, 1, 100);
   float min = 0.0;
   float max = 1.0;
-  initialise_velocity_bounds(min, max);
-  initialise_position_bounds(min, max);
+  pso_bounds_t bounds;
+  initialise_velocity_bounds(&bounds, min, max);
+  initialise_position_bounds(&bounds, min, max);
   size_t swarm_size = 16;
   size_t dim = 8;
   __m256 pos[swarm_size * dim / 8];
-  pso_rand_init(pos, swarm_size * dim / 8);
+  pso_rand_init(&rng, &bounds, pos, swarm_size * dim / 8);
   for(size_t s = 0; s < swarm_size * dim / 8; s++) {
     float tmp[8];
     _mm256_storeu_ps(tmp, pos[s]);
@@ -69,11 +74,13 @@ Test(pso_unit, pso_eval_fitness) {
 
 Test(pso_unit, pso_gen_init_velocity) {
   cr_skip_test();
-  seed_simd_rng(100);
+  simd_rng_t rng;
+  seed_simd_rng(&rng, 1, 100);
   float min = 0.0;
   float max = 1.0;
-  initialise_velocity_bounds(min, max);
-  initialise_position_bounds(min, max);
+  pso_bounds_t bounds;
+  initialise_velocity_bounds(&bounds, min, max);
+  initialise_position_bounds(&bounds, min, max);
 
   size_t swarm_size = 8;
   size_t dim = 8;
@@ -82,9 +89,9 @@ Test(pso_unit, pso_gen_init_velocity) {
   float max_vel[] = {1.0, 1.0, 3.0, 25.0, 10.0, 10.0, 10.0, 10.0};
 
   __m256 x[swarm_size * simd_dim];
-  pso_rand_init(x, swarm_size * simd_dim);
+  pso_rand_init(&rng, &bounds, x, swarm_size * simd_dim);
   __m256 vel[swarm_size * simd_dim];
-  pso_gen_init_velocity(vel, x, swarm_size, simd_dim);
+  pso_gen_init_velocity(&rng, &bounds, vel, x, swarm_size, simd_dim);
   for(size_t s = 0; s < swarm_size; s++) {
     for(size_t d = 0; d < simd_dim; d++) {
       size_t idx = s * simd_dim + d;
@@ -102,6 +109,297 @@ Test(pso_unit, pso_gen_init_velocity) {
   }
 }
 
+Test(pso_unit, seed_simd_rng_streams) {
+  simd_rng_t rngs[4];
+  seed_simd_rng(rngs, 4, 100);
+  pso_bounds_t bounds;
+  initialise_position_bounds(&bounds, 0.0, 1.0);
+  __m256 first;
+  pso_rand_init(&rngs[0], &bounds, &first, 1);
+  for(size_t stream = 1; stream < 4; stream++) {
+    __m256 a = first;
+    __m256 b;
+    pso_rand_init(&rngs[stream], &bounds, &b, 1);
+    int equal = _mm256_movemask_ps(_mm256_cmp_ps(a, b, _CMP_EQ_OQ));
+    cr_expect_neq(equal, 0xff, "stream %ld should differ from stream 0", stream);
+  }
+}
+
+Test(pso_unit, simd_rand_fill_chains) {
+  simd_rng_t serial, interleaved;
+  seed_simd_rng(&serial, 1, 100);
+  seed_simd_rng(&interleaved, 1, 100);
+
+  // one chain is the same as drawing vector by vector
+  __m256 out[13];
+  simd_rand_fill(&interleaved, out, 13, 1);
+  for(size_t idx = 0; idx < 13; idx++) {
+    __m256 expected = simd_rand_0_to_1(&serial);
+    cr_expect_eq(_mm256_movemask_ps(_mm256_cmp_ps(out[idx], expected, _CMP_EQ_OQ)), 0xff,
+                 "vector %ld should match simd_rand_0_to_1", idx);
+  }
+
+  size_t chains[] = {2, 4};
+  for(size_t test = 0; test < 2; test++) {
+    simd_rand_fill(&interleaved, out, 13, chains[test]);
+    for(size_t idx = 0; idx < 13; idx++) {
+      float values[8];
+      _mm256_storeu_ps(values, out[idx]);
+      for(size_t lane = 0; lane < 8; lane++) {
+        cr_expect(values[lane] >= 0 && values[lane] <= 1, "%ld chains should draw in [0, 1]",
+                  chains[test]);
+      }
+    }
+    // the second chain does not repeat the first one
+    cr_expect_neq(_mm256_movemask_ps(_mm256_cmp_ps(out[0], out[1], _CMP_EQ_OQ)), 0xff,
+                  "%ld chains should be independent", chains[test]);
+  }
+}
+
+Test(pso_unit, pso_ctx_step_composes) {
+  pso_ctx_t *once = pso_create(opt_simd_sum_of_squares, 16, 16, -10, 10, 1, 7);
+  pso_ctx_t *twice = pso_create(opt_simd_sum_of_squares, 16, 16, -10, 10, 1, 7);
+  pso_step(once, 20);
+  pso_step(twice, 10);
+  pso_step(twice, 10);
+
+  float solution_once[16];
+  float solution_twice[16];
+  float fitness_once = pso_result(once, solution_once);
+  float fitness_twice = pso_result(twice, solution_twice);
+  cr_expect_eq(fitness_once, fitness_twice, "splitting the steps should not change the fitness");
+  for(size_t idx = 0; idx < 16; idx++) {
+    cr_expect_eq(solution_once[idx], solution_twice[idx],
+                 "splitting the steps should not change dimension %ld", idx);
+  }
+  pso_destroy(once);
+  pso_destroy(twice);
+}
+
+Test(pso_unit, pso_ctx_concurrent_solves) {
+  const size_t n_solves = 4;
+  float sequential[n_solves];
+  float concurrent[n_solves];
+  float solution[8];
+  for(size_t solve = 0; solve < n_solves; solve++) {
+    pso_ctx_t *ctx = pso_create(opt_simd_sum_of_squares, 32, 8, -10, 10, 1, solve);
+    pso_step(ctx, 50);
+    sequential[solve] = pso_result(ctx, solution);
+    pso_destroy(ctx);
+  }
+
+  #pragma omp parallel for num_threads(n_solves)
+  for(size_t solve = 0; solve < n_solves; solve++) {
+    float own_solution[8];
+    pso_ctx_t *ctx = pso_create(opt_simd_sum_of_squares, 32, 8, -10, 10, 1, solve);
+    pso_step(ctx, 50);
+    concurrent[solve] = pso_result(ctx, own_solution);
+    pso_destroy(ctx);
+  }
+
+  for(size_t solve = 0; solve < n_solves; solve++) {
+    cr_expect_eq(sequential[solve], concurrent[solve],
+                 "solve %ld should not be affected by the other solves", solve);
+  }
+}
+
+Test(pso_unit, pso_transpose_block) {
+  const size_t n_particles = 5;
+  const size_t simd_dim = 2;
+  float rows[5 * 16];
+  for(size_t idx = 0; idx < n_particles * 16; idx++) {
+    rows[idx] = (float)idx;
+  }
+  __m256 positions[5 * 2];
+  for(size_t idx = 0; idx < n_particles * simd_dim; idx++) {
+    positions[idx] = _mm256_loadu_ps(&rows[idx * 8]);
+  }
+  __m256 lanes[16];
+  pso_transpose_block(positions, n_particles, simd_dim, lanes);
+  for(size_t d = 0; d < 16; d++) {
+    float column[8];
+    _mm256_storeu_ps(column, lanes[d]);
+    for(size_t p = 0; p < 8; p++) {
+      float expected = p < n_particles ? rows[p * 16 + d] : 0.0;
+      cr_expect_eq(column[p], expected, "lane %ld of dimension %ld should be particle %ld", p, d, p);
+    }
+  }
+}
+
+Test(pso_unit, pso_aosoa_block_sizes) {
+  // the random draws do not depend on the block size, so neither does the solve
+  const size_t dim = 37;
+  float reference[37];
+  pso_aosoa_ctx_t *ctx = pso_aosoa_create(opt_simd_rosenbrock, 20, dim, -5, 5, 1, 1, 3);
+  pso_aosoa_step(ctx, 30);
+  float reference_fitness = pso_aosoa_result(ctx, reference);
+  pso_aosoa_destroy(ctx);
+
+  size_t block_sizes[] = {2, 3, 5, 8};
+  for(size_t test = 0; test < sizeof(block_sizes) / sizeof(block_sizes[0]); test++) {
+    float solution[37];
+    ctx = pso_aosoa_create(opt_simd_rosenbrock, 20, dim, -5, 5, block_sizes[test], 1, 3);
+    pso_aosoa_step(ctx, 30);
+    cr_expect_eq(pso_aosoa_result(ctx, solution), reference_fitness,
+                 "block size %ld should not change the fitness", block_sizes[test]);
+    for(size_t idx = 0; idx < dim; idx++) {
+      cr_expect_eq(solution[idx], reference[idx],
+                   "block size %ld should not change dimension %ld", block_sizes[test], idx);
+    }
+    pso_aosoa_destroy(ctx);
+  }
+}
+
+Test(pso_unit, pso_tile_vectors) {
+  cr_expect_eq(pso_tile_vectors(32 * 1024, 0), 64, "a quarter of a 32KB L1 holds 4 tiles of 64 vectors");
+  cr_expect_eq(pso_tile_vectors(48 * 1024, 2048 * 1024), 96, "the L1 size sets the tile");
+  cr_expect_eq(pso_tile_vectors(0, 1024 * 1024), 256, "the L2 size is used without L1 size");
+  cr_expect_eq(pso_tile_vectors(0, 0), 64, "unknown caches fall back to a 32KB L1");
+  cr_expect_eq(pso_tile_vectors(100, 0), 8, "tiles hold at least 8 vectors");
+}
+
+Test(pso_unit, pso_tiled_step) {
+  // the random draws do not depend on the tiles, only the order of the fitness sums does
+  const size_t dim = 37;
+  float reference[37];
+  pso_ctx_t *ctx = pso_create(opt_simd_rosenbrock, 20, dim, -5, 5, 1, 3);
+  pso_step(ctx, 1);
+  float reference_fitness = pso_result(ctx, reference);
+  pso_destroy(ctx);
+
+  size_t tile_sizes[] = {1, 2, 3, 8};
+  for(size_t test = 0; test < sizeof(tile_sizes) / sizeof(tile_sizes[0]); test++) {
+    float solution[37];
+    ctx = pso_create(opt_simd_rosenbrock, 20, dim, -5, 5, 1, 3);
+    pso_use_tiled_objective(ctx, opt_simd_tile_variant(opt_simd_rosenbrock), tile_sizes[test]);
+    pso_step(ctx, 1);
+    float fitness = pso_result(ctx, solution);
+    cr_expect(fabsf(fitness - reference_fitness) <= 1e-5 * reference_fitness,
+              "tile size %ld should give fitness %f, not %f", tile_sizes[test],
+              reference_fitness, fitness);
+    for(size_t idx = 0; idx < dim; idx++) {
+      cr_expect_eq(solution[idx], reference[idx],
+                   "tile size %ld should not change dimension %ld", tile_sizes[test], idx);
+    }
+    pso_destroy(ctx);
+  }
+}
+
+Test(pso_unit, pso_fused_step) {
+  // the fused update moves the particles exactly like the generic one
+  simd_obj_func_t objectives[] = {opt_simd_sum_of_squares, opt_simd_rosenbrock};
+  size_t dims[] = {33, 37, 40};
+  for(size_t obj = 0; obj < 2; obj++) {
+    for(size_t test = 0; test < sizeof(dims) / sizeof(dims[0]); test++) {
+      const size_t dim = dims[test];
+      float reference[40], solution[40];
+      pso_ctx_t *ctx = pso_create(objectives[obj], 20, dim, -5, 5, 1, 3);
+      pso_step(ctx, 1);
+      float reference_fitness = pso_result(ctx, reference);
+      pso_destroy(ctx);
+
+      ctx = pso_create(objectives[obj], 20, dim, -5, 5, 1, 3);
+      cr_assert(pso_fused_update(objectives[obj]), "objective %ld should have a fused update", obj);
+      pso_use_update(ctx, pso_fused_update(objectives[obj]));
+      pso_step(ctx, 1);
+      float fitness = pso_result(ctx, solution);
+      cr_expect(fabsf(fitness - reference_fitness) <= 1e-5 * reference_fitness,
+                "objective %ld dim %ld should give fitness %f, not %f", obj, dim,
+                reference_fitness, fitness);
+      for(size_t idx = 0; idx < dim; idx++) {
+        cr_expect_eq(solution[idx], reference[idx],
+                     "objective %ld dim %ld should not change dimension %ld", obj, dim, idx);
+      }
+      pso_destroy(ctx);
+    }
+  }
+}
+
+Test(pso_unit, pso_fused_step_fixed_dim) {
+  // the fused update with a fixed number of vectors moves the particles like the generic one
+  simd_obj_func_t objectives[] = {opt_simd_sum_of_squares, opt_simd_rosenbrock};
+  size_t dims[] = {8, 16, 32};
+  for(size_t obj = 0; obj < 2; obj++) {
+    for(size_t test = 0; test < sizeof(dims) / sizeof(dims[0]); test++) {
+      const size_t dim = dims[test];
+      float reference[32], solution[32];
+      pso_ctx_t *ctx = pso_create(objectives[obj], 20, dim, -5, 5, 1, 3);
+      pso_use_update(ctx, pso_fused_update(objectives[obj]));
+      pso_step(ctx, 1);
+      float reference_fitness = pso_result(ctx, reference);
+      pso_destroy(ctx);
+
+      ctx = pso_create(objectives[obj], 20, dim, -5, 5, 1, 3);
+      cr_assert(pso_fused_update_dim(objectives[obj], dim) != pso_fused_update(objectives[obj]),
+                "objective %ld should have an update specialised on dim %ld", obj, dim);
+      pso_use_update(ctx, pso_fused_update_dim(objectives[obj], dim));
+      pso_step(ctx, 1);
+      float fitness = pso_result(ctx, solution);
+      cr_expect(fabsf(fitness - reference_fitness) <= 1e-5 * reference_fitness,
+                "objective %ld dim %ld should give fitness %f, not %f", obj, dim,
+                reference_fitness, fitness);
+      for(size_t idx = 0; idx < dim; idx++) {
+        cr_expect_eq(solution[idx], reference[idx],
+                     "objective %ld dim %ld should not change dimension %ld", obj, dim, idx);
+      }
+      pso_destroy(ctx);
+    }
+  }
+}
+
+Test(pso_unit, simd_philox4x32) {
+  // known answers of the Random123 reference implementation, one per lane
+  const uint32_t counters[3][4] = {{0, 0, 0, 0},
+                                   {0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff},
+                                   {0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344}};
+  const uint64_t keys[3] = {0, 0xffffffffffffffff, 0x299f31d0a4093822};
+  const uint32_t expected[3][4] = {{0x6627e8d5, 0xe169c58d, 0xbc57ac4c, 0x9b00dbd8},
+                                   {0x408f276d, 0x41c83b0e, 0xa20bc7c6, 0x6d5451fd},
+                                   {0xd16cfe09, 0x94fdcceb, 0x5001e420, 0x24126ea1}};
+  for(size_t test = 0; test < 3; test++) {
+    __m256i ctr[4];
+    for(size_t word = 0; word < 4; word++) {
+      ctr[word] = _mm256_set1_epi32((int)counters[test][word]);
+    }
+    simd_philox4x32(ctr, keys[test]);
+    for(size_t word = 0; word < 4; word++) {
+      uint32_t lanes[8];
+      _mm256_storeu_si256((__m256i*)lanes, ctr[word]);
+      for(size_t lane = 0; lane < 8; lane++) {
+        cr_expect_eq(lanes[lane], expected[test][word], "test %ld word %ld lane %ld should be %x, not %x",
+                     test, word, lane, expected[test][word], lanes[lane]);
+      }
+    }
+  }
+}
+
+Test(pso_unit, pso_counter_rng_thread_counts) {
+  // with counter based draws the thread count does not change a single bit
+  const size_t dim = 21;
+  float reference[21];
+  pso_ctx_t *ctx = pso_create(opt_simd_rosenbrock, 50, dim, -5, 5, 1, 7);
+  pso_use_counter_rng(ctx, 1);
+  pso_step(ctx, 20);
+  float reference_fitness = pso_result(ctx, reference);
+  pso_destroy(ctx);
+
+  size_t thread_counts[] = {2, 3, 8};
+  for(size_t test = 0; test < sizeof(thread_counts) / sizeof(thread_counts[0]); test++) {
+    float solution[21];
+    ctx = pso_create(opt_simd_rosenbrock, 50, dim, -5, 5, thread_counts[test], 7);
+    pso_use_counter_rng(ctx, 1);
+    pso_step(ctx, 5);
+    pso_step(ctx, 15);
+    cr_expect_eq(pso_result(ctx, solution), reference_fitness,
+                 "%ld threads should not change the fitness", thread_counts[test]);
+    for(size_t idx = 0; idx < dim; idx++) {
+      cr_expect_eq(solution[idx], reference[idx],
+                   "%ld threads should not change dimension %ld", thread_counts[test], idx);
+    }
+    pso_destroy(ctx);
+  }
+}
+
 /* Test(pso_unit, pso_best_fitness) { */
 /*   size_t swarm_size,dim; */
 /*   swarm_size = 4; */
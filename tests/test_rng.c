@@ -0,0 +1,103 @@
+#include <math.h>
+#include <string.h>
+
+#include "rng.h"
+
+#include <criterion/criterion.h>
+
+
+Test(rng_unit, uniform_bounds_and_mean) {
+  const size_t n = 10000;
+  float rands[n];
+  rng_t rng;
+  rng_seed(&rng, 100);
+  rng_uniform(&rng, rands, n, -5.0, 3.0);
+  double sum = 0.0;
+  for(size_t idx = 0; idx < n; idx++) {
+    cr_expect_geq(rands[idx], -5.0, "random number %ld should be bound below", idx);
+    cr_expect_lt(rands[idx], 3.0, "random number %ld should be bound above", idx);
+    sum += rands[idx];
+  }
+  cr_expect_float_eq(sum / n, -1.0, 0.1, "mean should be halfway between the bounds");
+}
+
+Test(rng_unit, seeding) {
+  rng_t first, second, other;
+  rng_seed(&first, 7);
+  rng_seed(&second, 7);
+  rng_seed(&other, 8);
+  float a[100], b[100], c[100];
+  rng_uniform(&first, a, 100, 0.0, 1.0);
+  rng_uniform(&second, b, 100, 0.0, 1.0);
+  rng_uniform(&other, c, 100, 0.0, 1.0);
+  cr_expect_eq(memcmp(a, b, sizeof(a)), 0, "equal seeds should give equal streams");
+  cr_expect_neq(memcmp(a, c, sizeof(a)), 0, "different seeds should give different streams");
+}
+
+Test(rng_unit, scalar_matches_avx2) {
+  if(!__builtin_cpu_supports("avx2") || !__builtin_cpu_supports("fma")) {
+    cr_skip_test();
+  }
+  rng_t rng;
+  rng_seed(&rng, 100);
+  uint64_t scalar_state[RNG_STATE_WORDS], avx2_state[RNG_STATE_WORDS];
+  memcpy(scalar_state, rng.state, sizeof(scalar_state));
+  memcpy(avx2_state, rng.state, sizeof(avx2_state));
+
+  float scalar[3 * RNG_ROUND], avx2[3 * RNG_ROUND];
+  rng_fill_rounds_scalar(scalar_state, scalar, 3, -2.5, 7.0);
+  rng_fill_rounds_avx2(avx2_state, avx2, 3, -2.5, 7.0);
+  cr_expect_eq(memcmp(scalar, avx2, sizeof(scalar)), 0, "both paths should give the same floats");
+  cr_expect_eq(memcmp(scalar_state, avx2_state, sizeof(scalar_state)), 0,
+               "both paths should leave the same state");
+}
+
+Test(rng_unit, single_draws_match_fills) {
+  rng_t bulk, single;
+  rng_seed(&bulk, 3);
+  rng_seed(&single, 3);
+  // sizes crossing the buffer and whole rounds in every way
+  const size_t sizes[] = {5, 70, 1, 31, 64, 29};
+  for(size_t size = 0; size < sizeof(sizes) / sizeof(sizes[0]); size++) {
+    float rands[70];
+    rng_uniform(&bulk, rands, sizes[size], 0.0, 1.0);
+    for(size_t idx = 0; idx < sizes[size]; idx++) {
+      cr_expect_eq(rands[idx], rng_0_to_1(&single),
+                   "fill %ld should match the single draws at index %ld", size, idx);
+    }
+  }
+}
+
+Test(rng_unit, normal_moments) {
+  const size_t n = 20001;
+  float rands[n];
+  rng_t rng;
+  rng_seed(&rng, 100);
+  rng_normal(&rng, rands, n, 2.0, 3.0);
+  double sum = 0.0, sum_sq = 0.0;
+  for(size_t idx = 0; idx < n; idx++) {
+    cr_assert(isfinite(rands[idx]), "normal number %ld should be finite", idx);
+    sum += rands[idx];
+    sum_sq += rands[idx] * rands[idx];
+  }
+  const double mean = sum / n;
+  cr_expect_float_eq(mean, 2.0, 0.1, "mean should be 2, got %f", mean);
+  cr_expect_float_eq(sum_sq / n - mean * mean, 9.0, 0.4, "variance should be 9");
+}
+
+Test(rng_unit, levy_heavy_tail) {
+  const size_t n = 10000;
+  float rands[n];
+  rng_t rng;
+  rng_seed(&rng, 100);
+  rng_levy(&rng, rands, n, 1.5);
+  size_t negative = 0;
+  float largest = 0.0;
+  for(size_t idx = 0; idx < n; idx++) {
+    cr_assert(isfinite(rands[idx]), "levy step %ld should be finite", idx);
+    negative += rands[idx] < 0;
+    largest = fabsf(rands[idx]) > largest ? fabsf(rands[idx]) : largest;
+  }
+  cr_expect_float_eq((float)negative / n, 0.5, 0.05, "steps should be symmetric");
+  cr_expect_gt(largest, 10.0, "steps should be heavy tailed, the largest is %f", largest);
+}
@@ -0,0 +1,181 @@
+#include <float.h>
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+#include <immintrin.h>
+
+#include "simd_math.h"
+
+#include <criterion/criterion.h>
+
+#ifndef M_PI
+#define M_PI (3.14159265358979323846)
+#endif
+
+
+/**
+   Distance in units in the last place between `res` and `ref`, the number of floats
+   between them.
+ */
+static double ulp_distance(float res, float ref) {
+  if(isnan(res) || isnan(ref)) {
+    return isnan(res) && isnan(ref) ? 0 : INFINITY;
+  }
+  int32_t a, b;
+  memcpy(&a, &res, sizeof(a));
+  memcpy(&b, &ref, sizeof(b));
+  // map the sign magnitude bits onto a monotonic integer line
+  int64_t ia = a < 0 ? (int64_t)INT32_MIN - a : a;
+  int64_t ib = b < 0 ? (int64_t)INT32_MIN - b : b;
+  return fabs((double)(ia - ib));
+}
+
+/**
+   Largest error of `kernel` against `ref` over `n` points from `min` to `max`, in ulp or
+   in units of `abs_floor` if that is less (near the roots of sin and cos, where a tiny
+   absolute error is many ulp of the tiny result).
+ */
+#define MAX_ERROR(kernel, ref, min, max, n, abs_floor) ({                       \
+  double worst = 0.0;                                                           \
+  for(size_t idx = 0; idx < (n); idx += 8) {                                    \
+    float x[8], res[8];                                                         \
+    for(size_t lane = 0; lane < 8; lane++) {                                    \
+      x[lane] = (float)((min) + ((max) - (min)) * (double)(idx + lane) / (n));  \
+    }                                                                           \
+    _mm256_storeu_ps(res, kernel(_mm256_loadu_ps(x)));                          \
+    for(size_t lane = 0; lane < 8; lane++) {                                    \
+      const float expected = (float)ref((double)x[lane]);                      \
+      double err = ulp_distance(res[lane], expected);                           \
+      if((abs_floor) > 0 && fabs((double)res[lane] - expected) / (abs_floor) < err) { \
+        err = fabs((double)res[lane] - expected) / (abs_floor);                 \
+      }                                                                         \
+      worst = err > worst ? err : worst;                                        \
+    }                                                                           \
+  }                                                                             \
+  worst; })
+
+
+// an ulp of 1, the absolute error bound of sin and cos near their roots
+#define ULP_OF_ONE 5.9604644775390625e-8
+
+Test(simd_math_unit, sin_cos) {
+  double err = MAX_ERROR(simd_sin, sin, -10.0, 10.0, 100000, ULP_OF_ONE);
+  cr_expect_leq(err, 2.0, "sin should be within 2 ulp on [-10, 10], got %f", err);
+  err = MAX_ERROR(simd_sin, sin, -8192.0, 8192.0, 1000000, ULP_OF_ONE);
+  cr_expect_leq(err, 2.0, "sin should be within 2 ulp on [-8192, 8192], got %f", err);
+  err = MAX_ERROR(simd_cos, cos, -10.0, 10.0, 100000, ULP_OF_ONE);
+  cr_expect_leq(err, 2.0, "cos should be within 2 ulp on [-10, 10], got %f", err);
+  err = MAX_ERROR(simd_cos, cos, -8192.0, 8192.0, 1000000, ULP_OF_ONE);
+  cr_expect_leq(err, 2.0, "cos should be within 2 ulp on [-8192, 8192], got %f", err);
+}
+
+Test(simd_math_unit, sincos_matches_sin_and_cos) {
+  const __m256 x = _mm256_setr_ps(-3.0, -0.5, 0.0, 0.7, 1.6, 2.4, 3.9, 100.0);
+  __m256 sin_x, cos_x;
+  simd_sincos(x, &sin_x, &cos_x);
+  cr_expect_eq(_mm256_movemask_ps(_mm256_cmp_ps(sin_x, simd_sin(x), _CMP_EQ_OQ)), 0xff,
+               "sincos should give the sine of simd_sin");
+  cr_expect_eq(_mm256_movemask_ps(_mm256_cmp_ps(cos_x, simd_cos(x), _CMP_EQ_OQ)), 0xff,
+               "sincos should give the cosine of simd_cos");
+}
+
+Test(simd_math_unit, exp) {
+  double err = MAX_ERROR(simd_exp, exp, -87.0, 88.5, 1000000, 0.0);
+  cr_expect_leq(err, 2.0, "exp should be within 2 ulp, got %f", err);
+  err = MAX_ERROR(simd_exp, exp, -1.0, 1.0, 100000, 0.0);
+  cr_expect_leq(err, 2.0, "exp should be within 2 ulp on [-1, 1], got %f", err);
+
+  float res[8];
+  _mm256_storeu_ps(res, simd_exp(_mm256_setr_ps(-200.0, -104.0, 89.0, 200.0, INFINITY, -INFINITY, NAN, 0.0)));
+  cr_expect_eq(res[0], 0.0, "exp should underflow to 0");
+  cr_expect_eq(res[1], 0.0, "exp should underflow to 0");
+  cr_expect(isinf(res[2]) && isinf(res[3]) && isinf(res[4]), "exp should overflow to inf");
+  cr_expect_eq(res[5], 0.0, "exp(-inf) should be 0");
+  cr_expect(isnan(res[6]), "exp(NaN) should be NaN");
+  cr_expect_eq(res[7], 1.0, "exp(0) should be 1");
+}
+
+Test(simd_math_unit, log) {
+  double err = MAX_ERROR(simd_log, log, 1e-3, 10.0, 1000000, 0.0);
+  cr_expect_leq(err, 2.0, "log should be within 2 ulp on [1e-3, 10], got %f", err);
+  err = MAX_ERROR(simd_log, log, 1.0, 1e30, 1000000, 0.0);
+  cr_expect_leq(err, 2.0, "log should be within 2 ulp on [1, 1e30], got %f", err);
+  err = MAX_ERROR(simd_log, log, 1e-44, 1e-38, 100000, 0.0);
+  cr_expect_leq(err, 2.0, "log should be within 2 ulp on subnormals, got %f", err);
+
+  float res[8];
+  _mm256_storeu_ps(res, simd_log(_mm256_setr_ps(0.0, -1.0, INFINITY, NAN, 1.0, -0.0, FLT_MAX, 2.0)));
+  cr_expect(isinf(res[0]) && res[0] < 0, "log(0) should be -inf");
+  cr_expect(isnan(res[1]), "log of a negative number should be NaN");
+  cr_expect(isinf(res[2]) && res[2] > 0, "log(inf) should be inf");
+  cr_expect(isnan(res[3]), "log(NaN) should be NaN");
+  cr_expect_eq(res[4], 0.0, "log(1) should be 0");
+  cr_expect(isinf(res[5]) && res[5] < 0, "log(-0) should be -inf");
+  cr_expect(ulp_distance(res[6], logf(FLT_MAX)) <= 2, "log(FLT_MAX) should be finite");
+}
+
+static double pow_neg_12_5(double x) {
+  return pow(x, -12.5);
+}
+
+static inline __m256 simd_pow_neg_12_5(const __m256 x) {
+  return simd_pow(x, _mm256_set1_ps(-12.5));
+}
+
+static double pow_sqrt_pi(double x) {
+  return pow(x, (float)sqrt(M_PI));
+}
+
+static inline __m256 simd_pow_sqrt_pi(const __m256 x) {
+  return simd_pow(x, _mm256_set1_ps((float)sqrt(M_PI)));
+}
+
+Test(simd_math_unit, pow) {
+  double err = MAX_ERROR(simd_pow_sqrt_pi, pow_sqrt_pi, 0.0, 2e7, 1000000, 0.0);
+  cr_expect_leq(err, 2.0, "pow should be within 2 ulp, got %f", err);
+  err = MAX_ERROR(simd_pow_sqrt_pi, pow_sqrt_pi, 0.0, 4.0, 1000000, 0.0);
+  cr_expect_leq(err, 2.0, "pow should be within 2 ulp for small results, got %f", err);
+  // |y * log(x)| up to 86, the exponent must not lose the accuracy
+  err = MAX_ERROR(simd_pow_neg_12_5, pow_neg_12_5, 0.001, 1000.0, 1000000, 0.0);
+  cr_expect_leq(err, 2.0, "pow should be within 2 ulp for large exponents, got %f", err);
+
+  float res[8];
+  _mm256_storeu_ps(res, simd_pow(_mm256_setr_ps(0.0, 0.0, 1.0, 2.0, 4.0, -1.0, 10.0, 0.0),
+                                 _mm256_setr_ps(2.0, 0.0, 7.0, 10.0, 0.5, 2.0, -1.0, -1.0)));
+  cr_expect_eq(res[0], 0.0, "pow(0, 2) should be 0");
+  cr_expect_eq(res[1], 1.0, "pow(0, 0) should be 1");
+  cr_expect_eq(res[2], 1.0, "pow(1, y) should be 1");
+  cr_expect(ulp_distance(res[3], 1024.0) <= 2, "pow(2, 10) should be 1024, got %f", res[3]);
+  cr_expect(ulp_distance(res[4], 2.0) <= 2, "pow(4, 0.5) should be 2, got %f", res[4]);
+  cr_expect(isnan(res[5]), "pow of a negative base should be NaN");
+  cr_expect(ulp_distance(res[6], 0.1f) <= 2, "pow(10, -1) should be 0.1, got %f", res[6]);
+  cr_expect(isinf(res[7]) && res[7] > 0, "pow(0, -1) should be inf");
+}
+
+Test(simd_math_unit, arrays) {
+  // 21 elements test the masked tail
+  float x[21], out[21];
+  for(size_t idx = 0; idx < 21; idx++) {
+    x[idx] = 0.3 * idx + 0.1;
+  }
+  simd_sin_array(x, out, 21);
+  for(size_t idx = 0; idx < 21; idx++) {
+    cr_expect(ulp_distance(out[idx], sinf(x[idx])) <= 2, "sin of element %ld", idx);
+  }
+  simd_cos_array(x, out, 21);
+  for(size_t idx = 0; idx < 21; idx++) {
+    cr_expect(ulp_distance(out[idx], cosf(x[idx])) <= 2, "cos of element %ld", idx);
+  }
+  simd_exp_array(x, out, 21);
+  for(size_t idx = 0; idx < 21; idx++) {
+    cr_expect(ulp_distance(out[idx], expf(x[idx])) <= 2, "exp of element %ld", idx);
+  }
+  simd_log_array(x, out, 21);
+  for(size_t idx = 0; idx < 21; idx++) {
+    cr_expect(ulp_distance(out[idx], logf(x[idx])) <= 2, "log of element %ld", idx);
+  }
+  simd_pow_array(x, 1.5, out, 21);
+  for(size_t idx = 0; idx < 21; idx++) {
+    cr_expect(ulp_distance(out[idx], powf(x[idx], 1.5)) <= 2, "pow of element %ld", idx);
+  }
+}
@@ -4,6 +4,8 @@ BASIC SQUIRREL UNIT TESTS
 
 #include <float.h>
 #include <math.h>
+#include <stdlib.h>
+#include <string.h>
 
 #include "objectives.h"
 #include "squirrel.h"
@@ -140,3 +142,51 @@ Test(squirrel_unit, gamma_function){
   cr_expect_float_eq(val6, 15*SQRT_PI/8, FLT_EPSILON, " gamma(3.5) = 3.323350 ");
   cr_expect_float_eq(val7, -8*SQRT_PI/15, FLT_EPSILON, " gamma(-2.5) = 0.945 ");
 }
+
+static int cmp_float(const void* a, const void* b){
+  const float x = *(const float*)a, y = *(const float*)b;
+  return (x > y) - (x < y);
+}
+
+Test(squirrel_unit, simd_levy_steps){
+  if(!__builtin_cpu_supports("avx2") || !__builtin_cpu_supports("fma")) {
+    cr_skip_test();
+  }
+  // the steps are heavy tailed, compare the medians of their sizes
+  const size_t n_vectors = 4096, n = 8*n_vectors;
+  float* uniforms = malloc(2*n*sizeof(float));
+  float* steps = malloc(n*sizeof(float));
+  float* expected = malloc(n*sizeof(float));
+  rng_t rng;
+  rng_seed(&rng, 7);
+  rng_uniform(&rng, uniforms, 2*n, 0.0, 1.0);
+  rng_levy(&rng, expected, n, BETA);
+
+  sqr_simd_levy_steps(steps, uniforms, n_vectors, rng_levy_sigma(BETA), 1.0/BETA);
+  for (size_t idx = 0; idx < n; idx++){
+    cr_assert(isfinite(steps[idx]), "step %ld should be finite", idx);
+    steps[idx] = fabs(steps[idx]);
+    expected[idx] = fabs(expected[idx]);
+  }
+  qsort(steps, n, sizeof(float), cmp_float);
+  qsort(expected, n, sizeof(float), cmp_float);
+  cr_expect_float_eq(steps[n/2], expected[n/2], 0.05*expected[n/2],
+                     "median step %f should match rng_levy %f", steps[n/2], expected[n/2]);
+
+  free(uniforms);
+  free(steps);
+  free(expected);
+}
+
+Test(squirrel_unit, parallel_reproducible){
+  if(!__builtin_cpu_supports("avx2") || !__builtin_cpu_supports("fma")) {
+    cr_skip_test();
+  }
+  const size_t dim = 37;
+  float* first = squirrel_parallel(opt_simd_sum_of_squares, 200, dim, 300, -10, 10, 3);
+  float* second = squirrel_parallel(opt_simd_sum_of_squares, 200, dim, 300, -10, 10, 3);
+  cr_expect_eq(memcmp(first, second, dim*sizeof(float)), 0,
+               "runs on the same number of threads should be equal");
+  free(first);
+  free(second);
+}
@@ -1,3 +1,4 @@
+#include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <immintrin.h>
@@ -126,6 +127,86 @@ Test(utils_unit, mmm_rotation) {
 }
 
 
+Test(utils_unit, gemm) {
+  // sizes that leave partial register blocks and cross the blocks of `b`
+  const size_t sizes[][3] = {{1, 1, 1}, {7, 5, 3}, {13, 37, 150}, {4, 16, 8}, {9, 130, 70}};
+  for(size_t test = 0; test < sizeof(sizes) / sizeof(sizes[0]); test++) {
+    const size_t m = sizes[test][0], n = sizes[test][1], k = sizes[test][2];
+    float *a = (float *)malloc(m * k * sizeof(float));
+    float *b = (float *)malloc(k * n * sizeof(float));
+    float *res = (float *)malloc(m * n * sizeof(float));
+    float *simd_res = (float *)malloc(m * n * sizeof(float));
+    for(size_t idx = 0; idx < m * k; idx++) {
+      a[idx] = random_min_max(-1.0, 1.0);
+    }
+    for(size_t idx = 0; idx < k * n; idx++) {
+      b[idx] = random_min_max(-1.0, 1.0);
+    }
+    gemm(m, n, k, a, b, res);
+    simd_gemm(m, n, k, a, b, simd_res);
+    for(size_t row = 0; row < m; row++) {
+      for(size_t col = 0; col < n; col++) {
+        float expected = 0.0;
+        for(size_t runner = 0; runner < k; runner++) {
+          expected += a[row * k + runner] * b[runner * n + col];
+        }
+        cr_expect_float_eq(res[row * n + col], expected, 1e-4,
+                           "gemm entry [%ld, %ld] of test %ld", row, col, test);
+        cr_expect_float_eq(simd_res[row * n + col], expected, 1e-4,
+                           "simd_gemm entry [%ld, %ld] of test %ld", row, col, test);
+      }
+    }
+    free(a);
+    free(b);
+    free(res);
+    free(simd_res);
+  }
+}
+
+
+Test(utils_unit, transpose) {
+  float a[] = {1.0, 2.0, 3.0,
+               4.0, 5.0, 6.0};
+  float expected[] = {1.0, 4.0,
+                      2.0, 5.0,
+                      3.0, 6.0};
+  float res[6];
+  transpose(2, 3, a, res);
+  for(size_t idx = 0; idx < 6; idx++) {
+    cr_expect_float_eq(res[idx], expected[idx], FLT_EPSILON, "entry %ld should be transposed", idx);
+  }
+}
+
+
+Test(utils_unit, pairwise_distances) {
+  // 13 points leave a partial vector in every row
+  const size_t count = 13, dim = 7;
+  float points[count * dim], points_t[dim * count];
+  float distances[count * count], simd_distances[count * count];
+  for(size_t idx = 0; idx < count * dim; idx++) {
+    points[idx] = random_min_max(-5.0, 5.0);
+  }
+  pairwise_distances(count, dim, points, points_t, distances);
+  simd_pairwise_distances(count, dim, points, points_t, simd_distances);
+  for(size_t row = 0; row < count; row++) {
+    for(size_t col = 0; col < count; col++) {
+      float expected = 0.0;
+      for(size_t idx = 0; idx < dim; idx++) {
+        const float diff = points[row * dim + idx] - points[col * dim + idx];
+        expected += diff * diff;
+      }
+      expected = sqrtf(expected);
+      cr_expect_float_eq(distances[row * count + col], expected, 1e-3,
+                         "distance [%ld, %ld] should match", row, col);
+      cr_expect_float_eq(simd_distances[row * count + col], expected, 1e-3,
+                         "simd distance [%ld, %ld] should match", row, col);
+    }
+    cr_expect_eq(distances[row * count + row], 0.0, "distance of point %ld to itself", row);
+    cr_expect_eq(simd_distances[row * count + row], 0.0, "simd distance of point %ld to itself", row);
+  }
+}
+
+
 Test(utils_unit, mvm_zero) {
   size_t dim = 100;
   float* zeros = filled_float_array(dim, 0.0);
@@ -1,5 +1,6 @@
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 #include <math.h>
 
 #include <criterion/criterion.h>
@@ -30,17 +31,22 @@ void test_simd_algo(simd_obj_func_t obj_func, size_t pop_size, size_t dim,
                     float target, float tolerance,
                     bool debug, char* suite, char* test) {
   float* solution = (*algo)(obj_func, pop_size, dim, max_iter, min_bound, max_bound);
-  __m256 tmp[dim / 8];
-  for (size_t idx = 0; idx < dim / 8; idx++) {
-    tmp[idx] = _mm256_loadu_ps(&solution[idx * 8]);
+  // solution holds `dim` floats, load it into zero padded vectors
+  size_t simd_dim = (dim + 7) / 8;
+  float padded[simd_dim * 8];
+  memset(padded, 0, sizeof(padded));
+  memcpy(padded, solution, dim * sizeof(float));
+  __m256 tmp[simd_dim];
+  for (size_t idx = 0; idx < simd_dim; idx++) {
+    tmp[idx] = _mm256_loadu_ps(&padded[idx * 8]);
   }
   if(debug) {
     printf("%s -- %s\n  Best solution: ", suite, test);
     print_solution(dim, solution);
-    printf("  Objective function value = %f\n", (*obj_func)(tmp, dim / 8));
+    printf("  Objective function value = %f\n", (*obj_func)(tmp, dim));
     puts("--");
   }
-  cr_expect_float_eq((*obj_func)(tmp, dim / 8), target, tolerance,
+  cr_expect_float_eq((*obj_func)(tmp, dim), target, tolerance,
                      "objective should be minimised at %f", target);
   free(solution);
 }